@@ -322,7 +322,12 @@ static Agnode_t *pop(void)
     return *Stk.curp;
 }
 
-static int dfs(Agraph_t * g, Agnode_t * n, Agraph_t * out)
+/* dfs:
+ * Mark the nodes of the component of g containing n, and add them to out
+ * if it is non-NULL and store them in nodes if that is non-NULL.
+ * Return the number of nodes.
+ */
+static int dfs(Agraph_t * g, Agnode_t * n, Agraph_t * out, Agnode_t ** nodes)
 {
     Agedge_t *e;
     Agnode_t *other;
@@ -331,8 +336,11 @@ static int dfs(Agraph_t * g, Agnode_t * n, Agraph_t * out)
     push(n);
     while ((n = pop())) {
 	ND_mark(n) = 1;
+	if (nodes)
+	    nodes[cnt] = n;
 	cnt++;
-	agsubnode(out, n, 1);
+	if (out)
+	    agsubnode(out, n, 1);
 	for (e = agfstedge(g, n); e; e = agnxtedge(g, e, n)) {
 	    if ((other = agtail(e)) == n)
 		other = aghead(e);
@@ -672,7 +680,7 @@ static int processClusters(Agraph_t * g, char* graphName)
 	aginit(out, AGRAPH, "graphinfo", sizeof(Agraphinfo_t), TRUE);
 	GD_cc_subg(out) = 1;
 	dn = ND_dn(n);
-	n_cnt = dfs(dg, dn, dout);
+	n_cnt = dfs(dg, dn, dout, NULL);
 	unionNodes(dout, out);
 	if (doEdges)
 	    e_cnt = nodeInduce(out, out->root);
@@ -696,7 +704,7 @@ static int processClusters(Agraph_t * g, char* graphName)
 	out = agsubg(g, name, 1);
 	aginit(out, AGRAPH, "graphinfo", sizeof(Agraphinfo_t), TRUE);
 	GD_cc_subg(out) = 1;
-	n_cnt = dfs(dg, dn, dout);
+	n_cnt = dfs(dg, dn, dout, NULL);
 	unionNodes(dout, out);
 	if (doEdges)
 	    e_cnt = nodeInduce(out, out->root);
@@ -776,6 +784,8 @@ static int process(Agraph_t * g, char* graphName)
     char *name;
     Agraph_t *out;
     Agnode_t *n;
+    Agnode_t **nodes;
+    long i;
     int extracted = 0;
 
     aginit(g, AGNODE, "nodeinfo", sizeof(Agnodeinfo_t), TRUE);
@@ -798,7 +808,7 @@ static int process(Agraph_t * g, char* graphName)
 	out = agsubg(g, name, 1);
 	aginit(out, AGRAPH, "graphinfo", sizeof(Agraphinfo_t), TRUE);
 	GD_cc_subg(out) = 1;
-	n_cnt = dfs(g, n, out);
+	n_cnt = dfs(g, n, out, NULL);
 	if (doEdges)
 	    e_cnt = nodeInduce(out, out->root);
 	else
@@ -811,16 +821,35 @@ static int process(Agraph_t * g, char* graphName)
 	return 0;
     }
 
+    /* collect each component before deciding whether it needs a subgraph */
+    nodes = N_NEW(agnnodes(g), Agnode_t *);
     c_cnt = 0;
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (ND_mark(n))
 	    continue;
+	n_cnt = dfs(g, n, NULL, nodes);
+	if (printMode == SILENT || (printMode == EXTRACT &&
+	    (x_mode == BY_INDEX ? c_cnt < x_index :
+	     n_cnt < x_index || (x_final != -1 && n_cnt > x_final)))) {
+	    /* not written, so count its edges without building it */
+	    if (verbose) {
+		e_cnt = 0;
+		if (doEdges)
+		    for (i = 0; i < n_cnt; i++)
+			e_cnt += agdegree(g, nodes[i], FALSE, TRUE);
+		fprintf(stderr, "(%4ld) %7ld nodes %7ld edges\n",
+			c_cnt, n_cnt, e_cnt);
+	    }
+	    c_cnt++;
+	    continue;
+	}
 	name = getBuf(sizeof(PFX2) + strlen(graphName) + 32);
 	sprintf(name, PFX2, graphName, c_cnt);
 	out = agsubg(g, name, 1);
 	aginit(out, AGRAPH, "graphinfo", sizeof(Agraphinfo_t), TRUE);
 	GD_cc_subg(out) = 1;
-	n_cnt = dfs(g, n, out);
+	for (i = 0; i < n_cnt; i++)
+	    agsubnode(out, nodes[i], 1);
 	if (doEdges)
 	    e_cnt = nodeInduce(out, out->root);
 	else
@@ -836,8 +865,10 @@ static int process(Agraph_t * g, char* graphName)
 		    if (doAll)
 			subGInduce(g, out);
 		    gwrite(out);
-		    if (c_cnt == x_final)
+		    if (c_cnt == x_final) {
+			free(nodes);
 			return 0;
+		    }
 	        }
 	    }
 	    else if (x_mode == BY_SIZE) {
@@ -857,6 +888,7 @@ static int process(Agraph_t * g, char* graphName)
 		    c_cnt, n_cnt, e_cnt);
 	c_cnt++;
     }
+    free(nodes);
     if ((printMode == EXTRACT) && !extracted && (x_mode == BY_INDEX))  {
 	fprintf(stderr,
 		"ccomps: component %d not found in graph %s - ignored\n",
@@ -130,7 +130,9 @@ struct _dtstat_s
 #define DT_STACK	0000040	/* stack: insert/delete at top		*/
 #define DT_QUEUE	0000100	/* queue: insert at top, delete at tail	*/
 #define DT_DEQUE	0000200 /* deque: insert at top, append at tail	*/
-#define DT_METHODS	0000377	/* all currently supported methods	*/
+#define DT_OHASH	0000400	/* set in an open addressing hash table	*/
+#define DT_BTREE	0001000	/* ordered set in a B-tree		*/
+#define DT_METHODS	0001777	/* all currently supported methods	*/
 
 /* asserts to dtdisc() */
 #define DT_SAMECMP	0000001	/* compare methods equivalent		*/
@@ -169,6 +171,8 @@ CDT_API extern Dtmethod_t*	Dtlist;
 CDT_API extern Dtmethod_t*	Dtstack;
 CDT_API extern Dtmethod_t*	Dtqueue;
 CDT_API extern Dtmethod_t*	Dtdeque;
+CDT_API extern Dtmethod_t*	Dtohash;
+CDT_API extern Dtmethod_t*	Dtbtree;
 
 CDT_API extern Dtmethod_t*	Dtorder;
 CDT_API extern Dtmethod_t*	Dttree;
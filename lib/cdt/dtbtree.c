@@ -0,0 +1,494 @@
+#include	<cdt/dthdr.h>
+#include	<stddef.h>
+#include	<string.h>
+
+/*	Ordered set in a B-tree.
+**	Nodes hold up to BTMAX objects in order, so a search compares keys
+**	within a few nodes instead of following a pointer per comparison.
+**	All nodes live in one block at data->htab and refer to each other
+**	by index. The path to the finger is kept so that walking from it
+**	takes constant time on average.
+**	dt:	dictionary
+**	obj:	what to look for
+**	type:	type of search
+*/
+
+#define BTMAX		15		/* most objects in a node		*/
+#define BTMIN		(BTMAX/2)	/* fewest, except in the root		*/
+#define BTDEPTH		32		/* more than enough levels		*/
+
+typedef struct
+{	int		n;		/* number of objects, -1 if free	*/
+	int		kid[BTMAX+1];	/* subtrees, unused in leaves		*/
+	Dtlink_t*	link[BTMAX];	/* objects in order			*/
+} Btnode_t;
+
+typedef struct
+{	int		root;		/* root node or -1 if empty		*/
+	int		height;		/* number of levels			*/
+	int		nnode;		/* nodes in this block			*/
+	int		nfree;		/* nodes on the free list		*/
+	int		free;		/* free list, linked by kid[0]		*/
+	int		depth;		/* level of the finger or -1		*/
+	int		path[BTDEPTH];	/* nodes from the root down		*/
+	int		pos[BTDEPTH];	/* object or subtree taken in each	*/
+	Btnode_t	node[1];
+} Btree_t;
+
+#define BTREE(dt)	((Btree_t*)(dt)->data->htab)
+#define BTNODE(bt,d)	(&(bt)->node[(bt)->path[d]])
+
+/* make sure that need nodes are free, moving to a bigger block if not */
+static Btree_t* btreserve(Dt_t* dt, int need)
+{
+	Btree_t		*bt = BTREE(dt), *nbt;
+	int		n, nnode, i;
+
+	if(bt && bt->nfree >= need)
+		return bt;
+
+	n = bt ? bt->nnode : 0;
+	for(nnode = n > 0 ? 2*n : 1; nnode - n + (bt ? bt->nfree : 0) < need; nnode *= 2)
+		;
+	nbt = (Btree_t*)(*dt->memoryf)
+		(dt,NULL,sizeof(Btree_t)+(nnode-1)*sizeof(Btnode_t),dt->disc);
+	if(!nbt)
+		return NULL;
+	if(bt)
+	{	memcpy(nbt,bt,sizeof(Btree_t)+(n-1)*sizeof(Btnode_t));
+		(*dt->memoryf)(dt,(void*)bt,0,dt->disc);
+	}
+	else
+	{	nbt->root = -1;
+		nbt->height = 0;
+		nbt->nfree = 0;
+		nbt->free = -1;
+		nbt->depth = -1;
+	}
+	for(i = nnode-1; i >= n; --i)
+	{	nbt->node[i].n = -1;
+		nbt->node[i].kid[0] = nbt->free;
+		nbt->free = i;
+		nbt->nfree += 1;
+	}
+	nbt->nnode = nnode;
+
+	dt->data->htab = (Dtlink_t**)nbt;
+	dt->data->ntab = nnode;
+	return nbt;
+}
+
+static int btget(Btree_t* bt)
+{
+	int	x = bt->free;
+
+	bt->free = bt->node[x].kid[0];
+	bt->nfree -= 1;
+	bt->node[x].n = 0;
+	return x;
+}
+
+static void btput(Btree_t* bt, int x)
+{
+	bt->node[x].n = -1;
+	bt->node[x].kid[0] = bt->free;
+	bt->free = x;
+	bt->nfree += 1;
+}
+
+/* look for key, leaving the path to it or to the leaf gap where it would go.
+** return the level where it was found or -1. */
+static int btsearch(Dt_t* dt, Btree_t* bt, void* key)
+{
+	Btnode_t	*nd;
+	void		*k;
+	int		lk, sz, ky, cmp, d, x, lo, hi, mid;
+	Dtcompar_f	cmpf;
+	Dtdisc_t*	disc = dt->disc;
+
+	_DTDSC(disc,ky,sz,lk,cmpf);
+	bt->depth = -1;
+	if((x = bt->root) < 0)
+		return -1;
+
+	for(d = 0;; ++d)
+	{	nd = &bt->node[x];
+		for(lo = 0, hi = nd->n; lo < hi; )
+		{	mid = (lo+hi)/2;
+			k = _DTOBJ(nd->link[mid],lk); k = _DTKEY(k,ky,sz);
+			if((cmp = _DTCMP(dt,key,k,disc,cmpf,sz)) == 0)
+			{	bt->path[d] = x;
+				bt->pos[d] = mid;
+				return (bt->depth = d);
+			}
+			else if(cmp < 0)
+				hi = mid;
+			else	lo = mid+1;
+		}
+		bt->path[d] = x;
+		bt->pos[d] = lo;
+		if(d == bt->height-1)
+			return -1;
+		x = nd->kid[lo];
+	}
+}
+
+/* go down to the first or last object of subtree pos[d] at level d */
+static Dtlink_t* btdown(Btree_t* bt, int d, int last)
+{
+	Btnode_t	*nd;
+
+	for(; d < bt->height-1; ++d)
+	{	bt->path[d+1] = BTNODE(bt,d)->kid[bt->pos[d]];
+		nd = BTNODE(bt,d+1);
+		bt->pos[d+1] = last ? nd->n : 0;
+	}
+	nd = BTNODE(bt,d);
+	if(last)
+		bt->pos[d] = nd->n-1;
+	bt->depth = d;
+	return nd->link[bt->pos[d]];
+}
+
+/* the object after, or before, the gap pos[d] at level d */
+static Dtlink_t* btnextgap(Btree_t* bt, int d)
+{
+	for(; d >= 0; --d)
+	{	if(bt->pos[d] < BTNODE(bt,d)->n)
+		{	bt->depth = d;
+			return BTNODE(bt,d)->link[bt->pos[d]];
+		}
+	}
+	bt->depth = -1;
+	return NULL;
+}
+
+static Dtlink_t* btprevgap(Btree_t* bt, int d)
+{
+	for(; d >= 0; --d)
+	{	if(bt->pos[d] > 0)
+		{	bt->pos[d] -= 1;
+			bt->depth = d;
+			return BTNODE(bt,d)->link[bt->pos[d]];
+		}
+	}
+	bt->depth = -1;
+	return NULL;
+}
+
+/* add r at the leaf gap left by btsearch(), splitting full nodes upward */
+static int btinsert(Dt_t* dt, Dtlink_t* r)
+{
+	Btree_t		*bt = BTREE(dt);
+	Btnode_t	*nd, *rt;
+	Dtlink_t	*up, *link[BTMAX+1];
+	int		kid[BTMAX+2];
+	int		d, i, x, right, need;
+
+	/* count the nodes to be made */
+	if(!bt || bt->root < 0)
+		need = 1;
+	else
+	{	for(need = 0, d = bt->height-1; d >= 0 && BTNODE(bt,d)->n == BTMAX; --d)
+			need += 1;
+		if(d < 0)
+			need += 1;
+	}
+	if(need > 0 && !(bt = btreserve(dt,need)) )
+		return -1;
+
+	if(bt->root < 0)
+	{	x = btget(bt);
+		bt->node[x].n = 1;
+		bt->node[x].link[0] = r;
+		bt->root = x;
+		bt->height = 1;
+		bt->path[0] = x;
+		bt->pos[0] = 0;
+		bt->depth = 0;
+		return 0;
+	}
+
+	up = r;
+	right = -1;
+	for(d = bt->height-1; d >= 0; --d)
+	{	nd = BTNODE(bt,d);
+		i = bt->pos[d];
+		if(nd->n < BTMAX)
+		{	memmove(nd->link+i+1,nd->link+i,(nd->n-i)*sizeof(Dtlink_t*));
+			memmove(nd->kid+i+2,nd->kid+i+1,(nd->n-i)*sizeof(int));
+			nd->link[i] = up;
+			nd->kid[i+1] = right;
+			nd->n += 1;
+			break;
+		}
+
+		/* split a full node around its middle object */
+		memcpy(link,nd->link,i*sizeof(Dtlink_t*));
+		link[i] = up;
+		memcpy(link+i+1,nd->link+i,(BTMAX-i)*sizeof(Dtlink_t*));
+		memcpy(kid,nd->kid,(i+1)*sizeof(int));
+		kid[i+1] = right;
+		memcpy(kid+i+2,nd->kid+i+1,(BTMAX-i)*sizeof(int));
+
+		x = btget(bt);
+		rt = &bt->node[x];
+		nd->n = BTMIN;
+		memcpy(nd->link,link,BTMIN*sizeof(Dtlink_t*));
+		memcpy(nd->kid,kid,(BTMIN+1)*sizeof(int));
+		rt->n = BTMAX-BTMIN;
+		memcpy(rt->link,link+BTMIN+1,rt->n*sizeof(Dtlink_t*));
+		memcpy(rt->kid,kid+BTMIN+1,(rt->n+1)*sizeof(int));
+		up = link[BTMIN];
+		right = x;
+	}
+
+	if(d < 0)	/* grow a new root */
+	{	x = btget(bt);
+		nd = &bt->node[x];
+		nd->n = 1;
+		nd->link[0] = up;
+		nd->kid[0] = bt->root;
+		nd->kid[1] = right;
+		bt->root = x;
+		bt->height += 1;
+	}
+
+	/* the finger is still good unless a node was split */
+	bt->depth = d == bt->height-1 ? d : -1;
+	return 0;
+}
+
+/* remove the object at the finger, refilling nodes that get too small */
+static void btdelete(Btree_t* bt)
+{
+	Btnode_t	*nd, *pa, *lt, *rt;
+	int		d, i, ci, leaf = bt->height-1;
+
+	if((d = bt->depth) < leaf)
+	{	/* replace it by its predecessor, which is in a leaf */
+		i = bt->pos[d];
+		nd = BTNODE(bt,d);
+		nd->link[i] = btdown(bt,d,1);
+	}
+	nd = BTNODE(bt,leaf);
+	i = bt->pos[leaf];
+	memmove(nd->link+i,nd->link+i+1,(nd->n-i-1)*sizeof(Dtlink_t*));
+	nd->n -= 1;
+
+	for(d = leaf; d > 0 && (nd = BTNODE(bt,d))->n < BTMIN; --d)
+	{	pa = BTNODE(bt,d-1);
+		ci = bt->pos[d-1];
+		if(ci > 0 && (lt = &bt->node[pa->kid[ci-1]])->n > BTMIN)
+		{	/* borrow from the left sibling */
+			memmove(nd->link+1,nd->link,nd->n*sizeof(Dtlink_t*));
+			memmove(nd->kid+1,nd->kid,(nd->n+1)*sizeof(int));
+			nd->link[0] = pa->link[ci-1];
+			nd->kid[0] = lt->kid[lt->n];
+			pa->link[ci-1] = lt->link[lt->n-1];
+			lt->n -= 1;
+			nd->n += 1;
+			break;
+		}
+		if(ci < pa->n && (rt = &bt->node[pa->kid[ci+1]])->n > BTMIN)
+		{	/* borrow from the right sibling */
+			nd->link[nd->n] = pa->link[ci];
+			nd->kid[nd->n+1] = rt->kid[0];
+			pa->link[ci] = rt->link[0];
+			memmove(rt->link,rt->link+1,(rt->n-1)*sizeof(Dtlink_t*));
+			memmove(rt->kid,rt->kid+1,rt->n*sizeof(int));
+			rt->n -= 1;
+			nd->n += 1;
+			break;
+		}
+
+		/* merge with a sibling and the object between them */
+		if(ci > 0)
+			ci -= 1;
+		lt = &bt->node[pa->kid[ci]];
+		rt = &bt->node[pa->kid[ci+1]];
+		lt->link[lt->n] = pa->link[ci];
+		memcpy(lt->link+lt->n+1,rt->link,rt->n*sizeof(Dtlink_t*));
+		memcpy(lt->kid+lt->n+1,rt->kid,(rt->n+1)*sizeof(int));
+		lt->n += rt->n+1;
+		btput(bt,pa->kid[ci+1]);
+		memmove(pa->link+ci,pa->link+ci+1,(pa->n-ci-1)*sizeof(Dtlink_t*));
+		memmove(pa->kid+ci+1,pa->kid+ci+2,(pa->n-ci-1)*sizeof(int));
+		pa->n -= 1;
+	}
+
+	if(bt->node[bt->root].n == 0)	/* shrink the tree */
+	{	i = bt->root;
+		if(bt->height > 1)
+			bt->root = bt->node[i].kid[0];
+		else	bt->root = -1;
+		bt->height -= 1;
+		btput(bt,i);
+	}
+	bt->depth = -1;
+}
+
+static void* dtbtree(Dt_t* dt, void* obj, int type)
+{
+	Dtlink_t	*t, *r = NULL;
+	void		*key;
+	int		lk, sz, ky, d, x, i;
+	Dtcompar_f	cmpf;
+	Dtdisc_t*	disc;
+	Btree_t*	bt;
+	Btnode_t*	nd;
+	NOTUSED(cmpf);
+
+	UNFLATTEN(dt);
+	disc = dt->disc; _DTDSC(disc,ky,sz,lk,cmpf);
+	dt->type &= ~DT_FOUND;
+	bt = BTREE(dt);
+
+	if(!obj)
+	{	if(!bt || bt->root < 0 || !(type&(DT_CLEAR|DT_FIRST|DT_LAST)) )
+			return NULL;
+
+		if(type&DT_CLEAR) /* delete all objects */
+		{	if(disc->freef || lk < 0)
+			{	for(x = 0; x < bt->nnode; ++x)
+				{	nd = &bt->node[x];
+					for(i = 0; i < nd->n; ++i)
+					{	if(disc->freef)
+							(*disc->freef)(dt,_DTOBJ(nd->link[i],lk),disc);
+						if(lk < 0)
+							(*dt->memoryf)(dt,(void*)nd->link[i],0,disc);
+					}
+				}
+			}
+			bt->root = -1;
+			bt->height = 0;
+			bt->depth = -1;
+			bt->free = -1;
+			bt->nfree = 0;
+			for(x = bt->nnode-1; x >= 0; --x)
+				btput(bt,x);
+
+			dt->data->size = 0;
+			dt->data->here = NULL;
+			return NULL;
+		}
+		else /* computing largest/smallest element */
+		{	bt->path[0] = bt->root;
+			bt->pos[0] = (type&DT_LAST) ? bt->node[bt->root].n : 0;
+			t = btdown(bt,0,(type&DT_LAST) != 0);
+			goto has_link;
+		}
+	}
+
+	if(type&(DT_MATCH|DT_SEARCH|DT_INSERT|DT_ATTACH))
+		key = (type&DT_MATCH) ? obj : _DTKEY(obj,ky,sz);
+	else if(type&DT_RENEW)
+	{	r = (Dtlink_t*)obj;
+		obj = _DTOBJ(r,lk);
+		key = _DTKEY(obj,ky,sz);
+	}
+	else /*if(type&(DT_DELETE|DT_DETACH|DT_NEXT|DT_PREV))*/
+	{	/* walks and deletions usually start from the finger */
+		if((t = dt->data->here) && _DTOBJ(t,lk) == obj &&
+		   bt && (d = bt->depth) >= 0 && bt->pos[d] < BTNODE(bt,d)->n &&
+		   BTNODE(bt,d)->link[bt->pos[d]] == t)
+			goto found;
+		key = _DTKEY(obj,ky,sz);
+	}
+
+	if(bt && btsearch(dt,bt,key) >= 0)
+	{ found:
+		dt->type |= DT_FOUND;
+		d = bt->depth;
+		t = BTNODE(bt,d)->link[bt->pos[d]];
+
+		if(type&(DT_SEARCH|DT_MATCH|DT_INSERT|DT_ATTACH))
+			goto has_link;
+		else if(type&DT_NEXT)
+		{	bt->pos[d] += 1;
+			if(d < bt->height-1)
+				t = btdown(bt,d,0);
+			else	t = btnextgap(bt,d);
+			goto has_link;
+		}
+		else if(type&DT_PREV)
+		{	if(d < bt->height-1)
+				t = btdown(bt,d,1);
+			else	t = btprevgap(bt,d);
+			goto has_link;
+		}
+		else if(type&DT_RENEW) /* a duplicate */
+		{	if(disc->freef)
+				(*disc->freef)(dt,obj,disc);
+			if(lk < 0)
+				(*dt->memoryf)(dt,(void*)r,0,disc);
+			goto has_link;
+		}
+		else /*if(type&(DT_DELETE|DT_DETACH))*/
+		{	btdelete(bt);
+			obj = _DTOBJ(t,lk);
+			dt->data->size -= 1;
+			dt->data->here = NULL;
+			if(disc->freef && (type&DT_DELETE))
+				(*disc->freef)(dt,obj,disc);
+			if(lk < 0)
+				(*dt->memoryf)(dt,(void*)t,0,disc);
+			return obj;
+		}
+	}
+
+	/* not found */
+	if(type&(DT_NEXT|DT_PREV))
+	{	if(!bt || bt->root < 0)
+			t = NULL;
+		else if(type&DT_NEXT)
+			t = btnextgap(bt,bt->height-1);
+		else	t = btprevgap(bt,bt->height-1);
+		goto has_link;
+	}
+	else if(type&(DT_INSERT|DT_ATTACH))
+	{	if(disc->makef && (type&DT_INSERT) &&
+		   !(obj = (*disc->makef)(dt,obj,disc)) )
+			return NULL;
+		if(lk >= 0)
+			r = _DTLNK(obj,lk);
+		else
+		{	r = (Dtlink_t*)(*dt->memoryf)
+				(dt,NULL,sizeof(Dthold_t),disc);
+			if(r)
+				((Dthold_t*)r)->obj = obj;
+			else
+			{	if(disc->makef && disc->freef && (type&DT_INSERT))
+					(*disc->freef)(dt,obj,disc);
+				return NULL;
+			}
+		}
+		goto do_insert;
+	}
+	else if(type&DT_RENEW)
+	{ do_insert:
+		if(btinsert(dt,r) < 0)
+		{	if(disc->freef && (type&DT_INSERT))
+				(*disc->freef)(dt,obj,disc);
+			if(lk < 0)
+				(*dt->memoryf)(dt,(void*)r,0,disc);
+			return NULL;
+		}
+		bt = BTREE(dt);
+		if(bt->depth < 0) /* put the finger back on it */
+			(void)btsearch(dt,bt,key);
+		dt->data->size += 1;
+		t = r;
+		goto has_link;
+	}
+	else /*if(type&(DT_SEARCH|DT_MATCH|DT_DELETE|DT_DETACH))*/
+		return NULL;
+
+has_link:
+	if(!(dt->data->here = t) )
+		return NULL;
+	return _DTOBJ(t,lk);
+}
+
+static Dtmethod_t	_Dtbtree = { dtbtree, DT_BTREE };
+Dtmethod_t* Dtbtree = &_Dtbtree;
@@ -57,12 +57,12 @@ Dtdisc_t* dtdisc(Dt_t* dt, Dtdisc_t* disc, int type)
 			goto done;
 		else	goto dt_renew;
 	}
-	else if(dt->data->type&(DT_SET|DT_BAG))
+	else if(dt->data->type&(DT_SET|DT_BAG|DT_OHASH))
 	{	if((type&DT_SAMEHASH) && (type&DT_SAMECMP))
 			goto done;
 		else	goto dt_renew;
 	}
-	else /*if(dt->data->type&(DT_OSET|DT_OBAG))*/
+	else /*if(dt->data->type&(DT_OSET|DT_OBAG|DT_BTREE))*/
 	{	if(type&DT_SAMECMP)
 			goto done;
 	dt_renew:
@@ -77,6 +77,12 @@ Dtdisc_t* dtdisc(Dt_t* dt, Dtdisc_t* disc, int type)
 			while(s < ends)
 				*s++ = NULL;
 		}
+		else if(dt->data->type&(DT_OHASH|DT_BTREE))
+		{	if(dt->data->ntab > 0)
+				(*dt->memoryf)(dt,(void*)dt->data->htab,0,disc);
+			dt->data->ntab = 0;
+			dt->data->htab = NULL;
+		}
 
 		/* reinsert them */
 		while(r)
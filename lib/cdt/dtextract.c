@@ -17,6 +17,13 @@ Dtlink_t* dtextract(Dt_t* dt)
 		for(ends = (s = dt->data->htab) + dt->data->ntab; s < ends; ++s)
 			*s = NULL;
 	}
+	else if(dt->data->type&(DT_OHASH|DT_BTREE))
+	{	list = dtflatten(dt);
+		if(dt->data->ntab > 0)
+			(*dt->memoryf)(dt,(void*)dt->data->htab,0,dt->disc);
+		dt->data->ntab = 0;
+		dt->data->htab = NULL;
+	}
 	else /*if(dt->data->type&(DT_LIST|DT_STACK|DT_QUEUE))*/
 	{	list = dt->data->head;
 		dt->data->head = NULL;
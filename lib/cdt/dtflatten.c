@@ -30,6 +30,21 @@ Dtlink_t* dtflatten(Dt_t* dt)
 	}
 	else if(dt->data->type&(DT_LIST|DT_STACK|DT_QUEUE) )
 		list = dt->data->head;
+	else if(dt->data->type&(DT_OHASH|DT_BTREE))
+	{	/* these methods do not use the right links, so chain them */
+		Dtsearch_f	searchf = dt->meth->searchf;
+		void*		obj;
+
+		for(obj = (*searchf)(dt,NULL,DT_FIRST); obj; obj = (*searchf)(dt,obj,DT_NEXT))
+		{	t = dt->data->here;
+			if(last)
+				last->right = t;
+			else	list = t;
+			last = t;
+		}
+		if(last)
+			last->right = NULL;
+	}
 	else if((r = dt->data->here) ) /*if(dt->data->type&(DT_OSET|DT_OBAG))*/
 	{	while((t = r->left) )
 			RROTATE(r,t);
@@ -26,7 +26,7 @@ Dtmethod_t* dtmethod(Dt_t* dt, Dtmethod_t* meth)
 
 	if(dt->data->type&(DT_LIST|DT_STACK|DT_QUEUE) )
 		dt->data->head = NULL;
-	else if(dt->data->type&(DT_SET|DT_BAG) )
+	else if(dt->data->type&(DT_SET|DT_BAG|DT_OHASH|DT_BTREE) )
 	{	if(dt->data->ntab > 0)
 			(*dt->memoryf)(dt,(void*)dt->data->htab,0,disc);
 		dt->data->ntab = 0;
@@ -50,7 +50,7 @@ Dtmethod_t* dtmethod(Dt_t* dt, Dtmethod_t* meth)
 		}
 		dt->data->head = list;
 	}
-	else if(meth->type&(DT_OSET|DT_OBAG))
+	else if(meth->type&(DT_OSET|DT_OBAG|DT_BTREE))
 	{	dt->data->size = 0;
 		while(list)
 		{	r = list->right;
@@ -60,7 +60,8 @@ Dtmethod_t* dtmethod(Dt_t* dt, Dtmethod_t* meth)
 	}
 	else if(!((meth->type&DT_BAG) && (oldmeth->type&DT_SET)) )
 	{	int	rehash;
-		if((meth->type&(DT_SET|DT_BAG)) && !(oldmeth->type&(DT_SET|DT_BAG)))
+		if((meth->type&(DT_SET|DT_BAG|DT_OHASH)) &&
+		   !(oldmeth->type&(DT_SET|DT_BAG|DT_OHASH)) )
 			rehash = 1;
 		else	rehash = 0;
 
@@ -0,0 +1,312 @@
+#include	<cdt/dthdr.h>
+#include	<stddef.h>
+
+/*	Hash table with open addressing.
+**	Each slot holds an object with its hash value, so a search scans
+**	adjacent slots and only compares keys when the hash values agree.
+**	A deleted object leaves a marker in its slot until the table is
+**	rebuilt, so that walks are not disturbed by deletions.
+**	dt:	dictionary
+**	obj:	what to look for
+**	type:	type of search
+*/
+
+typedef struct
+{	uint		code;	/* hash value of the object		*/
+	Dtlink_t*	link;	/* the object, NULL or DELETED		*/
+} Dtslot_t;
+
+typedef struct
+{	int		ndel;	/* number of DELETED slots		*/
+	int		hpos;	/* slot of data->here, if known		*/
+	Dtslot_t	slot[1];
+} Dtotab_t;
+
+static Dtlink_t	Deleted;
+#define DELETED		(&Deleted)
+#define LIVE(t)		((t) && (t) != DELETED)
+
+#define OTAB(dt)	((Dtotab_t*)(dt)->data->htab)
+#define OSLOT		(8)			/* smallest table	*/
+#define OLOAD(n)	((n) - ((n) >> 2))	/* fill before growing	*/
+#define OFULL(n)	((n) - ((n) >> 3))	/* same, during a walk	*/
+#define ONEXT(n,i)	(((i)+1) & ((n)-1))
+
+/* mix the bits of a hash value, so that hash functions that only vary
+** in their high bits, or that give runs of values, still spread out */
+static int ohindex(uint h, int n)
+{
+	h ^= h >> 16;
+	h *= 0x45d9f3bU;
+	h ^= h >> 16;
+	return (int)(h & (uint)(n-1));
+}
+
+/* rebuild the table with room for need objects, dropping deleted slots */
+static int ohtab(Dt_t* dt, int need)
+{
+	Dtotab_t	*old, *tab;
+	int		n, i, k;
+
+	for(n = OSLOT; OLOAD(n) < 2*need; n <<= 1)
+		;
+	tab = (Dtotab_t*)(*dt->memoryf)
+		(dt,NULL,sizeof(Dtotab_t)+(n-1)*sizeof(Dtslot_t),dt->disc);
+	if(!tab)
+		return -1;
+	tab->ndel = 0;
+	tab->hpos = -1;
+	for(i = 0; i < n; ++i)
+		tab->slot[i].link = NULL;
+
+	if((old = OTAB(dt)) )
+	{	for(i = 0; i < dt->data->ntab; ++i)
+		{	if(!LIVE(old->slot[i].link))
+				continue;
+			for(k = ohindex(old->slot[i].code,n); tab->slot[k].link; k = ONEXT(n,k))
+				;
+			tab->slot[k] = old->slot[i];
+		}
+		(*dt->memoryf)(dt,(void*)old,0,dt->disc);
+	}
+
+	dt->data->htab = (Dtlink_t**)tab;
+	dt->data->ntab = n;
+	return 0;
+}
+
+/* find the slot holding t */
+static int ohfind(Dt_t* dt, Dtlink_t* t)
+{
+	Dtotab_t	*tab = OTAB(dt);
+	int		n = dt->data->ntab, k;
+
+	if(tab->hpos >= 0 && tab->slot[tab->hpos].link == t)
+		return tab->hpos;
+	for(k = ohindex(t->hash,n); tab->slot[k].link; k = ONEXT(n,k))
+		if(tab->slot[k].link == t)
+			return k;
+	return -1;
+}
+
+static void* dtohash(Dt_t* dt, void* obj, int type)
+{
+	Dtlink_t	*t, *r = NULL;
+	void		*k, *key;
+	uint		hsh = 0;
+	int		lk, sz, ky, n, pos, del, i = 0;
+	Dtcompar_f	cmpf;
+	Dtdisc_t*	disc;
+	Dtotab_t*	tab;
+
+	UNFLATTEN(dt);
+
+	/* initialize discipline data */
+	disc = dt->disc; _DTDSC(disc,ky,sz,lk,cmpf);
+	dt->type &= ~DT_FOUND;
+	tab = OTAB(dt);
+	n = dt->data->ntab;
+
+	if(!obj)
+	{	if(type&(DT_NEXT|DT_PREV))
+			goto end_walk;
+
+		if(dt->data->size <= 0 || !(type&(DT_CLEAR|DT_FIRST|DT_LAST)) )
+			return NULL;
+
+		if(type&DT_CLEAR)
+		{	/* clean out all objects */
+			for(i = 0; i < n; ++i)
+			{	t = tab->slot[i].link;
+				tab->slot[i].link = NULL;
+				if(!LIVE(t))
+					continue;
+				if(disc->freef)
+					(*disc->freef)(dt,_DTOBJ(t,lk),disc);
+				if(lk < 0)
+					(*dt->memoryf)(dt,(void*)t,0,disc);
+			}
+			tab->ndel = 0;
+			tab->hpos = -1;
+			dt->data->here = NULL;
+			dt->data->size = 0;
+			dt->data->loop = 0;
+			return NULL;
+		}
+		else	/* computing the first/last object */
+		{	if(type&DT_LAST)
+				for(pos = n-1; !LIVE(tab->slot[pos].link); --pos)
+					;
+			else	for(pos = 0; !LIVE(tab->slot[pos].link); ++pos)
+					;
+			dt->data->loop += 1;
+			goto has_pos;
+		}
+	}
+
+	if(type&(DT_MATCH|DT_SEARCH|DT_INSERT|DT_ATTACH) )
+	{	key = (type&DT_MATCH) ? obj : _DTKEY(obj,ky,sz);
+		hsh = _DTHSH(dt,key,disc,sz);
+	}
+	else if(type&(DT_RENEW|DT_VSEARCH) )
+	{	r = (Dtlink_t*)obj;
+		obj = _DTOBJ(r,lk);
+		key = _DTKEY(obj,ky,sz);
+		hsh = r->hash;
+	}
+	else /*if(type&(DT_DELETE|DT_DETACH|DT_NEXT|DT_PREV))*/
+	{	if((t = dt->data->here) && _DTOBJ(t,lk) == obj &&
+		   (pos = ohfind(dt,t)) >= 0)
+		{	del = -1;
+			goto found;
+		}
+		key = _DTKEY(obj,ky,sz);
+		hsh = _DTHSH(dt,key,disc,sz);
+	}
+
+	/* probe, noting the first deleted slot as a place to insert */
+	pos = del = -1;
+	if(n > 0)
+	{	for(i = ohindex(hsh,n); (t = tab->slot[i].link); i = ONEXT(n,i))
+		{	if(t == DELETED)
+			{	if(del < 0)
+					del = i;
+			}
+			else if(tab->slot[i].code == hsh)
+			{	k = _DTOBJ(t,lk); k = _DTKEY(k,ky,sz);
+				if(_DTCMP(dt,key,k,disc,cmpf,sz) == 0)
+				{	pos = i;
+					break;
+				}
+			}
+		}
+	}
+	if(pos >= 0)
+	{ found: /* found matching object */
+		dt->type |= DT_FOUND;
+		t = tab->slot[pos].link;
+	}
+	else	t = NULL;
+
+	if(type&(DT_MATCH|DT_SEARCH|DT_VSEARCH))
+	{	if(!t)
+			return NULL;
+		goto has_pos;
+	}
+	else if(type&(DT_INSERT|DT_ATTACH))
+	{	if(t)
+			goto has_pos;
+
+		if(disc->makef && (type&DT_INSERT) &&
+		   !(obj = (*disc->makef)(dt,obj,disc)) )
+			return NULL;
+		if(lk >= 0)
+			r = _DTLNK(obj,lk);
+		else
+		{	r = (Dtlink_t*)(*dt->memoryf)
+				(dt,NULL,sizeof(Dthold_t),disc);
+			if(r)
+				((Dthold_t*)r)->obj = obj;
+			else
+			{	if(disc->makef && disc->freef && (type&DT_INSERT))
+					(*disc->freef)(dt,obj,disc);
+				return NULL;
+			}
+		}
+		r->hash = hsh;
+
+		/* insert object */
+	do_insert:
+		if(del < 0 &&
+		   dt->data->size + (n > 0 ? tab->ndel : 0) + 1 >
+		   (dt->data->loop > 0 ? OFULL(n) : OLOAD(n)) )
+		{	if(ohtab(dt,dt->data->size+1) < 0)
+			{	if(disc->freef && (type&DT_INSERT))
+					(*disc->freef)(dt,obj,disc);
+				if(lk < 0)
+					(*dt->memoryf)(dt,(void*)r,0,disc);
+				return NULL;
+			}
+			tab = OTAB(dt);
+			n = dt->data->ntab;
+			for(i = ohindex(hsh,n); tab->slot[i].link; i = ONEXT(n,i))
+				;
+		}
+		if(del >= 0)
+		{	pos = del;
+			tab->ndel -= 1;
+		}
+		else	pos = i;
+		tab->slot[pos].code = hsh;
+		tab->slot[pos].link = r;
+		dt->data->size += 1;
+		dt->data->here = r;
+		tab->hpos = pos;
+		return obj;
+	}
+	else if(type&DT_NEXT)
+	{	if(t)
+			for(pos += 1; pos < n && !LIVE(tab->slot[pos].link); ++pos)
+				;
+		if(!t || pos >= n)
+			goto end_walk;
+		goto has_pos;
+	}
+	else if(type&DT_PREV)
+	{	if(t)
+			for(pos -= 1; pos >= 0 && !LIVE(tab->slot[pos].link); --pos)
+				;
+		if(!t || pos < 0)
+		{ end_walk:
+			if((dt->data->loop -= 1) < 0)
+				dt->data->loop = 0;
+			dt->data->here = NULL;
+			return NULL;
+		}
+		goto has_pos;
+	}
+	else if(type&DT_RENEW)
+	{	if(!t)
+			goto do_insert;
+		if(disc->freef)
+			(*disc->freef)(dt,obj,disc);
+		if(lk < 0)
+			(*dt->memoryf)(dt,(void*)r,0,disc);
+		goto has_pos;
+	}
+	else /*if(type&(DT_DELETE|DT_DETACH))*/
+	{	/* take an element out of the dictionary */
+		if(!t)
+			return NULL;
+		if(!tab->slot[ONEXT(n,pos)].link)
+		{	/* end of a probe sequence, so deleted slots before it
+			** are no longer needed either */
+			tab->slot[pos].link = NULL;
+			for(i = (pos-1) & (n-1); tab->slot[i].link == DELETED; i = (i-1) & (n-1))
+			{	tab->slot[i].link = NULL;
+				tab->ndel -= 1;
+			}
+		}
+		else
+		{	tab->slot[pos].link = DELETED;
+			tab->ndel += 1;
+		}
+		obj = _DTOBJ(t,lk);
+		dt->data->size -= 1;
+		dt->data->here = NULL;
+		tab->hpos = -1;
+		if(disc->freef && (type&DT_DELETE))
+			(*disc->freef)(dt,obj,disc);
+		if(lk < 0)
+			(*dt->memoryf)(dt,(void*)t,0,disc);
+		return obj;
+	}
+
+has_pos:
+	dt->data->here = t = tab->slot[pos].link;
+	tab->hpos = pos;
+	return _DTOBJ(t,lk);
+}
+
+static Dtmethod_t	_Dtohash = { dtohash, DT_OHASH };
+Dtmethod_t* Dtohash = &_Dtohash;
@@ -19,6 +19,16 @@ void* dtrenew(Dt_t* dt, void* obj)
 
 	if(dt->data->type&(DT_STACK|DT_QUEUE|DT_LIST))
 		return obj;
+	else if(dt->data->type&(DT_OHASH|DT_BTREE))
+	{	/* the finger lets these find the object by its old key */
+		if((*dt->meth->searchf)(dt,obj,DT_DETACH) != obj)
+			return NULL;
+		if((*dt->meth->searchf)(dt,obj,DT_ATTACH) == obj)
+			return obj;
+		if(disc->freef) /* a duplicate */
+			(*disc->freef)(dt,obj,disc);
+		return NULL;
+	}
 	else if(dt->data->type&(DT_OSET|DT_OBAG) )
 	{	if(!e->right )	/* make left child the new root */
 			dt->data->here = e->left;
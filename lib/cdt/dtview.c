@@ -20,7 +20,8 @@ static void* dtvsearch(Dt_t* dt, void* obj, int type)
 		return (*(dt->meth->searchf))(dt,obj,type);
 
 	if((type&(DT_MATCH|DT_SEARCH)) || /* order sets first/last done below */
-	   ((type&(DT_FIRST|DT_LAST)) && !(dt->meth->type&(DT_OBAG|DT_OSET)) ) )
+	   ((type&(DT_FIRST|DT_LAST)) &&
+	    !(dt->meth->type&(DT_OBAG|DT_OSET|DT_BTREE)) ) )
 	{	for(d = dt; d; d = d->view)
 			if((o = (*(d->meth->searchf))(d,obj,type)) )
 				break;
@@ -28,7 +29,7 @@ static void* dtvsearch(Dt_t* dt, void* obj, int type)
 		return o;
 	}
 
-	if(dt->meth->type & (DT_OBAG|DT_OSET) )
+	if(dt->meth->type & (DT_OBAG|DT_OSET|DT_BTREE) )
 	{	if(!(type & (DT_FIRST|DT_LAST|DT_NEXT|DT_PREV)) )
 			return NULL;
 
@@ -174,6 +174,20 @@ static int topdictsize(Agobj_t * obj)
     return d ? dtsize(d) : 0;
 }
 
+/* attrcapacity:
+ * Number of slots allocated for an object's values when the dictionary
+ * holds n attributes: the next power of two, so that declaring attributes
+ * one at a time only reallocates each object's array log(n) times.
+ */
+static int attrcapacity(int n)
+{
+    int sz = MINATTR;		/* don't malloc(0) */
+
+    while (sz < n)
+	sz *= 2;
+    return sz;
+}
+
 /* g can be either the enclosing graph, or ProtoGraph */
 static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 {
@@ -187,14 +201,12 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
     assert(datadict);
     if (rec->dict == NULL) {
 	rec->dict = agdictof(agroot(context), AGTYPE(obj));
-	/* don't malloc(0) */
-	sz = topdictsize(obj);
-	if (sz < MINATTR)
-	    sz = MINATTR;
+	sz = attrcapacity(topdictsize(obj));
 	rec->str = agalloc(agraphof(obj), (size_t) sz * sizeof(char *));
-	/* doesn't call agxset() so no obj-modified callbacks occur */
+	/* doesn't call agxset() so no obj-modified callbacks occur.
+	 * the defaults are strings of this graph, so share them directly. */
 	for (sym = dtfirst(datadict); sym; sym = dtnext(datadict, sym))
-	    rec->str[sym->id] = agstrdup(agraphof(obj), sym->defval);
+	    rec->str[sym->id] = agstrdupref(sym->defval);
     } else {
 	assert(rec->dict == datadict);
     }
@@ -237,14 +249,15 @@ static void addattr(Agraph_t * g, Agobj_t * obj, Agsym_t * sym)
 
     attr = (Agattr_t *) agattrrec(obj);
     assert(attr != NULL);
-    if (sym->id >= MINATTR)
+    /* the array is full when the new id reaches its capacity */
+    if (attrcapacity(sym->id) == sym->id)
 	attr->str = (char **) AGDISC(g, mem)->resize(AGCLOS(g, mem),
 						     attr->str,
 						     (size_t) sym->id *
 						     sizeof(char *),
-						     ((size_t) sym->id +
-						      1) * sizeof(char *));
-    attr->str[sym->id] = agstrdup(g, sym->defval);
+						     (size_t) sym->id * 2 *
+						     sizeof(char *));
+    attr->str[sym->id] = agstrdupref(sym->defval);
 }
 
 
@@ -254,6 +267,7 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value) {
     Agraph_t *root;
     Agnode_t *n;
     Agedge_t *e;
+    char *oldval;
 
     assert(value);
     root = agroot(g);
@@ -263,8 +277,9 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value) {
     if (lsym) {			/* update old local definition */
 	if (g != root && streq(name, "layout"))
 	    agerr(AGWARN, "layout attribute is invalid except on the root graph\n");
-	agstrfree(g, lsym->defval);
+	oldval = lsym->defval;
 	lsym->defval = agstrdup(g, value);
+	agstrfree(g, oldval);
 	rv = lsym;
     } else {
 	psym = agdictsym(ldict, name);	/* search with viewpath up to root */
@@ -447,6 +462,21 @@ char *agxget(void *obj, Agsym_t * sym)
     return rv;
 }
 
+/* agxgetdouble, agxgetlong:
+ * The value of sym for obj as a number. Values are strings shared within
+ * the graph, and each remembers the number it was last parsed as, so
+ * repeated lookups of the same value do not call strtod or strtol again.
+ */
+int agxgetdouble(void *obj, Agsym_t * sym, double *value)
+{
+    return agstrtod(agxget(obj, sym), value);
+}
+
+int agxgetlong(void *obj, Agsym_t * sym, long *value)
+{
+    return agstrtol(agxget(obj, sym), value);
+}
+
 int agset(void *obj, char *name, const char *value) {
     Agsym_t *sym;
     int rv;
@@ -465,20 +495,24 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
     Agobj_t *hdr;
     Agattr_t *data;
     Agsym_t *lsym;
+    char *oldval;
 
     g = agraphof(obj);
     hdr = obj;
     data = agattrrec(hdr);
     assert(sym->id >= 0 && sym->id < topdictsize(obj));
-    agstrfree(g, data->str[sym->id]);
+    /* take the new reference first: value may be the old string itself */
+    oldval = data->str[sym->id];
     data->str[sym->id] = agstrdup(g, value);
+    agstrfree(g, oldval);
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict;
 	dict = agdatadict(g, FALSE)->dict.g;
 	if ((lsym = aglocaldictsym(dict, sym->name))) {
-	    agstrfree(g, lsym->defval);
+	    oldval = lsym->defval;
 	    lsym->defval = agstrdup(g, value);
+	    agstrfree(g, oldval);
 	} else {
 	    lsym = agnewsym(g, sym->name, value, sym->id, AGTYPE(hdr));
 	    dtinsert(dict, lsym);
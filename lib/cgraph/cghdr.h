@@ -74,17 +74,29 @@ extern Dtdisc_t Ag_subnode_id_disc;
 extern Dtdisc_t Ag_subnode_seq_disc;
 extern Dtdisc_t Ag_mainedge_id_disc;
 extern Dtdisc_t Ag_subedge_id_disc;
-extern Dtdisc_t Ag_mainedge_seq_disc;
-extern Dtdisc_t Ag_subedge_seq_disc;
 extern Dtdisc_t Ag_subgraph_id_disc;
 extern Agcbdisc_t AgAttrdisc;
 
+	/* the in- or out-edges of a node in one graph, as an array in the
+	 * order of the other endpoint's sequence number, then the edge's */
+struct Agedgeseq_s {
+    unsigned lo, hi;		/* the edges are e[lo..hi) */
+    unsigned sorted;		/* e[lo..sorted) are in order, the rest appended */
+    unsigned finger;		/* index of the edge a traversal last returned */
+    unsigned size;		/* allocated length of e */
+    Agedge_t *e[1];		/* this is actually a dynamic array */
+};
+int agedgeseqsize(Agedgeseq_t * s);
+
 	/* internal constructor of graphs and subgraphs */
 Agraph_t *agopen1(Agraph_t * g);
 int agstrclose(Agraph_t * g);
 
 	/* ref string management */
 void agmarkhtmlstr(char *s);
+char *agstrdupref(char *s);
+int agstrtod(char *s, double *v);
+int agstrtol(char *s, long *v);
 
 	/* object set management */
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id);
@@ -68,6 +68,7 @@ typedef struct Agrec_s Agrec_t;	/* generic runtime record */
 typedef struct Agdatadict_s Agdatadict_t;	/* set of dictionaries per graph */
 typedef struct Agedgepair_s Agedgepair_t;	/* the edge object */
 typedef struct Agsubnode_s Agsubnode_t;
+typedef struct Agedgeseq_s Agedgeseq_t;	/* edges of a node, in order */
 
 /* Header of a user record.  These records are attached by client programs
 dynamically at runtime.  A unique string ID must be given to each record
@@ -124,7 +125,7 @@ struct Agsubnode_s {		/* the node-per-graph-or-subgraph record */
     Dtlink_t id_link;
     Agnode_t *node;		/* the object */
     Dtlink_t *in_id, *out_id;	/* by node/ID for random access */
-    Dtlink_t *in_seq, *out_seq;	/* by node/sequence for serial access */
+    Agedgeseq_t *in_seq, *out_seq;	/* by node/sequence for serial access */
 };
 
 struct Agnode_s {
@@ -136,7 +137,6 @@ struct Agnode_s {
 struct Agedge_s {
     Agobj_t base;
     Dtlink_t id_link;		/* main graph only */
-    Dtlink_t seq_link;
     Agnode_t *node;		/* the endpoint node */
 };
 
@@ -239,7 +239,7 @@ struct Agraph_s {
     Dtlink_t link;
     Dict_t *n_seq;		/* the node set in sequence */
     Dict_t *n_id;		/* the node set indexed by ID */
-    Dict_t *e_seq, *e_id;	/* holders for edge sets */
+    Dict_t *e_id;		/* holder for edge sets */
     Dict_t *g_dict;		/* subgraphs - descendants */
     Agraph_t *parent, *root;	/* subgraphs - ancestors */
     Agclos_t *clos;		/* shared resources */
@@ -351,6 +351,8 @@ CGRAPH_API void agclean(Agraph_t * g, int kind, char *rec_name);
 
 CGRAPH_API char *agget(void *obj, char *name);
 CGRAPH_API char *agxget(void *obj, Agsym_t * sym);
+CGRAPH_API int agxgetdouble(void *obj, Agsym_t * sym, double *value);
+CGRAPH_API int agxgetlong(void *obj, Agsym_t * sym, long *value);
 CGRAPH_API int agset(void *obj, char *name, const char *value);
 CGRAPH_API int agxset(void *obj, Agsym_t * sym, const char *value);
 CGRAPH_API int agsafeset(void* obj, char* name, const char* value,
@@ -431,7 +433,7 @@ CGRAPH_API extern Agdesc_t Agstrictundirected;
 /* fast graphs */
 void agflatten(Agraph_t * g, int flag);
 typedef Agsubnode_t	Agnoderef_t;
-typedef Dtlink_t	Agedgeref_t;
+typedef Agedge_t	*Agedgeref_t;	/* a slot of a node's edge array */
 
 #define AGHEADPOINTER(g)	((Agnoderef_t*)(g->n_seq->data->hh._head))
 #define AGRIGHTPOINTER(rep)  	((Agnoderef_t*)((rep)->seq_link.right?((void*)((rep)->seq_link.right) - offsetof(Agsubnode_t,seq_link)):0))
@@ -446,15 +448,17 @@ typedef Dtlink_t	Agedgeref_t;
 #define LASTNREF(g)		(agflatten(g,1), AGHEADPOINTER(g)?AGLEFTPOINTER(AGHEADPOINTER(g)):0)
 #define NODEOF(rep)		((rep)->node)
 
-#define FIRSTOUTREF(g,sn)	(agflatten(g,1), (sn)->out_seq)
-#define LASTOUTREF(g,sn)	(agflatten(g,1), (Agedgeref_t*)dtlast(sn->out_seq))
-#define FIRSTINREF(g,sn)	(agflatten(g,1), (sn)->in_seq)
-#define NEXTEREF(g,rep)  	((rep)->right)
-#define PREVEREF(g,rep)  	((rep)->hl._left)
-/* this is expedient but a bit slimey because it "knows" that dict entries of both nodes
-and edges are embedded in main graph objects but allocated separately in subgraphs */
+/* edge arrays end in NULL at both ends while no edge is added or removed */
+CGRAPH_API Agedgeref_t *agedgerefs(Agraph_t * g, Agedgeseq_t ** set, int last);
+#define FIRSTOUTREF(g,sn)	(agflatten(g,1), agedgerefs(g,&(sn)->out_seq,0))
+#define LASTOUTREF(g,sn)	(agflatten(g,1), agedgerefs(g,&(sn)->out_seq,1))
+#define FIRSTINREF(g,sn)	(agflatten(g,1), agedgerefs(g,&(sn)->in_seq,0))
+#define NEXTEREF(g,rep)  	((rep)[1]?(rep)+1:0)
+#define PREVEREF(g,rep)  	((rep)[-1]?(rep)-1:0)
+/* this is expedient but a bit slimey because it "knows" that dict entries of nodes
+are embedded in main graph objects but allocated separately in subgraphs */
 #define AGSNMAIN(sn)        ((sn)==(&((sn)->node->mainsub)))
-#define EDGEOF(sn,rep)		(AGSNMAIN(sn)?((Agedge_t*)((unsigned char*)(rep) - offsetof(Agedge_t,seq_link))) : ((Dthold_t*)(rep))->obj)
+#define EDGEOF(sn,rep)		(*(rep))
 
 #ifdef __cplusplus
 }
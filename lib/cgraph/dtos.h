@@ -0,0 +1,73 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// maximum number of bytes needed to print a NUL-terminated double with dtos2
+enum { CHARS_FOR_NUL_TERM_DTOS2 = 320 };
+
+/** convert a double to a string with at most two decimal places
+ *
+ * The result is byte-for-byte what printing with "%.2f" in the C locale and
+ * then dropping trailing zeros, and a trailing decimal point, would give. For
+ * the magnitudes of coordinates in drawings it avoids the much slower printf
+ * machinery; values that are not clearly on one side of a rounding tie, and
+ * very large ones, are still passed to snprintf.
+ *
+ * @param buf Destination of at least CHARS_FOR_NUL_TERM_DTOS2 bytes
+ * @param v Number to convert
+ * @return Length of the string written to buf
+ */
+static inline size_t dtos2(char *buf, double v) {
+
+  // below this magnitude, v * 100 is accurate to better than 2e-7
+  if (v > -1e7 && v < 1e7) {
+    double scaled = v * 100;
+    double r = nearbyint(scaled);
+    if (fabs(scaled - r) < 0.5 - 1e-6) {
+      unsigned long n = (unsigned long)fabs(r);
+      unsigned long ipart = n / 100;
+      unsigned frac = (unsigned)(n % 100);
+      char digits[16];
+      size_t ndigits = 0;
+      char *p = buf;
+
+      if (signbit(v))
+        *p++ = '-';
+      do {
+        digits[ndigits++] = (char)('0' + ipart % 10);
+        ipart /= 10;
+      } while (ipart != 0);
+      while (ndigits > 0)
+        *p++ = digits[--ndigits];
+      if (frac != 0) {
+        *p++ = '.';
+        *p++ = (char)('0' + frac / 10);
+        if (frac % 10 != 0)
+          *p++ = (char)('0' + frac % 10);
+      }
+      *p = '\0';
+      return (size_t)(p - buf);
+    }
+  }
+
+  int len = snprintf(buf, CHARS_FOR_NUL_TERM_DTOS2, "%.2f", v);
+  if (len < 0 || len >= CHARS_FOR_NUL_TERM_DTOS2) {
+    buf[0] = '\0';
+    return 0;
+  }
+  char *dot = strchr(buf, '.');
+  if (dot != NULL) {
+    if (dot[2] == '0') {
+      if (dot[1] == '0') {
+        *dot = '\0';
+        return (size_t)(dot - buf);
+      }
+      dot[2] = '\0';
+      return (size_t)(dot + 2 - buf);
+    }
+  }
+  return (size_t)len;
+}
@@ -10,9 +10,213 @@
 
 #include <cgraph/cghdr.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 static Agtag_t Tag;		/* to silence warnings about initialization */
 
+/* edge comparison.  for ordered traversal. */
+static int agedgeseqcmpf(const Agedge_t * e0, const Agedge_t * e1)
+{
+    if (e0->node != e1->node) {
+        if (AGSEQ(e0->node) < AGSEQ(e1->node)) return -1;
+        if (AGSEQ(e0->node) > AGSEQ(e1->node)) return 1;
+    }
+    else {
+        if (AGSEQ(e0) < AGSEQ(e1)) return -1;
+        if (AGSEQ(e0) > AGSEQ(e1)) return 1;
+    }
+    return 0;
+}
+
+static int seqcmpf(const void *p0, const void *p1)
+{
+    return agedgeseqcmpf(*(Agedge_t * const *) p0, *(Agedge_t * const *) p1);
+}
+
+#define MINSEQ 4		/* initial allocation */
+
+static size_t seqbytes(unsigned size)
+{
+    return sizeof(Agedgeseq_t) + (size - 1) * sizeof(Agedge_t *);
+}
+
+/* seqsort:
+ * Put the edges appended since the last traversal in order: sort them and
+ * merge them into the ordered part. Edges are usually created in order, so
+ * there is most often nothing to do.
+ */
+static void seqsort(Agraph_t * g, Agedgeseq_t * s)
+{
+    Agedge_t **tmp;
+    unsigned n, i, j, w;
+
+    if (s->sorted == s->hi)
+	return;
+    n = s->hi - s->sorted;
+    qsort(&s->e[s->sorted], n, sizeof(s->e[0]), seqcmpf);
+    if (s->sorted > s->lo
+	&& agedgeseqcmpf(s->e[s->sorted - 1], s->e[s->sorted]) > 0) {
+	/* merge from the back, with the appended edges set aside */
+	tmp = agalloc(g, n * sizeof(tmp[0]));
+	memcpy(tmp, &s->e[s->sorted], n * sizeof(tmp[0]));
+	i = s->sorted;
+	j = n;
+	w = s->hi;
+	while (j > 0) {
+	    if (i > s->lo && agedgeseqcmpf(s->e[i - 1], tmp[j - 1]) > 0)
+		s->e[--w] = s->e[--i];
+	    else
+		s->e[--w] = tmp[--j];
+	}
+	agfree(g, tmp);
+    }
+    s->sorted = s->hi;
+}
+
+/* seqfind:
+ * Index of the first edge of s that does not precede e.
+ * s must be in order.
+ */
+static unsigned seqfind(Agedgeseq_t * s, Agedge_t * e)
+{
+    unsigned lo = s->lo, hi = s->hi, mid;
+
+    if (s->finger >= s->lo && s->finger < s->hi && s->e[s->finger] == e)
+	return s->finger;
+    while (lo < hi) {
+	mid = lo + (hi - lo) / 2;
+	if (agedgeseqcmpf(s->e[mid], e) < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+static Agedge_t *seqfirst(Agraph_t * g, Agedgeseq_t * s)
+{
+    if (s == NULL)
+	return NULL;
+    seqsort(g, s);
+    s->finger = s->lo;
+    return s->e[s->lo];
+}
+
+/* seqnext:
+ * The edge after e in s. Traversals keep a finger on the edge they
+ * returned last, so stepping through s costs no search.
+ */
+static Agedge_t *seqnext(Agraph_t * g, Agedgeseq_t * s, Agedge_t * e)
+{
+    unsigned i;
+
+    if (s == NULL)
+	return NULL;
+    seqsort(g, s);
+    i = seqfind(s, e);
+    if (i < s->hi && s->e[i] == e)
+	i++;
+    if (i >= s->hi)
+	return NULL;
+    s->finger = i;
+    return s->e[i];
+}
+
+int agedgeseqsize(Agedgeseq_t * s)
+{
+    return s ? (int) (s->hi - s->lo) : 0;
+}
+
+/* agedgerefs:
+ * The first or last slot of the edges in *set, for FIRSTOUTREF and
+ * friends, or NULL if there are none. The slots just before and after the
+ * edges are set to NULL, moving the edges if needed, so that NEXTEREF and
+ * PREVEREF can tell where they end.
+ */
+Agedgeref_t *agedgerefs(Agraph_t * g, Agedgeseq_t ** set, int last)
+{
+    Agedgeseq_t *s = *set;
+    unsigned n;
+
+    if (s == NULL)
+	return NULL;
+    seqsort(g, s);
+    if (s->lo == 0 || s->hi == s->size) {
+	n = s->hi - s->lo;
+	if (n + 2 > s->size) {
+	    s = agrealloc(g, s, seqbytes(s->size), seqbytes(s->size * 2));
+	    s->size *= 2;
+	    *set = s;
+	}
+	memmove(&s->e[1], &s->e[s->lo], n * sizeof(s->e[0]));
+	s->finger = s->finger >= s->lo ? s->finger - s->lo + 1 : 1;
+	s->lo = 1;
+	s->hi = s->sorted = n + 1;
+    }
+    s->e[s->lo - 1] = NULL;
+    s->e[s->hi] = NULL;
+    return &s->e[last ? s->hi - 1 : s->lo];
+}
+
+static void ins(Agraph_t * g, Agedgeseq_t ** set, Agedge_t * e)
+{
+    Agedgeseq_t *s = *set;
+    unsigned n;
+
+    if (s == NULL) {
+	s = agalloc(g, seqbytes(MINSEQ));
+	s->size = MINSEQ;
+	*set = s;
+    } else if (s->hi == s->size) {
+	n = s->hi - s->lo;
+	if (s->lo >= s->size / 2) {
+	    /* enough room was freed at the front */
+	    memmove(&s->e[0], &s->e[s->lo], n * sizeof(s->e[0]));
+	    s->sorted -= s->lo;
+	    s->finger = s->finger >= s->lo ? s->finger - s->lo : 0;
+	    s->lo = 0;
+	    s->hi = n;
+	} else {
+	    s = agrealloc(g, s, seqbytes(s->size), seqbytes(s->size * 2));
+	    s->size *= 2;
+	    *set = s;
+	}
+    }
+    s->e[s->hi++] = e;
+    if (s->sorted == s->hi - 1
+	&& (s->sorted == s->lo || agedgeseqcmpf(s->e[s->sorted - 1], e) < 0))
+	s->sorted = s->hi;
+}
+
+static void del(Agraph_t * g, Agedgeseq_t ** set, Agedge_t * e)
+{
+    Agedgeseq_t *s = *set;
+    unsigned i;
+
+    assert(s);
+    seqsort(g, s);
+    i = seqfind(s, e);
+    assert(i < s->hi && s->e[i] == e);
+    /* close the gap from the nearer end */
+    if (i - s->lo < s->hi - 1 - i) {
+	memmove(&s->e[s->lo + 1], &s->e[s->lo], (i - s->lo) * sizeof(s->e[0]));
+	if (s->finger >= s->lo && s->finger < i)
+	    s->finger++;
+	s->lo++;
+    } else {
+	memmove(&s->e[i], &s->e[i + 1], (s->hi - 1 - i) * sizeof(s->e[0]));
+	if (s->finger > i && s->finger < s->hi)
+	    s->finger--;
+	s->hi--;
+    }
+    s->sorted = s->hi;
+    if (s->lo == s->hi) {
+	agfree(g, s);
+	*set = NULL;
+    }
+}
+
 /* return first outedge of <n> */
 Agedge_t *agfstout(Agraph_t * g, Agnode_t * n)
 {
@@ -20,11 +224,8 @@ Agedge_t *agfstout(Agraph_t * g, Agnode_t * n)
     Agedge_t *e = NULL;
 
     sn = agsubrep(g, n);
-    if (sn) {
-		dtrestore(g->e_seq, sn->out_seq);
-		e = dtfirst(g->e_seq);
-		sn->out_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	e = seqfirst(g, sn->out_seq);
     return e;
 }
 
@@ -37,11 +238,8 @@ Agedge_t *agnxtout(Agraph_t * g, Agedge_t * e)
 
     n = AGTAIL(e);
     sn = agsubrep(g, n);
-    if (sn) {
-		dtrestore(g->e_seq, sn->out_seq);
-		f = dtnext(g->e_seq, e);
-		sn->out_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	f = seqnext(g, sn->out_seq, e);
     return f;
 }
 
@@ -51,11 +249,8 @@ Agedge_t *agfstin(Agraph_t * g, Agnode_t * n)
     Agedge_t *e = NULL;
 
     sn = agsubrep(g, n);
-	if (sn) {
-		dtrestore(g->e_seq, sn->in_seq);
-		e = dtfirst(g->e_seq);
-		sn->in_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	e = seqfirst(g, sn->in_seq);
     return e;
 }
 
@@ -67,12 +262,9 @@ Agedge_t *agnxtin(Agraph_t * g, Agedge_t * e)
 
     n = AGHEAD(e);
     sn = agsubrep(g, n);
-	if (sn) {
-		dtrestore(g->e_seq, sn->in_seq);
-		f = dtnext(g->e_seq, e);
-		sn->in_seq = dtextract(g->e_seq);
-	}
-	return f;
+    if (sn)
+	f = seqnext(g, sn->in_seq, e);
+    return f;
 }
 
 Agedge_t *agfstedge(Agraph_t * g, Agnode_t * n)
@@ -148,14 +340,14 @@ Agsubnode_t *agsubrep(Agraph_t * g, Agnode_t * n)
     return sn;
 }
 
-static void ins(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
+static void idins(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
 {
     dtrestore(d, *set);
     dtinsert(d, e);
     *set = dtextract(d);
 }
 
-static void del(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
+static void iddel(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
 {
     void *x;
     NOTUSED(x);
@@ -178,11 +370,11 @@ static void installedge(Agraph_t * g, Agedge_t * e)
     while (g) {
 	if (agfindedge_by_key(g, t, h, AGTAG(e))) break;
 	sn = agsubrep(g, t);
-	ins(g->e_seq, &sn->out_seq, out);
-	ins(g->e_id, &sn->out_id, out);
+	ins(g, &sn->out_seq, out);
+	idins(g->e_id, &sn->out_id, out);
 	sn = agsubrep(g, h);
-	ins(g->e_seq, &sn->in_seq, in);
-	ins(g->e_id, &sn->in_id, in);
+	ins(g, &sn->in_seq, in);
+	idins(g->e_id, &sn->in_id, in);
 	g = agparent(g);
     }
 }
@@ -324,11 +516,11 @@ void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
     t = in->node;
     h = out->node;
     sn = agsubrep(g, t);
-    del(g->e_seq, &sn->out_seq, out);
-    del(g->e_id, &sn->out_id, out);
+    del(g, &sn->out_seq, out);
+    iddel(g->e_id, &sn->out_id, out);
     sn = agsubrep(g, h);
-    del(g->e_seq, &sn->in_seq, in);
-    del(g->e_id, &sn->in_id, in);
+    del(g, &sn->in_seq, in);
+    iddel(g->e_id, &sn->in_id, in);
 #ifdef DEBUG
     for (e = agfstin(g,h); e; e = agnxtin(g,e))
 	assert(e != in);
@@ -398,53 +590,6 @@ static int agedgeidcmpf(Dict_t * d, void *arg_e0, void *arg_e1, Dtdisc_t * disc)
     return 0;
 }
 
-/* edge comparison.  for ordered traversal. */
-static int agedgeseqcmpf(Dict_t * d, void *arg_e0, void *arg_e1, Dtdisc_t * disc)
-{
-    Agedge_t *e0, *e1;
-
-    NOTUSED(d);
-    e0 = arg_e0;
-    e1 = arg_e1;
-    NOTUSED(disc);
-    assert(arg_e0 && arg_e1);
-
-    if (e0->node != e1->node) {
-        if (AGSEQ(e0->node) < AGSEQ(e1->node)) return -1;
-        if (AGSEQ(e0->node) > AGSEQ(e1->node)) return 1;
-    }
-    else {
-        if (AGSEQ(e0) < AGSEQ(e1)) return -1;
-        if (AGSEQ(e0) > AGSEQ(e1)) return 1;
-    }
-    return 0;
-}
-
-/* indexing for ordered traversal */
-Dtdisc_t Ag_mainedge_seq_disc = {
-    0,				/* pass object ptr      */
-    0,				/* size (ignored)       */
-    offsetof(Agedge_t,seq_link),/* use internal links	*/
-    NIL(Dtmake_f),
-    NIL(Dtfree_f),
-    agedgeseqcmpf,
-    NIL(Dthash_f),
-    agdictobjmem,
-    NIL(Dtevent_f)
-};
-
-Dtdisc_t Ag_subedge_seq_disc = {
-    0,				/* pass object ptr      */
-    0,				/* size (ignored)       */
-    -1,				/* use external holder objects */
-    NIL(Dtmake_f),
-    NIL(Dtfree_f),
-    agedgeseqcmpf,
-    NIL(Dthash_f),
-    agdictobjmem,
-    NIL(Dtevent_f)
-};
-
 /* indexing for random search */
 Dtdisc_t Ag_mainedge_id_disc = {
     0,				/* pass object ptr      */
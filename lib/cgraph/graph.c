@@ -68,7 +68,6 @@ Agraph_t *agopen1(Agraph_t * g)
 
     g->n_seq = agdtopen(g, &Ag_subnode_seq_disc, Dttree);
     g->n_id = agdtopen(g, &Ag_subnode_id_disc, Dttree);
-    g->e_seq = agdtopen(g, g == agroot(g)? &Ag_mainedge_seq_disc : &Ag_subedge_seq_disc, Dttree);
     g->e_id = agdtopen(g, g == agroot(g)? &Ag_mainedge_id_disc : &Ag_subedge_id_disc, Dttree);
     g->g_dict = agdtopen(g, &Ag_subgraph_id_disc, Dttree);
 
@@ -120,8 +119,6 @@ int agclose(Agraph_t * g)
 
     assert(dtsize(g->e_id) == 0);
     if (agdtclose(g, g->e_id)) return FAILURE;
-    assert(dtsize(g->e_seq) == 0);
-    if (agdtclose(g, g->e_seq)) return FAILURE;
 
     assert(dtsize(g->g_dict) == 0);
     if (agdtclose(g, g->g_dict)) return FAILURE;
@@ -195,15 +192,6 @@ int agissimple(Agraph_t * g)
     return (g->desc.strict && g->desc.no_loop);
 }
 
-static int cnt(Dict_t * d, Dtlink_t ** set)
-{
-	int rv;
-    dtrestore(d, *set);
-    rv = dtsize(d);
-    *set = dtextract(d);
-	return rv;
-}
-
 int agcountuniqedges(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
 {
     Agedge_t *e;
@@ -211,9 +199,9 @@ int agcountuniqedges(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
     int rv = 0;
 
     sn = agsubrep(g, n);
-    if (want_out) rv = cnt(g->e_seq,&(sn->out_seq));
+    if (want_out) rv = agedgeseqsize(sn->out_seq);
     if (want_in) {
-		if (!want_out) rv += cnt(g->e_seq,&(sn->in_seq));	/* cheap */
+		if (!want_out) rv += agedgeseqsize(sn->in_seq);	/* cheap */
 		else {	/* less cheap */
 			for (e = agfstin(g, n); e; e = agnxtin(g, e))
 				if (e->node != n) rv++;  /* don't double count loops */
@@ -229,8 +217,8 @@ int agdegree(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
 
     sn = agsubrep(g, n);
     if (sn) {
-	if (want_out) rv += cnt(g->e_seq,&(sn->out_seq));
-	if (want_in) rv += cnt(g->e_seq,&(sn->in_seq));
+	if (want_out) rv += agedgeseqsize(sn->out_seq);
+	if (want_in) rv += agedgeseqsize(sn->in_seq);
     }
 	return rv;
 }
@@ -145,12 +145,12 @@ int agdelrec(void *arg_obj, const char *name)
 	listdelrec(obj, rec);	/* zap it from the circular list */
 	switch (obj->tag.objtype) {	/* refresh any stale pointers */
 	case AGRAPH:
-	    objdelrec(g, obj, rec);
-	    break;
 	case AGNODE:
 	case AGINEDGE:
 	case AGOUTEDGE:
-	    agapply(agroot(g), obj, objdelrec, rec, FALSE);
+	    /* a node or edge is the same object in every subgraph holding it,
+	     * so there is only the one pointer to refresh */
+	    objdelrec(g, obj, rec);
 	    break;
 	default:
 	    UNREACHABLE();
@@ -9,17 +9,29 @@
  *************************************************************************/
 
 #include <cgraph/cghdr.h>
+#include <locale.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /*
  * reference counted strings.
  */
 
+/* kinds of number cached with a string */
+enum { NUM_NONE, NUM_DOUBLE, NUM_LONG };
+
 typedef struct {
     Dtlink_t link;
-    uint64_t refcnt: sizeof(uint64_t) * 8 - 1;
+    uint64_t refcnt: sizeof(uint64_t) * 8 - 12;
     uint64_t is_html: 1;
+    uint64_t num_kind: 2;	/* which of num holds the parsed string */
+    uint64_t num_ok: 1;		/* whether the string starts with a number */
+    uint64_t num_point: 8;	/* decimal point num.d was parsed with */
+    union {
+	double d;
+	long l;
+    } num;
     char *s;
     char store[1];		/* this is actually a dynamic array */
 } refstr_t;
@@ -114,6 +126,7 @@ char *agstrdup(Agraph_t * g, const char *s)
 	    r = malloc(sz);
 	r->refcnt = 1;
 	r->is_html = 0;
+	r->num_kind = NUM_NONE;
 	strcpy(r->store, s);
 	r->s = r->store;
 	dtinsert(strdict, r);
@@ -141,6 +154,7 @@ char *agstrdup_html(Agraph_t * g, const char *s)
 	    r = malloc(sz);
 	r->refcnt = 1;
 	r->is_html = 1;
+	r->num_kind = NUM_NONE;
 	strcpy(r->store, s);
 	r->s = r->store;
 	dtinsert(strdict, r);
@@ -148,6 +162,22 @@ char *agstrdup_html(Agraph_t * g, const char *s)
     return r->s;
 }
 
+/* agstrdupref:
+ * Take another reference to s, which must itself have been returned by
+ * agstrdup in the graph that will hold the new reference. This is
+ * agstrdup(g, s) without the dictionary lookup.
+ */
+char *agstrdupref(char *s)
+{
+    refstr_t *r;
+
+    if (s == NULL)
+	return NULL;
+    r = (refstr_t *) (s - offsetof(refstr_t, store[0]));
+    r->refcnt++;
+    return s;
+}
+
 int agstrfree(Agraph_t * g, const char *s)
 {
     refstr_t *r;
@@ -193,6 +223,58 @@ void agmarkhtmlstr(char *s)
     key->is_html = 1;
 }
 
+/* agstrtod:
+ * Parse s, a string returned by agstrdup, with strtod.
+ * The result is kept with the string, so a value shared by many objects
+ * is only parsed once. Like strtod, this uses the decimal point of the
+ * current LC_NUMERIC locale; a value kept from a locale with a different
+ * decimal point is parsed again. Returns SUCCESS, or FAILURE if s does not
+ * start with a number.
+ */
+int agstrtod(char *s, double *v)
+{
+    refstr_t *r;
+    char *endp;
+    unsigned char point;
+
+    if (s == NULL)
+	return FAILURE;
+    r = (refstr_t *) (s - offsetof(refstr_t, store[0]));
+    point = (unsigned char)localeconv()->decimal_point[0];
+    if (r->num_kind != NUM_DOUBLE || r->num_point != point) {
+	r->num.d = strtod(s, &endp);
+	r->num_ok = endp != s;
+	r->num_kind = NUM_DOUBLE;
+	r->num_point = point;
+    }
+    if (!r->num_ok)
+	return FAILURE;
+    *v = r->num.d;
+    return SUCCESS;
+}
+
+/* agstrtol:
+ * As agstrtod, for a decimal integer parsed with strtol.
+ */
+int agstrtol(char *s, long *v)
+{
+    refstr_t *r;
+    char *endp;
+
+    if (s == NULL)
+	return FAILURE;
+    r = (refstr_t *) (s - offsetof(refstr_t, store[0]));
+    if (r->num_kind != NUM_LONG) {
+	r->num.l = strtol(s, &endp, 10);
+	r->num_ok = endp != s;
+	r->num_kind = NUM_LONG;
+    }
+    if (!r->num_ok)
+	return FAILURE;
+    *v = r->num.l;
+    return SUCCESS;
+}
+
 #ifdef DEBUG
 static int refstrprint(Dict_t * dict, void *ptr, void *user)
 {
@@ -0,0 +1,127 @@
+// basic unit tester for dtos
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <cgraph/dtos.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the formatting dtos2 replaces: "%.2f" followed by trimming trailing zeros
+static void reference(char *buf, size_t size, double v) {
+  (void)snprintf(buf, size, "%.2f", v);
+  char *dot = strchr(buf, '.');
+  if (dot == NULL)
+    return;
+  if (dot[2] == '0') {
+    if (dot[1] == '0') {
+      *dot = '\0';
+    } else {
+      dot[2] = '\0';
+    }
+  }
+}
+
+static void check(double v) {
+  char expected[CHARS_FOR_NUL_TERM_DTOS2];
+  char actual[CHARS_FOR_NUL_TERM_DTOS2];
+
+  reference(expected, sizeof(expected), v);
+  size_t len = dtos2(actual, v);
+
+  if (strcmp(expected, actual) != 0 || len != strlen(actual)) {
+    fprintf(stderr, "dtos2(%.17g) = \"%s\" (%zu), expected \"%s\"\n", v,
+            actual, len, expected);
+    abort();
+  }
+}
+
+static void test_simple(void) {
+  check(0);
+  check(1);
+  check(-1);
+  check(0.5);
+  check(0.25);
+  check(-72.1);
+  check(1234.56);
+}
+
+static void test_signed_zero(void) {
+  check(-0.0);
+  check(-0.001);
+  check(0.001);
+}
+
+static void test_ties(void) {
+  // exactly representable ties, rounded to even by printf
+  check(0.125);
+  check(0.375);
+  check(-2.625);
+  // decimal ties that are not representable
+  check(1.005);
+  check(2.675);
+  check(0.005);
+  check(-0.005);
+  check(99.995);
+  check(9.995);
+}
+
+static void test_limits(void) {
+  check(1e7);
+  check(-1e7);
+  check(1e7 - 0.01);
+  check(-1e7 + 0.01);
+  check(1e15 + 0.3);
+  check(DBL_MAX);
+  check(-DBL_MAX);
+  check(DBL_MIN);
+  check(INFINITY);
+  check(-INFINITY);
+  check(NAN);
+}
+
+static void test_grid(void) {
+  // every multiple of a thousandth and of half a hundredth in a range,
+  // which covers all the rounding cases of the last digit
+  for (int i = -200000; i <= 200000; ++i) {
+    check(i / 1000.0);
+    check(i / 200.0);
+    check(i * 0.001);
+  }
+}
+
+static void test_random(void) {
+  srand(42);
+  for (int i = 0; i < 1000000; ++i) {
+    double mantissa = (double)rand() / RAND_MAX - 0.5;
+    int exponent = rand() % 18 - 6;
+    check(mantissa * pow(10, exponent));
+  }
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(simple);
+  RUN(signed_zero);
+  RUN(ties);
+  RUN(limits);
+  RUN(grid);
+  RUN(random);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <common/boxindex.h>
+#include <common/memory.h>
+#include <math.h>
+#include <stdlib.h>
+
+/* entries per node of the tree */
+#define FANOUT 16
+
+/* Level 0 holds the items, in the order they were packed into leaves. Entry
+ * i at level l > 0 bounds entries [i*FANOUT, (i+1)*FANOUT) of level l-1, so
+ * the tree needs no child pointers.
+ */
+struct boxindex_s {
+    size_t n;		/* number of items */
+    size_t nlevels;	/* levels, including the items */
+    size_t *count;	/* count[l]: entries at level l */
+    boxf **box;		/* box[l][i]: bounds of entry i at level l */
+    size_t *item;	/* item[i]: input position of level 0 entry i */
+};
+
+typedef struct {
+    double x, y;	/* center of the box */
+    size_t i;		/* input position */
+} center_t;
+
+static int cmpx(const void *p, const void *q)
+{
+    const center_t *a = p;
+    const center_t *b = q;
+
+    if (a->x < b->x) return -1;
+    if (a->x > b->x) return 1;
+    if (a->i < b->i) return -1;
+    return a->i > b->i;
+}
+
+static int cmpy(const void *p, const void *q)
+{
+    const center_t *a = p;
+    const center_t *b = q;
+
+    if (a->y < b->y) return -1;
+    if (a->y > b->y) return 1;
+    if (a->i < b->i) return -1;
+    return a->i > b->i;
+}
+
+static int cmpsize(const void *p, const void *q)
+{
+    size_t a = *(const size_t *)p;
+    size_t b = *(const size_t *)q;
+
+    if (a < b) return -1;
+    return a > b;
+}
+
+static boxf merge(boxf b0, boxf b1)
+{
+    if (b1.LL.x < b0.LL.x) b0.LL.x = b1.LL.x;
+    if (b1.LL.y < b0.LL.y) b0.LL.y = b1.LL.y;
+    if (b1.UR.x > b0.UR.x) b0.UR.x = b1.UR.x;
+    if (b1.UR.y > b0.UR.y) b0.UR.y = b1.UR.y;
+    return b0;
+}
+
+boxindex_t *boxindex_new(const boxf *boxes, size_t n)
+{
+    boxindex_t *ix = NEW(boxindex_t);
+    center_t *c;
+    size_t i, j, l, nleaves, nslices, slice, cnt;
+
+    ix->n = n;
+    ix->item = N_NEW(n ? n : 1, size_t);
+
+    /* sort-tile-recursive: cut the items into vertical slices by x, then
+     * order each slice by y, so that runs of FANOUT items are compact
+     */
+    c = N_NEW(n ? n : 1, center_t);
+    for (i = 0; i < n; i++) {
+	c[i].x = (boxes[i].LL.x + boxes[i].UR.x) / 2;
+	c[i].y = (boxes[i].LL.y + boxes[i].UR.y) / 2;
+	c[i].i = i;
+    }
+    qsort(c, n, sizeof(c[0]), cmpx);
+    nleaves = (n + FANOUT - 1) / FANOUT;
+    nslices = (size_t)ceil(sqrt((double)nleaves));
+    slice = (nslices ? nslices : 1) * FANOUT;
+    for (i = 0; i < n; i += slice)
+	qsort(c + i, n - i < slice ? n - i : slice, sizeof(c[0]), cmpy);
+    for (i = 0; i < n; i++)
+	ix->item[i] = c[i].i;
+    free(c);
+
+    /* count the levels: add parents until a single node holds the top */
+    ix->nlevels = 1;
+    for (cnt = n; cnt > FANOUT; cnt = (cnt + FANOUT - 1) / FANOUT)
+	ix->nlevels++;
+    ix->count = N_NEW(ix->nlevels, size_t);
+    ix->box = N_NEW(ix->nlevels, boxf *);
+
+    ix->count[0] = n;
+    ix->box[0] = N_NEW(n ? n : 1, boxf);
+    for (i = 0; i < n; i++)
+	ix->box[0][i] = boxes[ix->item[i]];
+    for (l = 1; l < ix->nlevels; l++) {
+	cnt = ix->count[l - 1];
+	ix->count[l] = (cnt + FANOUT - 1) / FANOUT;
+	ix->box[l] = N_NEW(ix->count[l], boxf);
+	for (i = 0; i < ix->count[l]; i++) {
+	    boxf bb = ix->box[l - 1][i * FANOUT];
+	    for (j = i * FANOUT + 1; j < cnt && j < (i + 1) * FANOUT; j++)
+		bb = merge(bb, ix->box[l - 1][j]);
+	    ix->box[l][i] = bb;
+	}
+    }
+
+    return ix;
+}
+
+static size_t search(const boxindex_t *ix, size_t l, size_t first, size_t last,
+                     boxf b, size_t *found, size_t nfound)
+{
+    size_t i;
+
+    if (last > ix->count[l])
+	last = ix->count[l];
+    for (i = first; i < last; i++) {
+	if (!OVERLAP(ix->box[l][i], b))
+	    continue;
+	if (l == 0)
+	    found[nfound++] = ix->item[i];
+	else
+	    nfound = search(ix, l - 1, i * FANOUT, (i + 1) * FANOUT, b, found,
+	                    nfound);
+    }
+    return nfound;
+}
+
+size_t boxindex_search(const boxindex_t *ix, boxf b, size_t *found)
+{
+    size_t top = ix->nlevels - 1;
+    size_t nfound = search(ix, top, 0, ix->count[top], b, found, 0);
+
+    qsort(found, nfound, sizeof(found[0]), cmpsize);
+    return nfound;
+}
+
+size_t boxindex_size(const boxindex_t *ix)
+{
+    return ix->n;
+}
+
+void boxindex_free(boxindex_t *ix)
+{
+    size_t l;
+
+    if (!ix)
+	return;
+    for (l = 0; l < ix->nlevels; l++)
+	free(ix->box[l]);
+    free(ix->box);
+    free(ix->count);
+    free(ix->item);
+    free(ix);
+}
@@ -0,0 +1,57 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/// @file
+/// @brief static spatial index of boxes, for finding what overlaps a region
+
+#pragma once
+
+#include <common/geom.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct boxindex_s boxindex_t;
+
+/** build an index over a fixed set of boxes
+ *
+ * The boxes are packed bottom up into a balanced R-tree (sort-tile-recursive
+ * loading), so construction is a few sorts and no insertions. The index
+ * refers to items by their position in the boxes array and does not keep a
+ * pointer to it.
+ *
+ * @param boxes Bounding boxes of the items
+ * @param n Number of items
+ * @return A new index, to be freed with boxindex_free
+ */
+boxindex_t *boxindex_new(const boxf *boxes, size_t n);
+
+/** find the items whose boxes overlap a region
+ *
+ * Boxes that only touch the region are included, as with OVERLAP.
+ *
+ * @param ix Index to search
+ * @param b Region of interest
+ * @param found [out] Positions of the overlapping items, in ascending order.
+ *   It must have room for as many items as the index holds.
+ * @return Number of items written to found
+ */
+size_t boxindex_search(const boxindex_t *ix, boxf b, size_t *found);
+
+/// number of items in the index
+size_t boxindex_size(const boxindex_t *ix);
+
+void boxindex_free(boxindex_t *ix);
+
+#ifdef __cplusplus
+}
+#endif
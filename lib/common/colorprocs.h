@@ -17,6 +17,7 @@ extern "C" {
 #endif
 
 extern void setColorScheme (char* s);
+extern char *getColorScheme (void);
 extern int colorxlate(char *str, gvcolor_t * color, color_type_t target_type);
 extern char *canontoken(char *str);
 extern int colorCvt(gvcolor_t *ocolor, gvcolor_t *ncolor);
@@ -543,3 +543,11 @@ void setColorScheme (char* s)
 {
     colorscheme = s;
 }
+
+/* getColorScheme:
+ * Return the color scheme currently used for resolving names.
+ */
+char *getColorScheme (void)
+{
+    return colorscheme;
+}
@@ -213,6 +213,7 @@
 #define WEDGED		(1 << 9)
 #define UNDERLINE	(1 << 10)
 #define FIXEDSHAPE	(1 << 11)
+#define SHAREDSHAPE	(1 << 12)	/* polygon_t is shared with other nodes */
 
 #define SHAPE_MASK	(127 << 24)
 
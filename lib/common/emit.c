@@ -15,12 +15,14 @@
 #include "config.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
 #include <locale.h>
 #include <math.h>
 #include <common/render.h>
 #include <cgraph/agxbuf.h>
+#include <common/boxindex.h>
 #include <common/htmltable.h>
 #include <gvc/gvc.h>
 #include <cdt/cdt.h>
@@ -1758,6 +1760,17 @@ static bool clust_in_layer(GVJ_t *job, graph_t * sg)
     return false;
 }
 
+/* below_lod:
+ * True if the box, drawn at the current zoom, is smaller than the graph's
+ * lod size (in points) in both directions.
+ */
+static bool below_lod(GVJ_t *job, boxf b)
+{
+    return job->lod > 0
+	&& (b.UR.x - b.LL.x) * job->zoom < job->lod
+	&& (b.UR.y - b.LL.y) * job->zoom < job->lod;
+}
+
 static bool node_in_box(node_t *n, boxf b)
 {
     return boxf_overlap(ND_bb(n), b) != 0;
@@ -2240,6 +2253,36 @@ taperfun (edge_t* e)
     return agisdirected(agraphof(aghead(e))) ? forfunc : nonefunc;
 }
 
+/* emit_edge_outline:
+ * Draw an edge too small to show any detail as a polyline through the ends
+ * of its bezier segments, in its first color and without arrowheads.
+ */
+static void emit_edge_outline(GVJ_t * job, edge_t * e, char *color)
+{
+    char *colors = NULL;
+    pointf *pts;
+    bezier bz;
+    int i, j, n;
+
+    if (strchr(color, ':')) {
+	colors = strdup(color);
+	color = strtok(colors, ":");
+	if (!color)
+	    color = "";
+    }
+    if (! (ED_gui_state(e) & (GUI_STATE_ACTIVE | GUI_STATE_SELECTED)))
+	gvrender_set_pencolor(job, color[0] ? color : DEFAULT_COLOR);
+    for (i = 0; i < ED_spl(e)->size; i++) {
+	bz = ED_spl(e)->list[i];
+	pts = N_NEW(bz.size / 3 + 1, pointf);
+	for (j = 0, n = 0; j < bz.size; j += 3)
+	    pts[n++] = bz.list[j];
+	gvrender_polyline(job, pts, n);
+	free(pts);
+    }
+    free(colors);
+}
+
 static void emit_edge_graphics(GVJ_t * job, edge_t * e, char** styles)
 {
     int i, j, cnum, numc = 0, numsemi = 0;
@@ -2315,7 +2358,10 @@ static void emit_edge_graphics(GVJ_t * job, edge_t * e, char** styles)
 	    gvrender_set_fillcolor(job, fillcolor);
 	color = pencolor;
 
-	if (tapered) {
+	if (below_lod(job, ED_spl(e)->bb)) {
+	    emit_edge_outline(job, e, color);
+	}
+	else if (tapered) {
 	    stroke_t* stp;
 	    if (*color == '\0') color = DEFAULT_COLOR;
 	    if (*fillcolor == '\0') fillcolor = DEFAULT_COLOR;
@@ -3311,7 +3357,194 @@ static void emit_colors(GVJ_t * job, graph_t * g)
     }
 }
 
-static void emit_view(GVJ_t * job, graph_t * g, int flags)
+/* When a drawing is split into many pages, each page would otherwise test
+ * every node and edge against its clip box. Instead the nodes and edges are
+ * indexed once, by the position at which emit_view reaches them, and each
+ * page emits what the index finds for it in ascending order, which is the
+ * order the full walk would have emitted them in.
+ */
+#define EMIT_INDEX_FLAGS (EMIT_SORTED | EMIT_EDGE_SORTED | EMIT_PREORDER)
+
+typedef struct {
+    graph_t *g;		/* graph and emit order the index was built for */
+    int flags;		/* flags & EMIT_INDEX_FLAGS */
+    boxindex_t *index;
+    void **objs;	/* objs[i]: node or edge at walk position i */
+    size_t *found;	/* search results */
+} emit_index_t;
+
+static void index_node(emit_index_t *ix, boxf *boxes, size_t *n, node_t *np)
+{
+    if (!ND_shape(np) || ND_state(np))
+	return;
+    ND_state(np) = 1;
+    boxes[*n] = ND_bb(np);
+    ix->objs[(*n)++] = np;
+}
+
+static void index_edge(emit_index_t *ix, boxf *boxes, size_t *n, edge_t *e)
+{
+    textlabel_t *lp;
+    boxf bb, lb;
+    bool have = false;
+    int i;
+
+    if (ED_spl(e)) {
+	bb = ED_spl(e)->bb;
+	have = true;
+    }
+    for (i = 0; i < 2; i++) {
+	lp = i == 0 ? ED_label(e) : ED_xlabel(e);
+	if (!lp || (i == 1 && !lp->set))
+	    continue;
+	lb.LL.x = lp->pos.x - lp->dimen.x / 2.;
+	lb.LL.y = lp->pos.y - lp->dimen.y / 2.;
+	lb.UR.x = lp->pos.x + lp->dimen.x / 2.;
+	lb.UR.y = lp->pos.y + lp->dimen.y / 2.;
+	if (have)
+	    EXPANDBB(bb, lb);
+	else
+	    bb = lb;
+	have = true;
+    }
+    /* edge_in_box can never be true */
+    if (!have)
+	return;
+    boxes[*n] = bb;
+    ix->objs[(*n)++] = e;
+}
+
+/* mk_emit_index:
+ * Index the nodes and edges of g in the order emit_view visits them for
+ * the given flags. Returns NULL for orders that are not a single walk of
+ * the root graph. Uses ND_state, so must be called before it is reset.
+ */
+static emit_index_t *mk_emit_index(graph_t * g, int flags)
+{
+    emit_index_t *ix;
+    boxf *boxes;
+    size_t n = 0, sz;
+    node_t *np;
+    edge_t *e;
+    int pass;
+
+    if (flags & EMIT_PREORDER)
+	return NULL;
+
+    sz = (size_t)agnnodes(g) + (size_t)agnedges(g);
+    ix = NEW(emit_index_t);
+    ix->g = g;
+    ix->flags = flags & EMIT_INDEX_FLAGS;
+    ix->objs = N_NEW(sz ? sz : 1, void *);
+    boxes = N_NEW(sz ? sz : 1, boxf);
+    for (np = agfstnode(g); np; np = agnxtnode(g, np))
+	ND_state(np) = 0;
+
+    if (flags & (EMIT_SORTED | EMIT_EDGE_SORTED)) {
+	for (pass = 0; pass < 2; pass++) {
+	    if ((pass == 0) == !!(flags & EMIT_SORTED)) {
+		for (np = agfstnode(g); np; np = agnxtnode(g, np))
+		    index_node(ix, boxes, &n, np);
+	    }
+	    else {
+		for (np = agfstnode(g); np; np = agnxtnode(g, np))
+		    for (e = agfstout(g, np); e; e = agnxtout(g, e))
+			index_edge(ix, boxes, &n, e);
+	    }
+	}
+    }
+    else {
+	for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
+	    index_node(ix, boxes, &n, np);
+	    for (e = agfstout(g, np); e; e = agnxtout(g, e)) {
+		index_node(ix, boxes, &n, aghead(e));
+		index_edge(ix, boxes, &n, e);
+	    }
+	}
+    }
+
+    ix->index = boxindex_new(boxes, n);
+    ix->found = N_NEW(n ? n : 1, size_t);
+    free(boxes);
+    return ix;
+}
+
+/* partial_view:
+ * True if the job's view, once emit_graph has converted it to graph units,
+ * shows only part of the drawing.
+ */
+static bool partial_view(GVJ_t * job)
+{
+    return job->view.x < job->bb.UR.x - job->bb.LL.x - EPSILON
+	|| job->view.y < job->bb.UR.y - job->bb.LL.y - EPSILON;
+}
+
+static void free_emit_index(emit_index_t *ix)
+{
+    if (!ix)
+	return;
+    boxindex_free(ix->index);
+    free(ix->objs);
+    free(ix->found);
+    free(ix);
+}
+
+/* emit_index_release:
+ * Free the index kept in the context for rendering several outputs of
+ * one layout, and stop keeping one.
+ */
+void emit_index_release(GVC_t * gvc)
+{
+    free_emit_index(gvc->emit_index);
+    gvc->emit_index = NULL;
+    gvc->keep_emit_index = FALSE;
+}
+
+static void emit_indexed_obj(GVJ_t * job, void *obj)
+{
+    if (agobjkind(obj) == AGNODE)
+	emit_node(job, obj);
+    else
+	emit_edge(job, obj);
+}
+
+/* emit_indexed:
+ * Emit the indexed nodes and edges that may lie in the current clip box.
+ */
+static void emit_indexed(GVJ_t * job, emit_index_t *ix, int flags)
+{
+    size_t i = 0, nfound;
+    bool nodes;
+    int pass;
+
+    nfound = boxindex_search(ix->index, job->clip, ix->found);
+    if (!(flags & (EMIT_SORTED | EMIT_EDGE_SORTED))) {
+	for (i = 0; i < nfound; i++)
+	    emit_indexed_obj(job, ix->objs[ix->found[i]]);
+	return;
+    }
+
+    /* the results are all nodes then all edges, or the other way round */
+    for (pass = 0; pass < 2; pass++) {
+	nodes = (pass == 0) == !!(flags & EMIT_SORTED);
+	if (nodes)
+	    gvrender_begin_nodes(job);
+	else
+	    gvrender_begin_edges(job);
+	for (; i < nfound; i++) {
+	    void *obj = ix->objs[ix->found[i]];
+	    if ((agobjkind(obj) == AGNODE) != nodes)
+		break;
+	    emit_indexed_obj(job, obj);
+	}
+	if (nodes)
+	    gvrender_end_nodes(job);
+	else
+	    gvrender_end_edges(job);
+    }
+}
+
+static void emit_view(GVJ_t * job, graph_t * g, int flags, emit_index_t *ix)
 {
     GVC_t * gvc = job->gvc;
     node_t *n;
@@ -3321,7 +3554,9 @@ static void emit_view(GVJ_t * job, graph_t * g, int flags)
     /* when drawing, lay clusters down before nodes and edges */
     if (!(flags & EMIT_CLUSTERS_LAST))
 	emit_clusters(job, g, flags);
-    if (flags & EMIT_SORTED) {
+    if (ix) {
+	emit_indexed(job, ix, flags);
+    } else if (flags & EMIT_SORTED) {
 	/* output all nodes, then all edges */
 	gvrender_begin_nodes(job);
 	for (n = agfstnode(g); n; n = agnxtnode(g, n))
@@ -3396,7 +3631,7 @@ static void emit_end_graph(GVJ_t * job, graph_t * g)
 
 #define NotFirstPage(j) (((j)->layerNum>1)||((j)->pagesArrayElem.x > 0)||((j)->pagesArrayElem.x > 0))
 
-static void emit_page(GVJ_t * job, graph_t * g)
+static void emit_page(GVJ_t * job, graph_t * g, emit_index_t *ix)
 {
     obj_state_t *obj = job->obj;
     int nump = 0, flags = job->flags;
@@ -3463,7 +3698,7 @@ static void emit_page(GVJ_t * job, graph_t * g)
 	emit_label(job, EMIT_GLABEL, GD_label(g));
     if (!(flags & EMIT_CLUSTERS_LAST) && (obj->url || obj->explicit_tooltip))
 	gvrender_end_anchor(job);
-    emit_view(job,g,flags);
+    emit_view(job,g,flags,ix);
     gvrender_end_page(job);
     if (saveid) {
 	agxbfree(&xb);
@@ -3471,13 +3706,12 @@ static void emit_page(GVJ_t * job, graph_t * g)
     }
 }
 
-void emit_graph(GVJ_t * job, graph_t * g)
+/* init_job_scale:
+ * Set the scale factors of the job for its zoom and dpi, and its view in
+ * graph units from its size in device units.
+ */
+static void init_job_scale(GVJ_t * job)
 {
-    node_t *n;
-    char *s;
-    int flags = job->flags;
-    int* lp;
-
     /* device dpi is now known */
     job->scale.x = job->zoom * job->dpi.x / POINTS_PER_INCH;
     job->scale.y = job->zoom * job->dpi.y / POINTS_PER_INCH;
@@ -3496,6 +3730,18 @@ void emit_graph(GVJ_t * job, graph_t * g)
 	job->view.x = job->width / job->scale.x;
 	job->view.y = job->height / job->scale.y;
     }
+}
+
+/* emit_document:
+ * Emit g from begin_graph to end_graph. If one_page is set, only the
+ * current page of each layer is emitted, otherwise all its pages.
+ */
+static void emit_document(GVJ_t * job, graph_t * g, emit_index_t *ix,
+                          bool one_page)
+{
+    node_t *n;
+    char *s;
+    int* lp;
 
     s = late_string(g, agattr(g, AGRAPH, "comment", 0), "");
     gvrender_comment(job, s);
@@ -3503,7 +3749,7 @@ void emit_graph(GVJ_t * job, graph_t * g)
     job->layerNum = 0;
     emit_begin_graph(job, g);
 
-    if (flags & EMIT_COLORS)
+    if (job->flags & EMIT_COLORS)
 	emit_colors(job,g);
 
     /* reset node state */
@@ -3515,8 +3761,12 @@ void emit_graph(GVJ_t * job, graph_t * g)
 	    gvrender_begin_layer(job);
 
 	/* iterate pages */
-	for (firstpage(job); validpage(job); nextpage(job))
-	    emit_page(job, g);
+	if (one_page)
+	    emit_page(job, g, ix);
+	else {
+	    for (firstpage(job); validpage(job); nextpage(job))
+		emit_page(job, g, ix);
+	}
 
 	if (numPhysicalLayers (job) > 1)
 	    gvrender_end_layer(job);
@@ -3524,6 +3774,41 @@ void emit_graph(GVJ_t * job, graph_t * g)
     emit_end_graph(job, g);
 }
 
+void emit_graph(GVJ_t * job, graph_t * g)
+{
+    int flags = job->flags;
+    emit_index_t *ix = NULL;
+
+    init_job_scale(job);
+
+    job->lod = late_double(g, agattr(g, AGRAPH, "lod", 0), 0.0, 0.0);
+
+    /* with many pages, or many views of one layout, find the contents of
+     * each through an index
+     */
+    ix = job->gvc->emit_index;
+    if (ix && (ix->g != g || ix->flags != (flags & EMIT_INDEX_FLAGS)))
+	ix = NULL;
+    else if (ix && Verbose)
+	fprintf(stderr, "%s: reusing the emit index\n", job->output_langname);
+    if (!ix && (job->numPages > 1
+		|| (job->gvc->keep_emit_index && partial_view(job)))) {
+	ix = mk_emit_index(g, flags);
+	if (ix && Verbose)
+	    fprintf(stderr, "%s: built the emit index\n", job->output_langname);
+	if (job->gvc->keep_emit_index) {
+	    free_emit_index(job->gvc->emit_index);
+	    job->gvc->emit_index = ix;
+	}
+    }
+
+    emit_document(job, g, ix, false);
+    if (ix != job->gvc->emit_index)
+	free_emit_index(ix);
+}
+
+static void style_cache_close(void);
+
 /* support for stderr_once */
 static void free_string_entry(Dict_t * dict, char *key, Dtdisc_t * disc)
 {
@@ -3560,6 +3845,7 @@ void emit_once_reset(void)
 	dtclose(strings);
 	strings = 0;
     }
+    style_cache_close();
 }
 
 static void emit_begin_cluster(GVJ_t * job, Agraph_t * sg)
@@ -3798,13 +4084,74 @@ static int style_token(char **s, agxbuf * xb)
 static unsigned char outbuf[SMALLBUF];
 static agxbuf ps_xb;
 
+/* Parsed styles, keyed on the style string. The same few styles are
+ * parsed for every node and edge of a graph, so parse_style keeps the
+ * result of each successful parse and hands out copies of it.
+ */
+typedef struct {
+    Dtlink_t link;
+    char *style;	/* key */
+    char **parse;	/* NULL terminated, pointing into the same block */
+} style_cache_t;
+
+/* maximum number of cached styles before the cache is flushed */
+#define STYLE_CACHE_MAX 1000
+
+static void free_style_entry(Dt_t *dt, void *obj, Dtdisc_t *disc)
+{
+    free(obj);
+}
+
+static Dt_t *style_cache;
+static Dtdisc_t style_cache_disc = {
+    offsetof(style_cache_t, style),
+    -1,				/* key is a null-terminated string */
+    offsetof(style_cache_t, link),
+    NIL(Dtmake_f),
+    free_style_entry,
+    NIL(Dtcompar_f),
+    NIL(Dthash_f),
+    NIL(Dtmemory_f),
+    NIL(Dtevent_f)
+};
+
+/* cache_style:
+ * Copy the nfun parsed functions, whose text is the first len bytes of
+ * ps_xb, into a new cache entry for style s.
+ */
+static style_cache_t *cache_style(char *s, char **parse, int nfun, size_t len)
+{
+    size_t slen = strlen(s) + 1;
+    style_cache_t *e;
+    char *text;
+    int i;
+
+    if (!style_cache)
+	style_cache = dtopen(&style_cache_disc, Dtset);
+    if (dtsize(style_cache) >= STYLE_CACHE_MAX)
+	dtclear(style_cache);
+
+    e = gmalloc(sizeof(style_cache_t) + (nfun + 1) * sizeof(char *) + slen + len);
+    e->parse = (char **)(e + 1);
+    text = (char *)(e->parse + nfun + 1);
+    memcpy(text, agxbstart(&ps_xb), len);
+    for (i = 0; i < nfun; i++)
+	e->parse[i] = text + (parse[i] - agxbstart(&ps_xb));
+    e->parse[nfun] = NULL;
+    e->style = text + len;
+    memcpy(e->style, s, slen);
+    dtinsert(style_cache, e);
+    return e;
+}
+
 /* parse_style:
  * This is one of the worst internal designs in graphviz.
  * The use of '\0' characters within strings seems cute but it
  * makes all of the standard functions useless if not dangerous.
- * Plus the function uses static memory for both the array and
- * the character buffer. One hopes all of the values are used
- * before the function is called again.
+ * Plus the function uses static memory for the array. One hopes all
+ * of the values are used before the function is called again.
+ * Callers may reorder the array, so it is a copy of the cached one;
+ * the strings it points to stay valid until the next call.
  */
 char **parse_style(char *s)
 {
@@ -3815,8 +4162,15 @@ char **parse_style(char *s)
     unsigned char buf[SMALLBUF];
     char *p;
     int c;
+    size_t off[FUNLIMIT];
+    style_cache_t *cached;
     agxbuf xb;
 
+    if (style_cache && (cached = dtmatch(style_cache, s))) {
+	for (fun = 0; (parse[fun] = cached->parse[fun]); fun++);
+	return parse;
+    }
+
     if (is_first) {
 	agxbinit(&ps_xb, SMALLBUF, outbuf);
 	is_first = false;
@@ -3855,7 +4209,8 @@ char **parse_style(char *s)
 		    return parse;
 		}
 		agxbputc(&ps_xb, '\0');	/* terminate previous */
-		parse[fun++] = agxbnext(&ps_xb);
+		/* record offsets, as the buffer may move as it grows */
+		off[fun++] = (size_t)agxblen(&ps_xb);
 	    }
 	    agxbput(&ps_xb, agxbuse(&xb));
 	    agxbputc(&ps_xb, '\0');
@@ -3868,12 +4223,28 @@ char **parse_style(char *s)
 	agxbfree(&xb);
 	return parse;
     }
-    parse[fun] = NULL;
     agxbfree(&xb);
-    (void)agxbuse(&ps_xb);		/* adds final '\0' to buffer */
+    agxbputc(&ps_xb, '\0');
+    for (c = 0; c < fun; c++)
+	parse[c] = agxbstart(&ps_xb) + off[c];
+    parse[fun] = NULL;
+
+    /* only styles that parsed without complaint are cached, so that
+     * the diagnostics above are still given for every use */
+    cached = cache_style(s, parse, fun, (size_t)agxblen(&ps_xb));
+    (void)agxbuse(&ps_xb);
+    for (fun = 0; (parse[fun] = cached->parse[fun]); fun++);
     return parse;
 }
 
+static void style_cache_close(void)
+{
+    if (style_cache) {
+	dtclose(style_cache);
+	style_cache = NULL;
+    }
+}
+
 static boxf bezier_bb(bezier bz)
 {
     int i;
@@ -4010,6 +4381,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 {
     static GVJ_t *prevjob;
     GVJ_t *job, *firstjob;
+    int njobs = 0;
+    bool share_index;
 
     if (Verbose)
 	start_timer();
@@ -4024,6 +4397,13 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
     init_gvc(gvc, g);
     init_layering(gvc, g);
 
+    /* several outputs of one layout share the spatial index, if any */
+    for (job = gvc->jobs; job; job = job->next)
+	njobs++;
+    share_index = njobs > 1 && !gvc->keep_emit_index;
+    if (share_index)
+	gvc->keep_emit_index = TRUE;
+
     gv_fixLocale (1);
     for (job = gvjobs_first(gvc); job; job = gvjobs_next(gvc)) {
 	if (gvc->gvg) {
@@ -4041,6 +4421,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	if (!GD_drawing(g)) {
 	    agerr (AGERR, "layout was not done\n");
 	    gv_fixLocale (0);
+	    if (share_index)
+		emit_index_release(gvc);
 	    FINISH();
 	    return -1;
 	}
@@ -4049,6 +4431,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
         if (job->output_lang == NO_SUPPORT) {
             agerr (AGERR, "renderer for %s is unavailable\n", job->output_langname);
 	    gv_fixLocale (0);
+	    if (share_index)
+		emit_index_release(gvc);
 	    FINISH();
             return -1;
         }
@@ -4113,11 +4497,134 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
          */
 	prevjob = job;
     }
+    if (share_index)
+	emit_index_release(gvc);
     gv_fixLocale (0);
     FINISH();
     return 0;
 }
 
+/* tiles_across:
+ * Number of tiles of side span needed to cover a drawing of the given
+ * length, at least one, and at most n.
+ */
+static int tiles_across(double length, double span, int n)
+{
+    int i;
+
+    for (i = 1; i < n && i * span < length; i++)
+	;
+    return i;
+}
+
+/* emit_tiles:
+ * Render g, which has been laid out, as a pyramid of square tiles of
+ * tilesize points, for levels 0 to maxlevel. At level z the drawing,
+ * anchored at its top left corner, is scaled so that its larger side spans
+ * 2^z tiles. The level is paginated into one page per tile, and the page
+ * loop writes each page to a file of its own, <prefix>_<z>_<x>_<y>.<ext>,
+ * counting x rightwards and y downwards from 0. Tiles that fall outside the
+ * drawing are not written. The job is set up, and the graph indexed, once
+ * for all tiles. Returns the number of tiles written, or -1 on error.
+ */
+int emit_tiles(GVJ_t * job, graph_t * g, const char *prefix, const char *ext,
+               int maxlevel, int tilesize)
+{
+    GVC_t *gvc = job->gvc;
+    emit_index_t *ix;
+    boxf bb;
+    double side, span;
+    int z, n, count = 0;
+    size_t len;
+    char *filename;
+
+    if (job->output_lang == NO_SUPPORT || (job->flags & GVDEVICE_EVENTS)) {
+	agerr(AGERR, "tiles cannot be rendered for %s\n", job->output_langname);
+	return -1;
+    }
+
+    init_bb(g);
+    init_gvc(gvc, g);
+    init_layering(gvc, g);
+
+    job->input_filename = NULL;
+    job->graph_index = 0;
+    job->common = &(gvc->common);
+    job->layout_type = gvc->layout.type;
+    job->flags |= job->output_lang == VTX ? EMIT_SORTED : chkOrder(g);
+    job->callbacks = &gvdevice_callbacks;
+
+    gv_fixLocale (1);
+    init_job_pad(job);
+
+    /* tiles are sized in pixels, so draw one point per pixel, and tiles
+     * are cut from the drawing, so leave out margins and rotation
+     */
+    job->dpi.x = job->dpi.y = POINTS_PER_INCH;
+    job->margin.x = job->margin.y = 0;
+    job->rotation = 0;
+    job->width = job->height = tilesize;
+    job->canvasBox.LL.x = job->canvasBox.LL.y = 0;
+    job->canvasBox.UR.x = job->canvasBox.UR.y = tilesize;
+    job->pageBoundingBox.LL.x = job->pageBoundingBox.LL.y = 0;
+    job->pageBoundingBox.UR.x = job->pageBoundingBox.UR.y = tilesize;
+    job->bb.LL.x = gvc->bb.LL.x - job->pad.x;
+    job->bb.LL.y = gvc->bb.LL.y - job->pad.y;
+    job->bb.UR.x = gvc->bb.UR.x + job->pad.x;
+    job->bb.UR.y = gvc->bb.UR.y + job->pad.y;
+    job->lod = late_double(g, agattr(g, AGRAPH, "lod", 0), 0.0, 0.0);
+
+    bb = GD_bb(g);
+    side = fmax(bb.UR.x - bb.LL.x, bb.UR.y - bb.LL.y);
+    if (side <= 0)
+	side = 1;
+
+    /* every tile of every level shows part of the same drawing */
+    ix = mk_emit_index(g, job->flags);
+
+    len = strlen(prefix) + strlen(ext) + 3 * 12 + 5;
+    filename = N_NEW(len, char);
+
+    for (z = 0; z <= maxlevel && count >= 0; z++) {
+	n = 1 << z;
+	span = side / n;	/* tile side in graph units */
+
+	/* one page per tile, from the top row down, left to right */
+	job->pagesArraySize.x = tiles_across(bb.UR.x - bb.LL.x, span, n);
+	job->pagesArraySize.y = tiles_across(bb.UR.y - bb.LL.y, span, n);
+	job->numPages = job->pagesArraySize.x * job->pagesArraySize.y;
+	job->pagesArrayFirst.x = job->pagesArrayFirst.y = 0;
+	job->pagesArrayMajor = pagecode(job, 'T');
+	job->pagesArrayMinor = pagecode(job, 'L');
+	job->pageSize.x = job->pageSize.y = span;
+
+	job->zoom = tilesize / span;
+	job->focus.x = bb.LL.x + job->pagesArraySize.x * span / 2;
+	job->focus.y = bb.UR.y - job->pagesArraySize.y * span / 2;
+	init_job_scale(job);
+
+	for (firstpage(job); validpage(job); nextpage(job)) {
+	    snprintf(filename, len, "%s_%d_%d_%d.%s", prefix, z,
+		     job->pagesArrayElem.x,
+		     job->pagesArraySize.y - 1 - job->pagesArrayElem.y, ext);
+	    job->output_filename = filename;
+	    job->output_file = NULL;
+	    if (gvrender_begin_job(job)) {
+		count = -1;
+		break;
+	    }
+	    emit_document(job, g, ix, true);
+	    gvrender_end_job(job);
+	    count++;
+	}
+    }
+
+    free(filename);
+    free_emit_index(ix);
+    gv_fixLocale (0);
+    return count;
+}
+
 /* findStopColor:
  * Check for colon in colorlist. If one exists, and not the first
  * character, store the characters before the colon in clrs[0] and
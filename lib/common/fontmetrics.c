@@ -0,0 +1,404 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* Reader for Adobe Font Metrics (AFM) files, used to estimate the size of
+ * text when no textlayout plugin is available. Only the advance widths of
+ * the ISO Latin-1 glyphs and the horizontal pair kerning are kept.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/fontmetrics.h>
+
+#ifdef _WIN32
+#define PATHSEP ";"
+#else
+#define PATHSEP ":"
+#endif
+
+#define NCHARS 256
+
+struct fontmetrics_s {
+    char *path;              /* file the metrics were read from */
+    double widths[NCHARS];   /* advance widths at size 1, < 0 if missing */
+    double dflt;             /* width used for missing characters */
+    short *kern;             /* NCHARS x NCHARS kerning, in 1/1000 em */
+};
+
+/* glyph names of ISO Latin-1, as in PostScript's ISOLatin1Encoding */
+static const char *latin1_glyphs[NCHARS] = {
+    [32] = "space", "exclam", "quotedbl", "numbersign", "dollar", "percent",
+    "ampersand", "quotesingle", "parenleft", "parenright", "asterisk", "plus",
+    "comma", "hyphen", "period", "slash", "zero", "one", "two", "three",
+    "four", "five", "six", "seven", "eight", "nine", "colon", "semicolon",
+    "less", "equal", "greater", "question", "at", "A", "B", "C", "D", "E",
+    "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P", "Q", "R", "S",
+    "T", "U", "V", "W", "X", "Y", "Z", "bracketleft", "backslash",
+    "bracketright", "asciicircum", "underscore", "grave", "a", "b", "c", "d",
+    "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o", "p", "q", "r",
+    "s", "t", "u", "v", "w", "x", "y", "z", "braceleft", "bar", "braceright",
+    "asciitilde",
+    [160] = "space", "exclamdown", "cent", "sterling", "currency", "yen",
+    "brokenbar", "section", "dieresis", "copyright", "ordfeminine",
+    "guillemotleft", "logicalnot", "hyphen", "registered", "macron",
+    "degree", "plusminus", "twosuperior", "threesuperior", "acute", "mu",
+    "paragraph", "periodcentered", "cedilla", "onesuperior", "ordmasculine",
+    "guillemotright", "onequarter", "onehalf", "threequarters",
+    "questiondown", "Agrave", "Aacute", "Acircumflex", "Atilde", "Adieresis",
+    "Aring", "AE", "Ccedilla", "Egrave", "Eacute", "Ecircumflex",
+    "Edieresis", "Igrave", "Iacute", "Icircumflex", "Idieresis", "Eth",
+    "Ntilde", "Ograve", "Oacute", "Ocircumflex", "Otilde", "Odieresis",
+    "multiply", "Oslash", "Ugrave", "Uacute", "Ucircumflex", "Udieresis",
+    "Yacute", "Thorn", "germandbls", "agrave", "aacute", "acircumflex",
+    "atilde", "adieresis", "aring", "ae", "ccedilla", "egrave", "eacute",
+    "ecircumflex", "edieresis", "igrave", "iacute", "icircumflex",
+    "idieresis", "eth", "ntilde", "ograve", "oacute", "ocircumflex",
+    "otilde", "odieresis", "divide", "oslash", "ugrave", "uacute",
+    "ucircumflex", "udieresis", "yacute", "thorn", "ydieresis",
+};
+
+/* glyph_codes:
+ * Store the Latin-1 codes of glyph name in codes, returning their number.
+ * A name can have more than one code, e.g. space and no-break space.
+ */
+static int glyph_codes(const char *name, unsigned char codes[2])
+{
+    int i, n = 0;
+
+    for (i = 32; i < NCHARS && n < 2; i++) {
+	if (latin1_glyphs[i] && !strcmp(latin1_glyphs[i], name))
+	    codes[n++] = (unsigned char)i;
+    }
+    return n;
+}
+
+/* afm_value:
+ * Find the value of the given key in a ';' separated AFM metrics line
+ * such as "C 32 ; WX 250 ; N space ; B 0 0 0 0 ;".
+ * The value is copied to buf. Returns false if the key is not present.
+ */
+static bool afm_value(const char *line, const char *key, char *buf, size_t bufsz)
+{
+    size_t keylen = strlen(key);
+    const char *p = line;
+
+    while (*p) {
+	size_t n;
+	p += strspn(p, " \t");
+	if (!strncmp(p, key, keylen) && (p[keylen] == ' ' || p[keylen] == '\t')) {
+	    p += keylen;
+	    p += strspn(p, " \t");
+	    n = strcspn(p, " \t;\r\n");
+	    if (n == 0 || n >= bufsz)
+		return false;
+	    memcpy(buf, p, n);
+	    buf[n] = '\0';
+	    return true;
+	}
+	p += strcspn(p, ";");
+	if (*p == ';')
+	    p++;
+    }
+    return false;
+}
+
+static void add_char_metrics(fontmetrics_t *fm, const char *line, bool *byname)
+{
+    char buf[128];
+    unsigned char codes[2];
+    double w;
+    int code, i, n;
+
+    if (!afm_value(line, "WX", buf, sizeof(buf))
+	&& !afm_value(line, "W0X", buf, sizeof(buf)))
+	return;
+    w = atof(buf) / 1000.0;
+
+    if (afm_value(line, "N", buf, sizeof(buf))
+	&& (n = glyph_codes(buf, codes)) > 0) {
+	for (i = 0; i < n; i++) {
+	    fm->widths[codes[i]] = w;
+	    byname[codes[i]] = true;
+	}
+	return;
+    }
+
+    /* Fonts with their own encoding, such as Symbol, use glyph names we do
+     * not know. Fall back to the character code, unless a glyph with a
+     * known name already claimed it.
+     */
+    if (afm_value(line, "C", buf, sizeof(buf))) {
+	code = atoi(buf);
+	if (code >= 32 && code < NCHARS && !byname[code])
+	    fm->widths[code] = w;
+    }
+}
+
+static void add_kern_pair(fontmetrics_t *fm, const char *line)
+{
+    char name1[128], name2[128];
+    unsigned char codes1[2], codes2[2];
+    double x;
+    int i, j, n1, n2;
+
+    if (sscanf(line, "KPX %127s %127s %lf", name1, name2, &x) != 3
+	&& sscanf(line, "KP %127s %127s %lf", name1, name2, &x) != 3)
+	return;
+    if (!(n1 = glyph_codes(name1, codes1)) || !(n2 = glyph_codes(name2, codes2)))
+	return;
+    if (!fm->kern && !(fm->kern = calloc(NCHARS * NCHARS, sizeof(short))))
+	return;
+    for (i = 0; i < n1; i++)
+	for (j = 0; j < n2; j++)
+	    fm->kern[codes1[i] * NCHARS + codes2[j]] = (short)x;
+}
+
+/* afm_read:
+ * Parse the AFM file at path. Returns NULL if it cannot be opened, is
+ * not an AFM file or memory runs out.
+ */
+static fontmetrics_t *afm_read(const char *path)
+{
+    char line[1024];
+    bool byname[NCHARS] = {false};
+    bool in_chars = false, in_kern = false;
+    fontmetrics_t *fm;
+    FILE *fp;
+    int i;
+
+    if (!(fp = fopen(path, "r")))
+	return NULL;
+    if (!fgets(line, sizeof(line), fp)
+	|| strncmp(line, "StartFontMetrics", 16)) {
+	fclose(fp);
+	return NULL;
+    }
+
+    if (!(fm = calloc(1, sizeof(fontmetrics_t)))) {
+	fclose(fp);
+	return NULL;
+    }
+    for (i = 0; i < NCHARS; i++)
+	fm->widths[i] = -1;
+
+    while (fgets(line, sizeof(line), fp)) {
+	if (!strncmp(line, "StartCharMetrics", 16))
+	    in_chars = true;
+	else if (!strncmp(line, "EndCharMetrics", 14))
+	    in_chars = false;
+	else if (!strncmp(line, "StartKernPairs", 14))
+	    in_kern = true;
+	else if (!strncmp(line, "EndKernPairs", 12))
+	    in_kern = false;
+	else if (in_chars)
+	    add_char_metrics(fm, line, byname);
+	else if (in_kern)
+	    add_kern_pair(fm, line);
+    }
+    fclose(fp);
+
+    /* stand in for missing characters with a typical lower case letter */
+    fm->dflt = fm->widths['n'] >= 0 ? fm->widths['n'] : 0.5;
+    if (!(fm->path = strdup(path))) {
+	free(fm->kern);
+	free(fm);
+	return NULL;
+    }
+    return fm;
+}
+
+/* afm_search:
+ * Look for <name>.afm in the directories of fontpath.
+ */
+static fontmetrics_t *afm_search(const char *fontpath, const char *name)
+{
+    char *dirs, *dir, *path;
+    fontmetrics_t *fm = NULL;
+
+    /* font names come from the input graph; do not let them name a file
+     * outside of the font path
+     */
+    if (strchr(name, '/') || strchr(name, '\\'))
+	return NULL;
+
+    if (!(dirs = strdup(fontpath)))
+	return NULL;
+    for (dir = strtok(dirs, PATHSEP); dir && !fm; dir = strtok(NULL, PATHSEP)) {
+	if (!(path = malloc(strlen(dir) + strlen(name) + sizeof("/.afm"))))
+	    break;
+	sprintf(path, "%s/%s.afm", dir, name);
+	fm = afm_read(path);
+	free(path);
+    }
+    free(dirs);
+    return fm;
+}
+
+typedef struct fontmetrics_cache_s {
+    char *fontpath;
+    char *name;
+    fontmetrics_t *fm;       /* NULL if the font was not found */
+    struct fontmetrics_cache_s *next;
+} fontmetrics_cache_t;
+
+/* drop_misses:
+ * Remove the entries of fonts that were not found.
+ */
+static void drop_misses(fontmetrics_cache_t **cache)
+{
+    fontmetrics_cache_t *c;
+
+    while ((c = *cache)) {
+	if (c->fm) {
+	    cache = &c->next;
+	    continue;
+	}
+	*cache = c->next;
+	free(c->fontpath);
+	free(c->name);
+	free(c);
+    }
+}
+
+fontmetrics_t *fontmetrics_find(const char *fontpath, const char *name)
+{
+    static fontmetrics_cache_t *cache;
+    static char *miss_path;  /* search path the misses in cache are for */
+    fontmetrics_cache_t *c;
+    fontmetrics_t *fm;
+
+    if (!fontpath || !name || !*name)
+	return NULL;
+
+    /* fonts that were not found are only remembered for one search path,
+     * so that a font installed since is found once the path changes
+     */
+    if (!miss_path || strcmp(miss_path, fontpath)) {
+	drop_misses(&cache);
+	free(miss_path);
+	miss_path = strdup(fontpath);
+    }
+
+    for (c = cache; c; c = c->next) {
+	if (!strcmp(c->name, name) && !strcmp(c->fontpath, fontpath))
+	    return c->fm;
+    }
+
+    fm = afm_search(fontpath, name);
+    if (!(c = malloc(sizeof(fontmetrics_cache_t))))
+	return fm;
+    c->fontpath = strdup(fontpath);
+    c->name = strdup(name);
+    if (!c->fontpath || !c->name) {
+	free(c->fontpath);
+	free(c->name);
+	free(c);
+	return fm;
+    }
+    c->fm = fm;
+    c->next = cache;
+    cache = c;
+    return fm;
+}
+
+const char *fontmetrics_path(const fontmetrics_t *fm)
+{
+    return fm->path;
+}
+
+/* next_char:
+ * Decode the next character of UTF-8 string *s and advance *s past it.
+ * Bytes that do not start a valid sequence are taken as Latin-1.
+ */
+static unsigned int next_char(const char **s)
+{
+    const unsigned char *p = (const unsigned char *)*s;
+    unsigned int c = p[0];
+    int i, len;
+
+    if (c < 0x80)
+	len = 1;
+    else if ((c & 0xE0) == 0xC0) {
+	len = 2;
+	c &= 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+	len = 3;
+	c &= 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+	len = 4;
+	c &= 0x07;
+    } else {
+	*s += 1;
+	return c;
+    }
+    for (i = 1; i < len; i++) {
+	if ((p[i] & 0xC0) != 0x80) {
+	    *s += 1;
+	    return p[0];
+	}
+	c = (c << 6) | (p[i] & 0x3F);
+    }
+    *s += len;
+    return c;
+}
+
+/* is_wide:
+ * True for East Asian characters that are drawn a full em wide.
+ */
+static bool is_wide(unsigned int c)
+{
+    return (c >= 0x1100 && c <= 0x115F)
+	|| (c >= 0x2E80 && c <= 0xA4CF)
+	|| (c >= 0xAC00 && c <= 0xD7A3)
+	|| (c >= 0xF900 && c <= 0xFAFF)
+	|| (c >= 0xFE30 && c <= 0xFE4F)
+	|| (c >= 0xFF00 && c <= 0xFF60)
+	|| (c >= 0xFFE0 && c <= 0xFFE6)
+	|| (c >= 0x20000 && c <= 0x3FFFD);
+}
+
+double fontmetrics_width(const fontmetrics_t *fm, const char *str)
+{
+    double w = 0;
+    unsigned int c, prev = NCHARS;
+
+    while (*str) {
+	c = next_char(&str);
+	if (c < NCHARS) {
+	    w += fm->widths[c] >= 0 ? fm->widths[c] : fm->dflt;
+	    if (fm->kern && prev < NCHARS)
+		w += fm->kern[prev * NCHARS + c] / 1000.0;
+	} else if (is_wide(c))
+	    w += 1.0;
+	else
+	    w += fm->dflt;
+	prev = c;
+    }
+    return w;
+}
+
+double fontmetrics_table_width(const double *widths, const char *str)
+{
+    double w = 0;
+    unsigned int c;
+
+    while (*str) {
+	c = next_char(&str);
+	if (c < NCHARS)
+	    w += widths[c];
+	else if (is_wide(c))
+	    w += 1.0;
+	else
+	    w += widths['n'];
+    }
+    return w;
+}
@@ -0,0 +1,56 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/// @file
+/// @brief font metrics for estimating text size without a textlayout plugin
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fontmetrics_s fontmetrics_t;
+
+/** find the metrics for a font
+ *
+ * Looks for an Adobe Font Metrics file `<name>.afm` in the directories listed
+ * in `fontpath`. Fonts that are found are kept for the life of the process,
+ * by search path and name, so that each is read only once. Fonts that are
+ * not found are remembered until the search path changes, e.g. by a change
+ * of `GDFONTPATH`, and then looked for again.
+ *
+ * TrueType and OpenType fonts are not read.
+ *
+ * @param fontpath Directories to search, separated as in `PATH`
+ * @param name PostScript or family name of the font
+ * @return Metrics for the font or NULL if no usable AFM file was found
+ */
+fontmetrics_t *fontmetrics_find(const char *fontpath, const char *name);
+
+/// path of the file the metrics were read from
+const char *fontmetrics_path(const fontmetrics_t *fm);
+
+/** width of a UTF-8 string at font size 1, including pair kerning
+ *
+ * Characters outside ISO Latin-1, and those the font has no metrics for, are
+ * given the width of an average character, or of a full em for East Asian
+ * wide characters.
+ */
+double fontmetrics_width(const fontmetrics_t *fm, const char *str);
+
+/** width of a UTF-8 string at font size 1, using a table of advance widths
+ * indexed by ISO Latin-1 code
+ */
+double fontmetrics_table_width(const double *widths, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
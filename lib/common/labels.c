@@ -223,6 +223,10 @@ void emit_label(GVJ_t * job, emit_state_t emit_state, textlabel_t * lp)
     pointf p;
     emit_state_t old_emit_state;
 
+    /* text too small to read at this zoom is left out */
+    if (job->lod > 0 && lp->fontsize * job->zoom < job->lod)
+	return;
+
     old_emit_state = obj->emit_state;
     obj->emit_state = emit_state;
 
@@ -101,6 +101,9 @@ extern "C" {
     /* RENDER_API void emit_begin_edge(GVJ_t * job, edge_t * e, char**); */
     /* RENDER_API void emit_end_edge(GVJ_t * job); */
     RENDER_API void emit_graph(GVJ_t * job, graph_t * g);
+    RENDER_API void emit_index_release(GVC_t * gvc);
+    RENDER_API int emit_tiles(GVJ_t * job, graph_t * g, const char *prefix,
+			      const char *ext, int maxlevel, int tilesize);
     RENDER_API void emit_label(GVJ_t * job, emit_state_t emit_state, textlabel_t *);
     RENDER_API int emit_once(char *message);
     RENDER_API void emit_map_rect(GVJ_t *job, boxf b);
@@ -1822,21 +1822,329 @@ boolean isPolygon(node_t * n)
     return (ND_shape(n) && (ND_shape(n)->fns->initfn == poly_init));
 }
 
+/* poly_vertices:
+ * Generate the vertices of all peripheries of a polygon shape scaled to fit
+ * bb, and at least width by height. On return, sides is 2 for ellipses and
+ * bb is the size of the outer periphery.
+ */
+static pointf *poly_vertices(poly_desc_t *pd, int peripheries, int *sidesp,
+			     double orientation, double distortion,
+			     double skew, boolean isBox, double width,
+			     double height, pointf *bbp)
+{
+    pointf P, Q, R, bb = *bbp;
+    pointf *vertices;
+    double temp, alpha, beta, gamma;
+    double sectorangle, sidelength, skewdist, gdistortion, gskew;
+    double angle, sinx, cosx, xmax, ymax, scalex, scaley;
+    int i, j, outp, sides = *sidesp;
+
+    outp = peripheries;
+    if (peripheries < 1)
+	outp = 1;
+    if (sides < 3) {		/* ellipses */
+	sides = 2;
+	vertices = N_NEW(outp * sides, pointf);
+	P.x = bb.x / 2.;
+	P.y = bb.y / 2.;
+	vertices[0].x = -P.x;
+	vertices[0].y = -P.y;
+	vertices[1] = P;
+	if (peripheries > 1) {
+	    for (j = 1, i = 2; j < peripheries; j++) {
+		P.x += GAP;
+		P.y += GAP;
+		vertices[i].x = -P.x;
+		vertices[i].y = -P.y;
+		i++;
+		vertices[i].x = P.x;
+		vertices[i].y = P.y;
+		i++;
+	    }
+	    bb.x = 2. * P.x;
+	    bb.y = 2. * P.y;
+	}
+    } else {
+
+/*
+ * FIXME - this code is wrong - it doesn't work for concave boundaries.
+ *          (e.g. "folder"  or "promoter")
+ *   I don't think it even needs sectorangle, or knowledge of skewed shapes.
+ *   (Concepts that only work for convex regular (modulo skew/distort) polygons.)
+ *
+ *   I think it only needs to know inside v. outside (by always drawing
+ *   boundaries clockwise, say),  and the two adjacent segments.
+ *
+ *   It needs to find the point where the two lines, parallel to
+ *   the current segments, and outside by GAP distance, intersect.   
+ */
+
+	vertices = N_NEW(outp * sides, pointf);
+	if (pd) {
+	    pd->vertex_gen (vertices, &bb);
+	    xmax = bb.x/2;
+	    ymax = bb.y/2;
+	} else {
+	    sectorangle = 2. * M_PI / sides;
+	    sidelength = sin(sectorangle / 2.);
+	    skewdist = hypot(fabs(distortion) + fabs(skew), 1.);
+	    gdistortion = distortion * SQRT2 / cos(sectorangle / 2.);
+	    gskew = skew / 2.;
+	    angle = (sectorangle - M_PI) / 2.;
+	    sincos(angle, &sinx, &cosx);
+	    R.x = .5 * cosx;
+	    R.y = .5 * sinx;
+	    xmax = ymax = 0.;
+	    angle += (M_PI - sectorangle) / 2.;
+	    for (i = 0; i < sides; i++) {
+
+	    /*next regular vertex */
+		angle += sectorangle;
+		sincos(angle, &sinx, &cosx);
+		R.x += sidelength * cosx;
+		R.y += sidelength * sinx;
+
+	    /*distort and skew */
+		P.x = R.x * (skewdist + R.y * gdistortion) + R.y * gskew;
+		P.y = R.y;
+
+	    /*orient P.x,P.y */
+		alpha = RADIANS(orientation) + atan2(P.y, P.x);
+		sincos(alpha, &sinx, &cosx);
+		P.x = P.y = hypot(P.x, P.y);
+		P.x *= cosx;
+		P.y *= sinx;
+
+	    /*scale for label */
+		P.x *= bb.x;
+		P.y *= bb.y;
+
+	    /*find max for bounding box */
+		xmax = MAX(fabs(P.x), xmax);
+		ymax = MAX(fabs(P.y), ymax);
+
+	    /* store result in array of points */
+		vertices[i] = P;
+		if (isBox) { /* enforce exact symmetry of box */
+		    vertices[1].x = -P.x;
+		    vertices[1].y = P.y;
+		    vertices[2].x = -P.x;
+		    vertices[2].y = -P.y;
+		    vertices[3].x = P.x;
+		    vertices[3].y = -P.y;
+		    break;
+		}
+	    }
+	}
+
+	/* apply minimum dimensions */
+	xmax *= 2.;
+	ymax *= 2.;
+	bb.x = MAX(width, xmax);
+	bb.y = MAX(height, ymax);
+	scalex = bb.x / xmax;
+	scaley = bb.y / ymax;
+
+	for (i = 0; i < sides; i++) {
+	    P = vertices[i];
+	    P.x *= scalex;
+	    P.y *= scaley;
+	    vertices[i] = P;
+	}
+
+	if (peripheries > 1) {
+	    Q = vertices[(sides - 1)];
+	    R = vertices[0];
+	    beta = atan2(R.y - Q.y, R.x - Q.x);
+	    for (i = 0; i < sides; i++) {
+
+		/*for each vertex find the bisector */
+		P = Q;
+		Q = R;
+		R = vertices[(i + 1) % sides];
+		alpha = beta;
+		beta = atan2(R.y - Q.y, R.x - Q.x);
+		gamma = (alpha + M_PI - beta) / 2.;
+
+		/*find distance along bisector to */
+		/*intersection of next periphery */
+		temp = GAP / sin(gamma);
+
+		/*convert this distance to x and y */
+		sincos((alpha - gamma), &sinx, &cosx);
+		sinx *= temp;
+		cosx *= temp;
+
+		/*save the vertices of all the */
+		/*peripheries at this base vertex */
+		for (j = 1; j < peripheries; j++) {
+		    Q.x += cosx;
+		    Q.y += sinx;
+		    vertices[i + j * sides] = Q;
+		}
+	    }
+	    for (i = 0; i < sides; i++) {
+		P = vertices[i + (peripheries - 1) * sides];
+		bb.x = MAX(2. * fabs(P.x), bb.x);
+		bb.y = MAX(2. * fabs(P.y), bb.y);
+	    }
+	}
+    }
+    *sidesp = sides;
+    *bbp = bb;
+    return vertices;
+}
+
+/* lines through the sides of a polygon, for inside tests */
+typedef struct {
+    double a, b, c;		/* a x + b y = c */
+    boolean origin;		/* whether a x + b y >= c holds at (0,0) */
+} side_t;
+
+/* poly_sides:
+ * Compute the lines through the sides of the polygon given by vertex.
+ * These are the lines same_side would compute from the vertices.
+ */
+static void poly_sides(side_t *side, pointf *vertex, int sides)
+{
+    pointf L0, L1;
+    int i;
+
+    for (i = 0; i < sides; i++) {
+	L0 = vertex[i];
+	L1 = vertex[(i + 1) % sides];
+	side[i].a = -(L1.y - L0.y);
+	side[i].b = (L1.x - L0.x);
+	side[i].c = side[i].a * L0.x + side[i].b * L0.y;
+	side[i].origin = (side[i].c <= 0);
+    }
+}
+
+/* everything the geometry of a polygon shape depends on */
+typedef struct {
+    poly_desc_t *desc;		/* vertex generator of the shape, if any */
+    int regular, peripheries, sides, option;
+    double orientation, distortion, skew;
+    double width, height;	/* minimum size */
+    pointf bb;			/* size needed by the label */
+} polykey_t;
+
+/* Nodes of the same shape and size share one read-only polygon_t, flagged
+ * with SHAREDSHAPE and counted by the nodes using it.
+ */
+typedef struct {
+    polygon_t poly;		/* first, so that poly_free can cast back */
+    Dtlink_t link;
+    polykey_t key;
+    /* non key */
+    pointf bb;			/* size of the outer periphery */
+    side_t *side;		/* sides of the outer periphery */
+    int refcnt;
+} polyshape_t;
+
+static Dtdisc_t polyshape_disc = {
+    offsetof(polyshape_t, key),
+    sizeof(polykey_t),		/* compared with memcmp */
+    offsetof(polyshape_t, link),
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static Dt_t *polyshapes;	/* polyshape_t in use */
+
+/* poly_fill:
+ * Fill in poly for the shape described by key, and set bb to its size.
+ */
+static void poly_fill(polygon_t *poly, const polykey_t *key, boolean isBox,
+		      pointf *bbp)
+{
+    int sides = key->sides;
+
+    *bbp = key->bb;
+    poly->vertices = poly_vertices(key->desc, key->peripheries, &sides,
+				   key->orientation, key->distortion,
+				   key->skew, isBox, key->width, key->height,
+				   bbp);
+    poly->regular = key->regular;
+    poly->peripheries = key->peripheries;
+    poly->sides = sides;
+    poly->orientation = key->orientation;
+    poly->skew = key->skew;
+    poly->distortion = key->distortion;
+    poly->option = key->option;
+}
+
+/* outer_periphery:
+ * Return the index of the first vertex of the outer periphery of poly.
+ */
+static int outer_periphery(polygon_t *poly)
+{
+    int outp = (poly->peripheries - 1) * poly->sides;
+
+    return outp < 0 ? 0 : outp;
+}
+
+/* polyshape_acquire:
+ * Return the shared polygon for key, making it if needed, and set bb
+ * to its size. The key must be zeroed before it is filled in, as it is
+ * compared bytewise.
+ */
+static polygon_t *polyshape_acquire(const polykey_t *key, boolean isBox,
+				    pointf *bbp)
+{
+    polyshape_t *ps;
+
+    if (!polyshapes)
+	polyshapes = dtopen(&polyshape_disc, Dtoset);
+    if (!(ps = dtmatch(polyshapes, key))) {
+	ps = NEW(polyshape_t);
+	memcpy(&ps->key, key, sizeof(ps->key));
+	poly_fill(&ps->poly, key, isBox, &ps->bb);
+	ps->poly.option |= SHAREDSHAPE;
+	if (ps->poly.sides > 2) {
+	    ps->side = N_NEW(ps->poly.sides, side_t);
+	    poly_sides(ps->side, ps->poly.vertices + outer_periphery(&ps->poly),
+		       ps->poly.sides);
+	}
+	dtinsert(polyshapes, ps);
+    }
+    ps->refcnt++;
+    *bbp = ps->bb;
+    return &ps->poly;
+}
+
+static void polyshape_release(polygon_t *poly)
+{
+    polyshape_t *ps = (polyshape_t *) poly;
+
+    if (--ps->refcnt > 0)
+	return;
+    dtdelete(polyshapes, ps);
+    free(ps->side);
+    free(ps->poly.vertices);
+    free(ps);
+    if (dtsize(polyshapes) == 0) {
+	dtclose(polyshapes);
+	polyshapes = NULL;
+    }
+}
+
 static void poly_init(node_t * n)
 {
     pointf dimen, min_bb, bb;
     point imagesize;
-    pointf P, Q, R;
-    pointf *vertices;
     char *p, *sfile, *fxd;
-    double temp, alpha, beta, gamma;
+    double temp;
     double orientation, distortion, skew;
-    double sectorangle, sidelength, skewdist, gdistortion, gskew;
-    double angle, sinx, cosx, xmax, ymax, scalex, scaley;
     double width, height, marginx, marginy, spacex;
     int regular, peripheries, sides;
-    int i, j, isBox, outp;
-    polygon_t *poly = NEW(polygon_t);
+    int i, isBox, option = 0;
+    polykey_t key;
+    polygon_t *poly;
     boolean isPlain = IS_PLAIN(n);
 
     regular = ND_shape(n)->polygon->regular;
@@ -2006,7 +2314,7 @@ static void poly_init(node_t * n)
     if ((*fxd == 's') && streq(fxd,"shape")) {
 	bb.x = width;
 	bb.y = height;
-	poly->option |= FIXEDSHAPE;
+	option |= FIXEDSHAPE;
     } else if (mapbool(fxd)) {
 	/* check only label, as images we can scale to fit */
 	if ((width < ND_label(n)->dimen.x) || (height < ND_label(n)->dimen.y))
@@ -2042,174 +2350,33 @@ static void poly_init(node_t * n)
 	ND_label(n)->space.x = dimen.x - spacex;
     }
 
-    if ((poly->option & FIXEDSHAPE) == 0) {
+    if ((option & FIXEDSHAPE) == 0) {
 	temp = bb.y - min_bb.y;
 	if (dimen.y < imagesize.y)
 	    temp += imagesize.y - dimen.y;
 	ND_label(n)->space.y = dimen.y + temp;
     }
 
-    outp = peripheries;
-    if (peripheries < 1)
-	outp = 1;
-    if (sides < 3) {		/* ellipses */
-	sides = 2;
-	vertices = N_NEW(outp * sides, pointf);
-	P.x = bb.x / 2.;
-	P.y = bb.y / 2.;
-	vertices[0].x = -P.x;
-	vertices[0].y = -P.y;
-	vertices[1] = P;
-	if (peripheries > 1) {
-	    for (j = 1, i = 2; j < peripheries; j++) {
-		P.x += GAP;
-		P.y += GAP;
-		vertices[i].x = -P.x;
-		vertices[i].y = -P.y;
-		i++;
-		vertices[i].x = P.x;
-		vertices[i].y = P.y;
-		i++;
-	    }
-	    bb.x = 2. * P.x;
-	    bb.y = 2. * P.y;
-	}
-    } else {
-
-/*
- * FIXME - this code is wrong - it doesn't work for concave boundaries.
- *          (e.g. "folder"  or "promoter")
- *   I don't think it even needs sectorangle, or knowledge of skewed shapes.
- *   (Concepts that only work for convex regular (modulo skew/distort) polygons.)
- *
- *   I think it only needs to know inside v. outside (by always drawing
- *   boundaries clockwise, say),  and the two adjacent segments.
- *
- *   It needs to find the point where the two lines, parallel to
- *   the current segments, and outside by GAP distance, intersect.   
- */
-
-	vertices = N_NEW(outp * sides, pointf);
-	if (ND_shape(n)->polygon->vertices) {
-	    poly_desc_t* pd = (poly_desc_t*)ND_shape(n)->polygon->vertices;
-	    pd->vertex_gen (vertices, &bb);
-	    xmax = bb.x/2;
-	    ymax = bb.y/2;
-	} else {
-	    sectorangle = 2. * M_PI / sides;
-	    sidelength = sin(sectorangle / 2.);
-	    skewdist = hypot(fabs(distortion) + fabs(skew), 1.);
-	    gdistortion = distortion * SQRT2 / cos(sectorangle / 2.);
-	    gskew = skew / 2.;
-	    angle = (sectorangle - M_PI) / 2.;
-	    sincos(angle, &sinx, &cosx);
-	    R.x = .5 * cosx;
-	    R.y = .5 * sinx;
-	    xmax = ymax = 0.;
-	    angle += (M_PI - sectorangle) / 2.;
-	    for (i = 0; i < sides; i++) {
-
-	    /*next regular vertex */
-		angle += sectorangle;
-		sincos(angle, &sinx, &cosx);
-		R.x += sidelength * cosx;
-		R.y += sidelength * sinx;
-
-	    /*distort and skew */
-		P.x = R.x * (skewdist + R.y * gdistortion) + R.y * gskew;
-		P.y = R.y;
-
-	    /*orient P.x,P.y */
-		alpha = RADIANS(orientation) + atan2(P.y, P.x);
-		sincos(alpha, &sinx, &cosx);
-		P.x = P.y = hypot(P.x, P.y);
-		P.x *= cosx;
-		P.y *= sinx;
-
-	    /*scale for label */
-		P.x *= bb.x;
-		P.y *= bb.y;
-
-	    /*find max for bounding box */
-		xmax = MAX(fabs(P.x), xmax);
-		ymax = MAX(fabs(P.y), ymax);
-
-	    /* store result in array of points */
-		vertices[i] = P;
-		if (isBox) { /* enforce exact symmetry of box */
-		    vertices[1].x = -P.x;
-		    vertices[1].y = P.y;
-		    vertices[2].x = -P.x;
-		    vertices[2].y = -P.y;
-		    vertices[3].x = P.x;
-		    vertices[3].y = -P.y;
-		    break;
-		}
-	    }
-	}
-
-	/* apply minimum dimensions */
-	xmax *= 2.;
-	ymax *= 2.;
-	bb.x = MAX(width, xmax);
-	bb.y = MAX(height, ymax);
-	scalex = bb.x / xmax;
-	scaley = bb.y / ymax;
-
-	for (i = 0; i < sides; i++) {
-	    P = vertices[i];
-	    P.x *= scalex;
-	    P.y *= scaley;
-	    vertices[i] = P;
-	}
-
-	if (peripheries > 1) {
-	    Q = vertices[(sides - 1)];
-	    R = vertices[0];
-	    beta = atan2(R.y - Q.y, R.x - Q.x);
-	    for (i = 0; i < sides; i++) {
-
-		/*for each vertex find the bisector */
-		P = Q;
-		Q = R;
-		R = vertices[(i + 1) % sides];
-		alpha = beta;
-		beta = atan2(R.y - Q.y, R.x - Q.x);
-		gamma = (alpha + M_PI - beta) / 2.;
-
-		/*find distance along bisector to */
-		/*intersection of next periphery */
-		temp = GAP / sin(gamma);
-
-		/*convert this distance to x and y */
-		sincos((alpha - gamma), &sinx, &cosx);
-		sinx *= temp;
-		cosx *= temp;
-
-		/*save the vertices of all the */
-		/*peripheries at this base vertex */
-		for (j = 1; j < peripheries; j++) {
-		    Q.x += cosx;
-		    Q.y += sinx;
-		    vertices[i + j * sides] = Q;
-		}
-	    }
-	    for (i = 0; i < sides; i++) {
-		P = vertices[i + (peripheries - 1) * sides];
-		bb.x = MAX(2. * fabs(P.x), bb.x);
-		bb.y = MAX(2. * fabs(P.y), bb.y);
-	    }
-	}
-    }
-    poly->regular = regular;
-    poly->peripheries = peripheries;
-    poly->sides = sides;
-    poly->orientation = orientation;
-    poly->skew = skew;
-    poly->distortion = distortion;
-    poly->vertices = vertices;
+    memset(&key, 0, sizeof(key));
+    key.desc = (poly_desc_t*)ND_shape(n)->polygon->vertices;
+    key.regular = regular;
+    key.peripheries = peripheries;
+    key.sides = sides;
+    key.option = option;
+    key.orientation = orientation;
+    key.distortion = distortion;
+    key.skew = skew;
+    key.width = width;
+    key.height = height;
+    key.bb = bb;
+    if (IS_CLUST_NODE(n)) {
+	/* fdp resizes these in place, so they get a polygon of their own */
+	poly = NEW(polygon_t);
+	poly_fill(poly, &key, isBox, &bb);
+    } else
+	poly = polyshape_acquire(&key, isBox, &bb);
 
-    if (poly->option & FIXEDSHAPE) {
+    if (option & FIXEDSHAPE) {
 	/* set width and height to reflect label and shape */
 	ND_width(n) = PS2INCH(MAX(dimen.x,bb.x));
 	ND_height(n) = PS2INCH(MAX(dimen.y,bb.y));
@@ -2225,6 +2392,10 @@ static void poly_free(node_t * n)
     polygon_t *p = ND_shape_info(n);
 
     if (p) {
+	if (p->option & SHAREDSHAPE) {
+	    polyshape_release(p);
+	    return;
+	}
 	free(p->vertices);
 	free(p);
     }
@@ -2245,10 +2416,14 @@ static boolean poly_inside(inside_t * inside_context, pointf p)
     static int last, outp, sides;
     static pointf O;		/* point (0,0) */
     static pointf *vertex;
+    static side_t *side;	/* sides of the outer periphery */
+    static side_t *sidebuf;	/* for polygons that are not shared */
+    static int sidebufsz;
     static double xsize, ysize, scalex, scaley, box_URx, box_URy;
 
     int i, i1, j, s;
     pointf P, Q, R;
+    side_t *sd;
     boxf *bp;
     node_t *n;
 
@@ -2309,9 +2484,17 @@ static boolean poly_inside(inside_t * inside_context, pointf p)
 	box_URy = n_height / 2.0;
 
 	/* index to outer-periphery */
-	outp = (poly->peripheries - 1) * sides;
-	if (outp < 0)
-	    outp = 0;
+	outp = outer_periphery(poly);
+	if (poly->option & SHAREDSHAPE)
+	    side = ((polyshape_t *) poly)->side;
+	else if (sides > 2) {
+	    if (sides > sidebufsz) {
+		sidebuf = ALLOC(sides, sidebuf, side_t);
+		sidebufsz = sides;
+	    }
+	    poly_sides(sidebuf, vertex + outp, sides);
+	    side = sidebuf;
+	}
 	lastn = n;
     }
 
@@ -2332,7 +2515,8 @@ static boolean poly_inside(inside_t * inside_context, pointf p)
     i1 = (i + 1) % sides;
     Q = vertex[i + outp];
     R = vertex[i1 + outp];
-    if (!(same_side(P, O, Q, R)))   /* false if outside the segment's face */
+    sd = &side[i];
+    if ((sd->a * P.x + sd->b * P.y - sd->c >= 0) != sd->origin)   /* false if outside the segment's face */
 	return FALSE;
     /* else inside the segment face... */
     if ((s = same_side(P, Q, R, O)) && (same_side(P, R, O, Q))) /* true if between the segment's sides */
@@ -2346,7 +2530,8 @@ static boolean poly_inside(inside_t * inside_context, pointf p)
 	    i1 = i;
 	    i = (i + sides - 1) % sides;
 	}
-	if (!(same_side(P, O, vertex[i + outp], vertex[i1 + outp]))) { /* false if outside any other segment's face */
+	sd = &side[i];
+	if ((sd->a * P.x + sd->b * P.y - sd->c >= 0) != sd->origin) { /* false if outside any other segment's face */
 	    last = i;
 	    return FALSE;
 	}
@@ -0,0 +1,169 @@
+// basic unit tester for the AFM reader and text width estimates
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// include fontmetrics.c so we can be compiled standalone
+#include <common/fontmetrics.c>
+
+// directory to write font files into, from the command line
+static const char *dir;
+
+// an empty directory inside it
+static char empty[1024];
+
+static const char afm[] =
+    "StartFontMetrics 4.1\n"
+    "FontName Test\n"
+    "StartCharMetrics 7\n"
+    "C 32 ; WX 250 ; N space ; B 0 0 0 0 ;\n"
+    "C 65 ; WX 722 ; N A ; B 15 0 706 674 ;\n"
+    "C 86 ; WX 700 ; N V ; B 16 -11 697 662 ;\n"
+    "C 110 ; WX 500 ; N n ; B 16 0 485 460 ;\n"
+    "C -1 ; WX 444 ; N eacute ; B 25 -10 424 678 ;\n"
+    "C 200 ; WX 333 ; N notinlatin1 ;\n"
+    "C 201 ; W0X 600 ; N alsonotinlatin1 ;\n"
+    "EndCharMetrics\n"
+    "StartKernData\n"
+    "StartKernPairs 2\n"
+    "KPX A V -80\n"
+    "KPX eacute A -20\n"
+    "EndKernPairs\n"
+    "EndKernData\n"
+    "EndFontMetrics\n";
+
+static void write_file(const char *name, const char *content) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *f = fopen(path, "w");
+  assert(f != NULL);
+  fputs(content, f);
+  fclose(f);
+}
+
+static int close_to(double a, double b) { return fabs(a - b) < 1e-9; }
+
+// widths and kerning should be read from the file
+static void test_parse(void) {
+  write_file("Test.afm", afm);
+  fontmetrics_t *fm = fontmetrics_find(dir, "Test");
+  assert(fm != NULL);
+
+  const char *path = fontmetrics_path(fm);
+  assert(strlen(path) > strlen("/Test.afm"));
+  assert(strcmp(path + strlen(path) - strlen("/Test.afm"), "/Test.afm") == 0);
+
+  assert(close_to(fontmetrics_width(fm, ""), 0));
+  assert(close_to(fontmetrics_width(fm, "A"), 0.722));
+  assert(close_to(fontmetrics_width(fm, "A V"), 0.722 + 0.250 + 0.700));
+
+  // pair kerning applies in one order only
+  assert(close_to(fontmetrics_width(fm, "AV"), 0.722 + 0.700 - 0.080));
+  assert(close_to(fontmetrics_width(fm, "VA"), 0.700 + 0.722));
+
+  // glyphs with unknown names are placed by their code, W0X counts too
+  assert(close_to(fontmetrics_width(fm, "\xc3\x88"), 0.333));
+  assert(close_to(fontmetrics_width(fm, "\xc3\x89"), 0.600));
+
+  // characters the font has no metrics for get the width of an "n"
+  assert(close_to(fontmetrics_width(fm, "x"), 0.500));
+}
+
+// UTF-8 should be decoded before looking up widths
+static void test_utf8(void) {
+  fontmetrics_t *fm = fontmetrics_find(dir, "Test");
+  assert(fm != NULL);
+
+  // é is 2 bytes, but one glyph, found by name and kerned with what follows
+  assert(close_to(fontmetrics_width(fm, "\xc3\xa9"), 0.444));
+  assert(close_to(fontmetrics_width(fm, "\xc3\xa9" "A"), 0.444 + 0.722 - 0.020));
+
+  // no-break space has the same glyph as space
+  assert(close_to(fontmetrics_width(fm, "\xc2\xa0"), 0.250));
+
+  // East Asian wide characters are a full em, others outside Latin-1 an "n"
+  assert(close_to(fontmetrics_width(fm, "\xe4\xb8\xad"), 1.0));
+  assert(close_to(fontmetrics_width(fm, "\xf0\xa0\x80\x80"), 1.0));
+  assert(close_to(fontmetrics_width(fm, "\xe2\x86\x92"), 0.500));
+
+  // a byte that does not start a valid sequence is taken as Latin-1
+  assert(close_to(fontmetrics_width(fm, "\xe9" "A"), 0.444 + 0.722 - 0.020));
+  assert(close_to(fontmetrics_width(fm, "\xc3"), 0.500));
+
+  // the built-in tables decode UTF-8 the same way
+  double widths[256];
+  for (int i = 0; i < 256; ++i)
+    widths[i] = i / 1000.0;
+  assert(close_to(fontmetrics_table_width(widths, "\xc3\xa9"), 0.233));
+  assert(close_to(fontmetrics_table_width(widths, "a\xe4\xb8\xad"), 1.097));
+  assert(close_to(fontmetrics_table_width(widths, "\xe2\x86\x92"), 0.110));
+}
+
+// lookups depend on the search path, and failures are remembered per path
+static void test_find(void) {
+  assert(fontmetrics_find(NULL, "Test") == NULL);
+  assert(fontmetrics_find(dir, NULL) == NULL);
+  assert(fontmetrics_find(dir, "") == NULL);
+
+  // the same font is read once
+  assert(fontmetrics_find(dir, "Test") == fontmetrics_find(dir, "Test"));
+
+  // but not found where it is not
+  assert(fontmetrics_find(empty, "Test") == NULL);
+
+  // every directory of the path is searched
+  char path[2100];
+  snprintf(path, sizeof(path), "%s%s%s", empty, PATHSEP, dir);
+  assert(fontmetrics_find(path, "Test") != NULL);
+
+  // font names cannot reach outside the search path
+  snprintf(path, sizeof(path), "%s/..", empty);
+  assert(fontmetrics_find(path, "Test") != NULL);
+  assert(fontmetrics_find(empty, "../Test") == NULL);
+
+  // files that are not AFM are ignored
+  write_file("NotAFM.afm", "this is not a font\n");
+  assert(fontmetrics_find(dir, "NotAFM") == NULL);
+
+  // a font that is not found is not looked for again on the same path
+  assert(fontmetrics_find(dir, "Later") == NULL);
+  write_file("Later.afm", afm);
+  assert(fontmetrics_find(dir, "Later") == NULL);
+
+  // but it is once the search path has changed
+  assert(fontmetrics_find(empty, "Later") == NULL);
+  assert(fontmetrics_find(dir, "Later") != NULL);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s directory empty-subdirectory\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  dir = argv[1];
+  snprintf(empty, sizeof(empty), "%s/%s", dir, argv[2]);
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(parse);
+  RUN(utf8);
+  RUN(find);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <cdt/cdt.h>
 #include <common/render.h>
+#include <common/fontmetrics.h>
 #include <cgraph/strcasecmp.h>
 
 static double timesFontWidth[] = {
@@ -120,12 +121,16 @@ static double courFontWidth[] = {
 
 /* estimate_textspan_size:
  * Estimate size of textspan, for given face and size, in points.
+ * Metrics from an AFM file for the font are used if one can be found,
+ * otherwise built-in tables for Times, Courier and Arial.
  */
 static void
 estimate_textspan_size(textspan_t * span, char **fontpath)
 {
     double *Fontwidth, fontsize;
-    char c, *p, *fpp, *fontname;
+    char *fpp, *fontname;
+    const char *searchpath;
+    fontmetrics_t *fm = NULL;
 
     fontname = span->font->name;
     fontsize = span->font->size;
@@ -137,6 +142,27 @@ estimate_textspan_size(textspan_t * span, char **fontpath)
     span->layout = NULL;
     span->free_layout = NULL;
 
+    searchpath = getenv("GDFONTPATH");
+#ifdef DEFAULT_FONTPATH
+    if (!searchpath)
+	searchpath = DEFAULT_FONTPATH;
+#endif
+    /* a server should not probe the file system on behalf of its clients */
+    if (HTTPServerEnVar)
+	searchpath = NULL;
+
+    if (span->font->postscript_alias)
+	fm = fontmetrics_find(searchpath, span->font->postscript_alias->name);
+    if (!fm)
+	fm = fontmetrics_find(searchpath, fontname);
+    if (fm) {
+	if (fontpath)
+	    *fontpath = (char *)fontmetrics_path(fm);
+	if (span->str)
+	    span->size.x = fontmetrics_width(fm, span->str) * fontsize;
+	return;
+    }
+
     if (!strncasecmp(fontname, "cour", 4)) {
 	fpp = "[internal courier]";
 	Fontwidth = courFontWidth;
@@ -150,13 +176,11 @@ estimate_textspan_size(textspan_t * span, char **fontpath)
     }
     if (fontpath)
 	*fontpath = fpp;
-    if ((p = span->str)) {
-	while ((c = *p++))
-	    span->size.x += Fontwidth[(unsigned char) c];
+    if (span->str) {
  	/* NOTE: Tables are based on a font of size 1. Need to multiply by
  	 * fontsize to get appropriate value.
  	 */
-	span->size.x *= fontsize;
+	span->size.x = fontmetrics_table_width(Fontwidth, span->str) * fontsize;
     }
 }
 
@@ -187,10 +211,79 @@ static PostscriptAlias* translate_postscript_fontname(char* fontname)
     return result;
 }
 
+/* Cache of text measurements, keyed by everything that affects them. The
+ * same label strings tend to repeat across nodes and graphs, and measuring
+ * through a textlayout plugin is expensive.
+ */
+typedef struct {
+    /* key */
+    char *fontname;
+    char *fontpath;	/* GDFONTPATH, or "" */
+    double fontsize;
+    unsigned int flags;
+    char *str;
+
+    /* non key */
+    pointf size;
+    double yoffset_layout, yoffset_centerline;
+} textspan_cache_t;
+
+/* maximum number of cached measurements before the cache is flushed */
+#define TEXTSPAN_CACHE_MAX 50000
+
+static void* textspan_cache_makef(Dt_t* dt, void* obj, Dtdisc_t* disc)
+{
+    textspan_cache_t *c1 = obj;
+    textspan_cache_t *c2 = malloc(sizeof(textspan_cache_t));
+
+    if (!c2)
+	return NULL;
+    *c2 = *c1;
+    c2->fontname = strdup(c1->fontname);
+    c2->fontpath = strdup(c1->fontpath);
+    c2->str = strdup(c1->str);
+    if (!c2->fontname || !c2->fontpath || !c2->str) {
+	free(c2->fontname);
+	free(c2->fontpath);
+	free(c2->str);
+	free(c2);
+	return NULL;
+    }
+    return c2;
+}
+
+static void textspan_cache_freef(Dt_t* dt, void* obj, Dtdisc_t* disc)
+{
+    textspan_cache_t *c = obj;
+
+    free(c->fontname);
+    free(c->fontpath);
+    free(c->str);
+    free(c);
+}
+
+static int textspan_cache_comparf(Dt_t* dt, void* key1, void* key2, Dtdisc_t* disc)
+{
+    int rc;
+    textspan_cache_t *c1 = key1, *c2 = key2;
+
+    rc = strcmp(c1->str, c2->str);
+    if (rc) return rc;
+    rc = strcmp(c1->fontname, c2->fontname);
+    if (rc) return rc;
+    rc = strcmp(c1->fontpath, c2->fontpath);
+    if (rc) return rc;
+    if (c1->flags != c2->flags) return c1->flags < c2->flags ? -1 : 1;
+    if (c1->fontsize < c2->fontsize) return -1;
+    if (c1->fontsize > c2->fontsize) return 1;
+    return 0;
+}
+
 pointf textspan_size(GVC_t *gvc, textspan_t * span)
 {
     char **fpp = NULL, *fontpath = NULL;
     textfont_t *font;
+    textspan_cache_t key, *cached = NULL;
 
     assert(span->font);
     font = span->font;
@@ -201,12 +294,46 @@ pointf textspan_size(GVC_t *gvc, textspan_t * span)
     if (! font->postscript_alias) 
         font->postscript_alias = translate_postscript_fontname(font->name);
 
+    if (gvc->textspan_cache && span->str) {
+	key.fontname = font->name;
+	/* the graph's fontpath reaches the plugins through GDFONTPATH */
+	key.fontpath = getenv("GDFONTPATH");
+	if (!key.fontpath)
+	    key.fontpath = "";
+	key.fontsize = font->size;
+	key.flags = font->flags;
+	key.str = span->str;
+	cached = dtsearch(gvc->textspan_cache, &key);
+	if (cached) {
+	    gvc->textspan_cache_hits++;
+	    /* Renderers that need a layout object from the textlayout plugin
+	     * (cairo, lasi) create it themselves if it is missing.
+	     */
+	    span->layout = NULL;
+	    span->free_layout = NULL;
+	    span->size = cached->size;
+	    span->yoffset_layout = cached->yoffset_layout;
+	    span->yoffset_centerline = cached->yoffset_centerline;
+	    return span->size;
+	}
+	gvc->textspan_cache_misses++;
+    }
+
     if (Verbose && emit_once(font->name))
 	fpp = &fontpath;
 
     if (! gvtextlayout(gvc, span, fpp))
 	estimate_textspan_size(span, fpp);
 
+    if (gvc->textspan_cache && span->str) {
+	if (dtsize(gvc->textspan_cache) >= TEXTSPAN_CACHE_MAX)
+	    dtclear(gvc->textspan_cache);
+	key.size = span->size;
+	key.yoffset_layout = span->yoffset_layout;
+	key.yoffset_centerline = span->yoffset_centerline;
+	dtinsert(gvc->textspan_cache, &key);
+    }
+
     if (fpp) {
 	if (fontpath)
 	    fprintf(stderr, "fontname: \"%s\" resolved to: %s\n",
@@ -272,10 +399,22 @@ Dt_t * textfont_dict_open(GVC_t *gvc)
 {
     DTDISC(&(gvc->textfont_disc),0,sizeof(textfont_t),-1,textfont_makef,textfont_freef,textfont_comparf,NULL,NULL,NULL);
     gvc->textfont_dt = dtopen(&(gvc->textfont_disc), Dtoset);
+
+    DTDISC(&(gvc->textspan_cache_disc),0,sizeof(textspan_cache_t),-1,textspan_cache_makef,textspan_cache_freef,textspan_cache_comparf,NULL,NULL,NULL);
+    gvc->textspan_cache = dtopen(&(gvc->textspan_cache_disc), Dtoset);
+    gvc->textspan_cache_hits = gvc->textspan_cache_misses = 0;
+
     return gvc->textfont_dt;
 }
 
 void textfont_dict_close(GVC_t *gvc)
 {
     dtclose(gvc->textfont_dt);
+    if (gvc->textspan_cache) {
+	if (Verbose)
+	    fprintf(stderr, "text measurement cache: %lu hits, %lu misses\n",
+		    gvc->textspan_cache_hits, gvc->textspan_cache_misses);
+	dtclose(gvc->textspan_cache);
+	gvc->textspan_cache = NULL;
+    }
 }
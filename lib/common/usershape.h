@@ -11,6 +11,7 @@
 #pragma once
 
 #include "cdt.h"
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +58,9 @@ extern "C" {
 	void *data;                   /* data loaded by a renderer */
 	size_t datasize;              /* size of data (if mmap'ed) */
 	void (*datafree)(usershape_t *us); /* renderer's function for freeing data */
+	time_t mtime;                 /* modification time and size of the file */
+	long long filesize;           /*  when it was read */
+	unsigned int checked;         /* layout at which the file was last checked */
     };
 
 #ifdef __cplusplus
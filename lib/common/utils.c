@@ -71,33 +71,28 @@ node_t *dequeue(nodequeue * q)
 
 int late_int(void *obj, attrsym_t * attr, int def, int low)
 {
-    char *p;
-    char *endp;
+    long v;
     int rv;
     if (attr == NULL)
 	return def;
-    p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-	return def;
-    rv = strtol (p, &endp, 10);
-    if (p == endp) return def;  /* invalid int format */
+    /* parsed once per distinct value, see agxgetlong */
+    if (agxgetlong(obj, attr, &v) != 0)
+	return def;  /* empty or invalid int format */
+    rv = v;
     if (rv < low) return low;
     else return rv;
 }
 
 double late_double(void *obj, attrsym_t * attr, double def, double low)
 {
-    char *p;
-    char *endp;
     double rv;
 
     if (!attr || !obj)
 	return def;
-    p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-	return def;
-    rv = strtod (p, &endp);
-    if (p == endp) return def;  /* invalid double format */
+    /* parsed once per distinct value and LC_NUMERIC decimal point,
+     * see agxgetdouble */
+    if (agxgetdouble(obj, attr, &rv) != 0)
+	return def;  /* empty or invalid double format */
     if (rv < low) return low;
     else return rv;
 }
@@ -16,144 +16,62 @@
  * Support for grid to speed up layout. On each pass, nodes are
  * put into grid cells. Given a node, repulsion is only computed 
  * for nodes in one of that nodes 9 adjacent grids.
+ *
+ * Cells are kept in a flat array sorted by (i,j), and the nodes of
+ * each cell are stored contiguously, so walking the grid and looking
+ * up neighboring cells touches memory sequentially and needs no
+ * per-cell allocation.
  */
 
-/* uses PRIVATE interface for NOTUSED */
-#define FDP_PRIVATE 1
-
 #include <fdpgen/fdp.h>
 #include <fdpgen/grid.h>
 #include <common/macros.h>
-#include <stddef.h>
-
-  /* structure for maintaining a free list of cells */
-typedef struct _block {
-    cell *mem;			/* block of cells */
-    cell *cur;			/* next available cell */
-    cell *endp;			/* after last cell */
-    struct _block *next;	/* next memory block */
-} block_t;
-
-/* newBlock:
- * Create new block of size cells
- */
-static block_t *newBlock(int size)
-{
-    block_t *newb;
+#include <stdbool.h>
+#include <stdlib.h>
 
-    newb = GNEW(block_t);
-    newb->next = 0;
-    newb->mem = N_GNEW(size, cell);
-    newb->endp = newb->mem + size;
-    newb->cur = newb->mem;
-
-    return newb;
-}
-
-/* freeBlock:
- * Free malloc'ed memory and block.
- * Recurse to next block
- */
-static void freeBlock(block_t * b)
-{
-    if (b) {
-	block_t *next = b->next;
-	free(b->mem);
-	free(b);
-	freeBlock(next);
-    }
-}
+  /* node as added to the grid, before cells are formed */
+typedef struct {
+    gridpt p;			/* index of cell */
+    int seq;			/* order of insertion */
+    Agnode_t *node;
+} item_t;
 
 struct _grid {
-    Dt_t *data;			/* cells indexed by (i,j) */
-    block_t *cellMem;		/* list of memory blocks for cells */
-    block_t *cellCur;		/* current block */
     int listSize;		/* memory of nodes */
-    node_list *listMem;		/* list of memory for node items */
-    node_list *listCur;		/* next node item */
+    int nitems;			/* number of nodes added */
+    item_t *items;		/* nodes added since last clear */
+    node_list *listMem;		/* node items, grouped by cell */
+    int ncells;			/* number of non-empty cells */
+    int cellSize;		/* memory of cells */
+    cell *cells;		/* non-empty cells, sorted by (i,j) */
+    bool dirty;			/* items added since cells were formed */
 };
 
-/* getCell:
- * Create a new cell using memory blocks.
- */
-static cell *getCell(Grid * g)
+static int ijcmpf(const gridpt * p1, const gridpt * p2)
 {
-    cell *cp;
-    block_t *bp = g->cellCur;	/* current block */
-
-    if (bp->cur == bp->endp) {	/* current block is full */
-	if (bp->next == 0) {
-	    bp->next = newBlock(2 * (bp->endp - bp->mem));
-	}
-	bp = g->cellCur = bp->next;
-	bp->cur = bp->mem;
-    }
-    cp = bp->cur++;
-    return cp;
+    if (p1->i != p2->i)
+	return p1->i < p2->i ? -1 : 1;
+    if (p1->j != p2->j)
+	return p1->j < p2->j ? -1 : 1;
+    return 0;
 }
 
-static int ijcmpf(Dt_t * d, gridpt * p1, gridpt * p2, Dtdisc_t * disc)
-{
-    int diff;
-
-    NOTUSED(d);
-    NOTUSED(disc);
-    if ((diff = p1->i - p2->i))
-	return diff;
-    else
-	return p1->j - p2->j;
-}
-
-static Grid *_grid;		/* hack because can't attach info. to Dt_t */
-
-/* newCell:
- * Allocate a new cell from free store and initialize its indices
- * This is used by the grid discipline to create cells.
+/* itemcmpf:
+ * Order items by cell and, within a cell, most recently added
+ * first. This is the order in which nodes used to be prepended to
+ * their cell's list, so the layout is unchanged.
  */
-static void *newCell(Dt_t * d, void *obj, Dtdisc_t * disc)
+static int itemcmpf(const void *x, const void *y)
 {
-    cell *cellp = obj;
-    cell *newp;
+    const item_t *a = x;
+    const item_t *b = y;
+    int diff = ijcmpf(&a->p, &b->p);
 
-    NOTUSED(d);
-    NOTUSED(disc);
-    newp = getCell(_grid);
-    newp->p.i = cellp->p.i;
-    newp->p.j = cellp->p.j;
-    newp->nodes = 0;
-
-    return newp;
-}
-
-/* newNode:
- * Allocate a new node item from free store. 
- * Set node value and hook into list.
- * A grid assumes the memory allocated in adjustGrid
- * will be enough more all nodes added.
- */
-static node_list *newNode(Grid * g, Agnode_t * n, node_list * nxt)
-{
-    node_list *newp;
-
-    newp = g->listCur++;
-    newp->node = n;
-    newp->next = nxt;
-
-    return newp;
+    if (diff)
+	return diff;
+    return b->seq - a->seq;
 }
 
-static Dtdisc_t gridDisc = {
-    offsetof(cell, p),
-    sizeof(gridpt),
-    offsetof(cell, link),
-    (Dtmake_f) newCell,
-    NULL,
-    (Dtcompar_f) ijcmpf,
-    NULL,
-    NULL,
-    NULL
-};
-
 /* mkGrid:
  * Create grid data structure.
  * cellHint provides rough idea of how many cells
@@ -164,11 +82,14 @@ Grid *mkGrid(int cellHint)
     Grid *g;
 
     g = GNEW(Grid);
-    _grid = g;			/* see comment above */
-    g->data = dtopen(&gridDisc, Dtoset);
-    g->listMem = 0;
     g->listSize = 0;
-    g->cellMem = newBlock(cellHint);
+    g->nitems = 0;
+    g->items = 0;
+    g->listMem = 0;
+    g->ncells = 0;
+    g->cellSize = MAX(cellHint, 1);
+    g->cells = N_GNEW(g->cellSize, cell);
+    g->dirty = false;
     return g;
 }
 
@@ -184,23 +105,23 @@ void adjustGrid(Grid * g, int nnodes)
 
     if (nnodes > g->listSize) {
 	nsize = MAX(nnodes, 2 * g->listSize);
-	if (g->listMem)
-	    free(g->listMem);
+	free(g->items);
+	free(g->listMem);
+	g->items = N_GNEW(nsize, item_t);
 	g->listMem = N_GNEW(nsize, node_list);
 	g->listSize = nsize;
     }
 }
 
 /* clearGrid:
- * Reset grid. This clears the dictionary,
+ * Reset grid. This empties the cells,
  * and reuses available memory.
  */
 void clearGrid(Grid * g)
 {
-    dtclear(g->data);
-    g->listCur = g->listMem;
-    g->cellCur = g->cellMem;
-    g->cellCur->cur = g->cellCur->mem;
+    g->nitems = 0;
+    g->ncells = 0;
+    g->dirty = false;
 }
 
 /* delGrid:
@@ -208,53 +129,106 @@ void clearGrid(Grid * g)
  */
 void delGrid(Grid * g)
 {
-    dtclose(g->data);
-    freeBlock(g->cellMem);
+    free(g->items);
     free(g->listMem);
+    free(g->cells);
     free(g);
 }
 
 /* addGrid:
  * Add node n to cell (i,j) in grid g.
+ * The node is only recorded here; cells are formed
+ * when the grid is next walked or searched.
  */
 void addGrid(Grid * g, int i, int j, Agnode_t * n)
 {
-    cell *cellp;
-    cell key;
+    item_t *ip = g->items + g->nitems;
 
-    key.p.i = i;
-    key.p.j = j;
-    cellp = dtinsert(g->data, &key);
-    cellp->nodes = newNode(g, n, cellp->nodes);
+    ip->p.i = i;
+    ip->p.j = j;
+    ip->seq = g->nitems++;
+    ip->node = n;
+    g->dirty = true;
     if (Verbose >= 3) {
 	fprintf(stderr, "grid(%d,%d): %s\n", i, j, agnameof(n));
     }
 }
 
-typedef int (*walkfn_t) (Dt_t *, void *, void *);
+/* buildCells:
+ * Sort the nodes added since the last clear by cell, and form the
+ * cell array from the runs of equal cell indices.
+ */
+static void buildCells(Grid * g)
+{
+    int k;
+    cell *cp = 0;
+
+    qsort(g->items, g->nitems, sizeof(item_t), itemcmpf);
+    g->ncells = 0;
+    for (k = 0; k < g->nitems; k++) {
+	item_t *ip = g->items + k;
+	node_list *np = g->listMem + k;
+
+	np->node = ip->node;
+	np->next = 0;
+	if (cp && ijcmpf(&cp->p, &ip->p) == 0) {
+	    np[-1].next = np;
+	    continue;
+	}
+	if (g->ncells == g->cellSize) {
+	    g->cellSize *= 2;
+	    g->cells = RALLOC(g->cellSize, g->cells, cell);
+	}
+	cp = g->cells + g->ncells++;
+	cp->p = ip->p;
+	cp->nodes = np;
+    }
+    g->dirty = false;
+}
 
 /* walkGrid:
- * Apply function walkf to each cell in the grid.
- * The second argument to walkf is the cell; the
- * third argument is the grid. (The first argument
- * is the dictionary.) walkf must return 0.
+ * Apply function walkf to each cell in the grid,
+ * in order of (i,j). The first argument to walkf
+ * is the cell; the second argument is the grid.
+ * The walk stops if walkf returns non-zero.
  */
-void walkGrid(Grid * g, int (*walkf) (Dt_t *, cell *, Grid *))
+void walkGrid(Grid * g, int (*walkf) (cell *, Grid *))
 {
-    dtwalk(g->data, (walkfn_t) walkf, g);
+    int k;
+
+    if (g->dirty)
+	buildCells(g);
+    for (k = 0; k < g->ncells; k++) {
+	if (walkf(g->cells + k, g))
+	    break;
+    }
 }
 
-/* findGrid;
+/* findGrid:
  * Return the cell, if any, corresponding to
  * indices i,j
  */
 cell *findGrid(Grid * g, int i, int j)
 {
-    cell key;
-
-    key.p.i = i;
-    key.p.j = j;
-    return dtsearch(g->data, &key);
+    gridpt key;
+    int lo = 0, hi, mid, diff;
+
+    if (g->dirty)
+	buildCells(g);
+    key.i = i;
+    key.j = j;
+    hi = g->ncells - 1;
+    while (lo <= hi) {
+	mid = lo + (hi - lo) / 2;
+	diff = ijcmpf(&g->cells[mid].p, &key);
+	if (diff == 0)
+	    return g->cells + mid;
+	if (diff < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid - 1;
+    }
+    return 0;
 }
 
 /* gLength:
@@ -18,7 +18,6 @@ extern "C" {
 #include "config.h"
 
 #include <common/render.h>
-#include <cdt/cdt.h>
 
     typedef struct _grid Grid;
 
@@ -34,14 +33,13 @@ extern "C" {
     typedef struct {
 	gridpt p;		/* index of cell */
 	node_list *nodes;	/* nodes in cell */
-	Dtlink_t link;		/* cdt data */
     } cell;
 
     extern Grid *mkGrid(int);
     extern void adjustGrid(Grid * g, int nnodes);
     extern void clearGrid(Grid *);
     extern void addGrid(Grid *, int, int, Agnode_t *);
-    extern void walkGrid(Grid *, int (*)(Dt_t *, cell *, Grid *));
+    extern void walkGrid(Grid *, int (*)(cell *, Grid *));
     extern cell *findGrid(Grid *, int, int);
     extern void delGrid(Grid *);
     extern int gLength(cell * p);
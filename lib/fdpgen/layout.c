@@ -785,6 +785,7 @@ setClustNodes(graph_t* root)
 	ND_lw(n) = ND_rw(n) = w2;
 	ND_ht(n) = h_pts;
 
+	/* poly_init does not share the polygons of cluster nodes */
 	vertices = ((polygon_t *) ND_shape_info(n))->vertices;
 	vertices[0].x = ND_rw(n);
 	vertices[0].y = h2;
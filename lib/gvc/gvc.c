@@ -17,7 +17,9 @@
 #include <gvc/gvcproc.h>
 #include <gvc/gvconfig.h>
 #include <gvc/gvio.h>
+#include <common/render.h>
 #include <stdlib.h>
+#include <string.h>
 
 GVC_t *gvContext(void)
 {
@@ -141,6 +143,57 @@ int gvRenderFilename(GVC_t *gvc, graph_t *g, const char *format, const char *fil
     return rc;
 }
 
+/* Render layout as a pyramid of square tiles, for map-style viewers.
+ * At level z the drawing, anchored at its top left corner, is scaled so that
+ * its larger side spans 2^z tiles of tilesize pixels. Tile (x,y) of level z,
+ * counting x rightwards and y downwards from 0, is written to
+ * <prefix>_<z>_<x>_<y>.<ext>, where <ext> is the format up to any ':'.
+ * Tiles that fall outside the drawing are not written. Each level is
+ * rendered as pages of one job, see emit_tiles(), so the tiles share the job
+ * setup and one spatial index of the graph.
+ * Returns the number of tiles written, or -1 on error.
+ */
+int gvRenderTiles(GVC_t *gvc, graph_t *g, const char *format,
+                  const char *prefix, int maxlevel, int tilesize)
+{
+    int rc;
+    GVJ_t *job;
+    char *ext;
+
+    g = g->root;
+    if (!LAYOUT_DONE(g)) {
+	agerrorf("Layout was not done\n");
+	return -1;
+    }
+    if (maxlevel < 0 || maxlevel > 30 || tilesize <= 0) {
+	agerr(AGERR, "gvRenderTiles: invalid levels %d or tile size %d\n",
+	      maxlevel, tilesize);
+	return -1;
+    }
+
+    /* create a job for the required format */
+    rc = gvjobs_output_langname(gvc, format);
+    job = gvc->job;
+    if (rc == NO_SUPPORT) {
+	agerr(AGERR, "Format: \"%s\" not recognized. Use one of:%s\n",
+                format, gvplugin_list(gvc, API_device, format));
+	return -1;
+    }
+    job->output_lang = gvrender_select(job, job->output_langname);
+
+    ext = strdup(format);
+    if (!ext) {
+	gvjobs_delete(gvc);
+	return -1;
+    }
+    ext[strcspn(ext, ":")] = '\0';
+    rc = emit_tiles(job, g, prefix, ext, maxlevel, tilesize);
+    free(ext);
+    gvjobs_delete(gvc);
+
+    return rc;
+}
+
 /* Render layout in a specified format to an external context */
 int gvRenderContext(GVC_t *gvc, graph_t *g, const char *format, void *context)
 {
@@ -80,6 +80,11 @@ GVC_API int gvRender(GVC_t *gvc, graph_t *g, const char *format, FILE *out);
 /* Render layout in a specified format to a file with the given name */
 GVC_API int gvRenderFilename(GVC_t *gvc, graph_t *g, const char *format, const char *filename);
 
+/* Render layout as a z/x/y pyramid of square tiles, written to
+ * <prefix>_<z>_<x>_<y>.<ext> for levels 0 to maxlevel */
+GVC_API int gvRenderTiles(GVC_t *gvc, graph_t *g, const char *format,
+                          const char *prefix, int maxlevel, int tilesize);
+
 /* Render layout in a specified format to an GVC_APIal context */
 GVC_API int gvRenderContext(GVC_t *gvc, graph_t *g, const char *format, void *context);
 
@@ -92,7 +92,20 @@ extern "C" {
 	/* fonts and textlayout */
 	Dtdisc_t textfont_disc;
 	Dt_t *textfont_dt;
+	Dtdisc_t textspan_cache_disc;
+	Dt_t *textspan_cache;	/* text measurements, see textspan_size() */
+	unsigned long textspan_cache_hits, textspan_cache_misses;
+
+	/* resolved colors, see gvrender_resolve_color() */
+	Dtdisc_t color_cache_disc;
+	Dt_t *color_cache;
+	unsigned long color_cache_hits, color_cache_misses;
 	gvplugin_active_textlayout_t textlayout; /* always use best avail for all jobs */
+
+	/* spatial index of the graph's nodes and edges, kept across renders
+	 * while keep_emit_index is set, see emit_graph() */
+	void *emit_index;
+	boolean keep_emit_index;
 //	void (*free_layout) (void *layout);   /* function for freeing layouts (mostly used by pango) */
 	
 /* FIXME - everything below should probably move to GVG_t */
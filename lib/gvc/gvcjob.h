@@ -366,6 +366,9 @@ extern "C" {
 	gvevent_key_binding_t *keybindings;
 	int numkeys;
 	void *keycodes;
+
+	double  lod;		/* level of detail: leave out labels and edge detail
+				   smaller than this - points, 0 for all detail */
     };
 
 #ifdef __cplusplus
@@ -94,6 +94,7 @@ int gvFreeContext(GVC_t * gvc)
     free(gvc->config_path);
     free(gvc->input_filenames);
     textfont_dict_close(gvc);
+    gvrender_color_cache_close(gvc);
     for (i = 0; i != num_apis; ++i) {
 	for (api = gvc->apis[i]; api != NULL; api = api_next) {
 	    api_next = api->next;
@@ -58,6 +58,7 @@
     point gvusershape_size_dpi(usershape_t *us, pointf dpi);
     point gvusershape_size(graph_t *g, char *name);
     usershape_t *gvusershape_find(char *name);
+    void gvusershape_revalidate(void);
 
 /* device */
     int gvdevice_initialize(GVJ_t * job);
@@ -73,6 +74,7 @@
     void gvrender_end_job(GVJ_t * job);
     int gvrender_select(GVJ_t * job, const char *lang);
     int gvrender_features(GVJ_t * job);
+    void gvrender_color_cache_close(GVC_t * gvc);
     void gvrender_begin_graph(GVJ_t * job, graph_t * g);
     void gvrender_end_graph(GVJ_t * job);
     void gvrender_begin_page(GVJ_t * job);
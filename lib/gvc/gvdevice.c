@@ -14,7 +14,6 @@
 
 #include "config.h"
 
-#include <ctype.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -45,6 +44,7 @@ static uint64_t crc;
 #endif /* HAVE_LIBZ */
 
 #include <assert.h>
+#include <cgraph/dtos.h>
 #include <common/const.h>
 #include <common/memory.h>
 #include <gvc/gvplugin_device.h>
@@ -516,44 +516,28 @@ int main (int argc, char *argv[])
 }
 #endif
 
-/* gv_trim_zeros
-* Trailing zeros are removed and decimal point, if possible.
-* Assumes the input is the result of %.02f printing.
-*/
-static void gv_trim_zeros(char* buf)
-{
-  char *dotp = strchr(buf, '.');
-  if (dotp == NULL) {
-    return;
-  }
-
-  // check this really is the result of %.02f printing
-  assert(isdigit(dotp[1]) && isdigit(dotp[2]) && dotp[3] == '\0');
-
-  if (dotp[2] == '0') {
-    if (dotp[1] == '0') {
-      *dotp = '\0';
-    } else {
-      dotp[2] = '\0';
-    }
-  }
-}
-
-void gvprintdouble(GVJ_t * job, double num)
+/* gvformatdouble:
+ * Format num into buf, which has room for CHARS_FOR_NUL_TERM_DTOS2 bytes,
+ * as gvprintdouble prints it. Returns the length of the string.
+ */
+size_t gvformatdouble(char *buf, double num)
 {
     // Prevents values like -0
     if (num > -0.005 && num < 0.005)
     {
-        gvwrite(job, "0", 1);
-        return;
+        strcpy(buf, "0");
+        return 1;
     }
 
-    char buf[50];
+    return dtos2(buf, num);
+}
 
-    snprintf(buf, 50, "%.02f", num);
-    gv_trim_zeros(buf);
+void gvprintdouble(GVJ_t * job, double num)
+{
+    char buf[CHARS_FOR_NUL_TERM_DTOS2];
+    size_t len = gvformatdouble(buf, num);
 
-    gvwrite(job, buf, strlen(buf));
+    gvwrite(job, buf, len);
 }
 
 void gvprintpointf(GVJ_t * job, pointf p)
@@ -41,6 +41,7 @@ extern "C" {
     GVIO_API int gvputs(GVJ_t * job, const char *s);
     GVIO_API int gvflush (GVJ_t * job);
     GVIO_API void gvprintf(GVJ_t * job, const char *format, ...);
+    GVIO_API size_t gvformatdouble(char *buf, double num);
     GVIO_API void gvprintdouble(GVJ_t * job, double num);
     GVIO_API void gvprintpointf(GVJ_t * job, pointf p);
     GVIO_API void gvprintpointflist(GVJ_t * job, pointf *p, int n);
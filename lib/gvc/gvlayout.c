@@ -75,6 +75,7 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
 	return -1;
 
     gv_fixLocale (1);
+    gvusershape_revalidate();
     graph_init(g, gvc->layout.features->flags & LAYOUT_USES_RANKDIR);
     GD_drawing(agroot(g)) = GD_drawing(g);
     gv_initShapes ();
@@ -17,6 +17,8 @@
 #include "config.h"
 
 #include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <common/memory.h>
 #include <common/const.h>
@@ -24,6 +26,7 @@
 #include <common/colorprocs.h>
 #include <gvc/gvplugin_render.h>
 #include <cgraph/cgraph.h>
+#include <common/globals.h>
 #include <gvc/gvcint.h>
 #include <common/geom.h>
 #include <common/geomprocs.h>
@@ -179,6 +182,80 @@ static int gvrender_comparestr(const void *s1, const void *s2)
     return strcmp(*(char *const *) s1, *(char *const *) s2);
 }
 
+/* Cache of resolved colors. The same few color names are resolved for
+ * every node and edge, and each resolution canonicalizes the name and
+ * searches the renderer's and the generic color tables. The result
+ * depends on the name, the renderer's features and the color scheme.
+ */
+typedef struct {
+    /* key */
+    char *name;
+    char *scheme;
+    gvrender_features_t *features;
+
+    /* non key */
+    gvcolor_t color;
+} color_cache_t;
+
+/* maximum number of cached colors before the cache is flushed */
+#define COLOR_CACHE_MAX 10000
+
+static void* color_cache_makef(Dt_t* dt, void* obj, Dtdisc_t* disc)
+{
+    color_cache_t *c1 = obj;
+    color_cache_t *c2 = malloc(sizeof(color_cache_t));
+
+    if (!c2)
+	return NULL;
+    *c2 = *c1;
+    c2->name = strdup(c1->name);
+    c2->scheme = c1->scheme ? strdup(c1->scheme) : NULL;
+    if (!c2->name || (c1->scheme && !c2->scheme)) {
+	free(c2->name);
+	free(c2->scheme);
+	free(c2);
+	return NULL;
+    }
+    return c2;
+}
+
+static void color_cache_freef(Dt_t* dt, void* obj, Dtdisc_t* disc)
+{
+    color_cache_t *c = obj;
+
+    free(c->name);
+    free(c->scheme);
+    free(c);
+}
+
+static int color_cache_comparf(Dt_t* dt, void* key1, void* key2, Dtdisc_t* disc)
+{
+    int rc;
+    color_cache_t *c1 = key1, *c2 = key2;
+
+    rc = strcmp(c1->name, c2->name);
+    if (rc) return rc;
+    if (c1->features != c2->features)
+	return (uintptr_t)c1->features < (uintptr_t)c2->features ? -1 : 1;
+    if (c1->scheme || c2->scheme) {
+	if (!c1->scheme) return -1;
+	if (!c2->scheme) return 1;
+	return strcmp(c1->scheme, c2->scheme);
+    }
+    return 0;
+}
+
+void gvrender_color_cache_close(GVC_t *gvc)
+{
+    if (gvc->color_cache) {
+	if (Verbose)
+	    fprintf(stderr, "color cache: %lu hits, %lu misses\n",
+		    gvc->color_cache_hits, gvc->color_cache_misses);
+	dtclose(gvc->color_cache);
+	gvc->color_cache = NULL;
+    }
+}
+
 /* gvrender_resolve_color:
  * N.B. strcmp cannot be used in bsearch, as it will pass a pointer
  * to an element in the array features->knowncolors (i.e., a char**)
@@ -186,11 +263,29 @@ static int gvrender_comparestr(const void *s1, const void *s2)
  * strcmp are both char*. Given this, the first argument to
  * bsearch must also be char**, so we use &tok.
  */
-static void gvrender_resolve_color(gvrender_features_t * features,
+static void gvrender_resolve_color(GVC_t *gvc, gvrender_features_t * features,
 				   char *name, gvcolor_t * color)
 {
     char *tok;
     int rc;
+    color_cache_t key, *cached;
+
+    if (!gvc->color_cache) {
+	DTDISC(&(gvc->color_cache_disc),0,sizeof(color_cache_t),-1,color_cache_makef,color_cache_freef,color_cache_comparf,NULL,NULL,NULL);
+	gvc->color_cache = dtopen(&(gvc->color_cache_disc), Dtoset);
+	gvc->color_cache_hits = gvc->color_cache_misses = 0;
+    }
+    key.name = name;
+    key.scheme = getColorScheme();
+    key.features = features;
+    if ((cached = dtsearch(gvc->color_cache, &key))) {
+	gvc->color_cache_hits++;
+	*color = cached->color;
+	if (color->type == COLOR_STRING)
+	    color->u.string = name;
+	return;
+    }
+    gvc->color_cache_misses++;
 
     color->u.string = name;
     color->type = COLOR_STRING;
@@ -212,8 +307,14 @@ static void gvrender_resolve_color(gvrender_features_t * features,
 	    } else {
 		agerr(AGERR, "error in colxlate()\n");
 	    }
+	    return;	/* not cached, so that it is reported again */
 	}
     }
+
+    if (dtsize(gvc->color_cache) >= COLOR_CACHE_MAX)
+	dtclear(gvc->color_cache);
+    key.color = *color;
+    dtinsert(gvc->color_cache, &key);
 }
 
 void gvrender_begin_graph(GVJ_t * job, graph_t * g)
@@ -230,7 +331,7 @@ void gvrender_begin_graph(GVJ_t * job, graph_t * g)
 #if 0
 	/* background color */
 	if (((s = agget(g, "bgcolor")) != 0) && s[0]) {
-	    gvrender_resolve_color(job->render.features, s,
+	    gvrender_resolve_color(job->gvc, job->render.features, s,
 				   &(gvc->bgcolor));
 	    if (gvre->resolve_color)
 		gvre->resolve_color(job, &(gvc->bgcolor));
@@ -461,7 +562,7 @@ void gvrender_set_pencolor(GVJ_t * job, char *name)
     if ((cp = strchr(name, ':'))) // if it’s a color list, then use only first
 	*cp = '\0';
     if (gvre) {
-	gvrender_resolve_color(job->render.features, name, color);
+	gvrender_resolve_color(job->gvc, job->render.features, name, color);
 	if (gvre->resolve_color)
 	    gvre->resolve_color(job, color);
     }
@@ -478,7 +579,7 @@ void gvrender_set_fillcolor(GVJ_t * job, char *name)
     if ((cp = strchr(name, ':'))) // if it’s a color list, then use only first
 	*cp = '\0';
     if (gvre) {
-	gvrender_resolve_color(job->render.features, name, color);
+	gvrender_resolve_color(job->gvc, job->render.features, name, color);
 	if (gvre->resolve_color)
 	    gvre->resolve_color(job, color);
     }
@@ -492,7 +593,7 @@ void gvrender_set_gradient_vals (GVJ_t * job, char *stopcolor, int angle, float
     gvcolor_t *color = &(job->obj->stopcolor);
 
     if (gvre) {
-	gvrender_resolve_color(job->render.features, stopcolor, color);
+	gvrender_resolve_color(job->gvc, job->render.features, stopcolor, color);
 	if (gvre->resolve_color)
 	    gvre->resolve_color(job, color);
     }
@@ -15,6 +15,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -39,6 +41,14 @@ extern shape_desc *find_user_shape(const char *);
 
 static Dict_t *ImageDict;
 
+/* Layouts started so far. Each cached image is checked against its file
+ * once per layout, so that a file changed between graphs is read again.
+ */
+static unsigned int ImageLayouts;
+
+#define MAX_USERSHAPE_FILES_OPEN 50
+static int usershape_files_open_cnt;
+
 typedef struct {
     char *template;
     int size;
@@ -573,8 +583,11 @@ static void usershape_close (Dict_t * dict, void * p, Dtdisc_t * disc)
 {
     usershape_t *us = (usershape_t *)p;
 
-    if (us->f)
+    if (us->f) {
 	fclose(us->f);
+	if (!us->nocache)
+	    usershape_files_open_cnt--;
+    }
     if (us->data && us->datafree)
 	us->datafree(us);
     free (us);
@@ -606,10 +619,8 @@ usershape_t *gvusershape_find(const char *name)
     return us;
 }
 
-#define MAX_USERSHAPE_FILES_OPEN 50
 boolean gvusershape_file_access(usershape_t *us)
 {
-    static int usershape_files_open_cnt;
     const char *fn;
 
     assert(us);
@@ -649,10 +660,42 @@ void gvusershape_file_release(usershape_t *us)
 
 static void freeUsershape (usershape_t* us)
 {
+    if (us->f) {
+	fclose(us->f);
+	if (!us->nocache)
+	    usershape_files_open_cnt--;
+    }
     if (us->name) agstrfree(0, us->name);
     free (us);
 }
 
+/* gvusershape_revalidate:
+ * Note that a new layout is starting, so that each cached image is
+ * checked against its file the next time it is used.
+ */
+void gvusershape_revalidate(void)
+{
+    ImageLayouts++;
+}
+
+/* usershape_changed:
+ * Return TRUE if the file of us has been modified or removed since
+ * it was read. If the name no longer resolves to a file, for example
+ * because file loading is disabled in a web server, there is nothing
+ * to compare with, and the cached image is kept.
+ */
+static boolean usershape_changed(usershape_t *us)
+{
+    struct stat statbuf;
+    const char *fn;
+
+    if (!(fn = safefile(us->name)))
+	return FALSE;
+    if (stat(fn, &statbuf) != 0)
+	return TRUE;
+    return statbuf.st_mtime != us->mtime || statbuf.st_size != us->filesize;
+}
+
 static usershape_t *gvusershape_open (const char *name)
 {
     usershape_t *us;
@@ -662,7 +705,18 @@ static usershape_t *gvusershape_open (const char *name)
     if (!ImageDict)
         ImageDict = dtopen(&ImageDictDisc, Dttree);
 
-    if (! (us = gvusershape_find(name))) {
+    /* drop a cached image whose file has changed since it was read */
+    if ((us = gvusershape_find(name)) && us->checked != ImageLayouts) {
+	us->checked = ImageLayouts;
+	if (usershape_changed(us)) {
+	    dtdelete(ImageDict, us);
+	    us = NULL;
+	}
+    }
+
+    if (!us) {
+	struct stat statbuf;
+
         us = zmalloc(sizeof(usershape_t));
 
 	us->name = agstrdup(0, name);
@@ -672,6 +726,11 @@ static usershape_t *gvusershape_open (const char *name)
 	}
 
 	assert(us->f);
+	if (fstat(fileno(us->f), &statbuf) == 0) {
+	    us->mtime = statbuf.st_mtime;
+	    us->filesize = statbuf.st_size;
+	}
+	us->checked = ImageLayouts;
 
         switch(imagetype(us)) {
 	    case FT_NULL:
@@ -751,6 +810,7 @@ point gvusershape_size(graph_t * g, char *name)
     pointf dpi;
     static char* oldpath;
     usershape_t* us;
+    boolean samepath;
 
     /* no shape file, no shape size */
     if (!name || (*name == '\0')) {
@@ -758,8 +818,16 @@ point gvusershape_size(graph_t * g, char *name)
 	return rv;
     }
 
-    if (!HTTPServerEnVar && (oldpath != Gvimagepath)) {
-	oldpath = Gvimagepath;
+    /* image names are resolved against imagepath, so the cache is only
+     * valid while it is unchanged. Each graph has its own copy of the
+     * string, so compare contents to keep the cache between graphs. */
+    if (oldpath && Gvimagepath)
+	samepath = !strcmp(oldpath, Gvimagepath);
+    else
+	samepath = oldpath == Gvimagepath;
+    if (!HTTPServerEnVar && !samepath) {
+	free(oldpath);
+	oldpath = Gvimagepath ? strdup(Gvimagepath) : NULL;
 	if (ImageDict) {
 	    dtclose(ImageDict);
 	    ImageDict = NULL;
@@ -204,6 +204,101 @@ LeafList_t *RTreeSearch(RTree_t * rtp, Node_t * n, Rect_t * r)
     return llp;
 }
 
+/* RTreeSearchApply in an index tree or subtree for all data rectangles that
+** overlap the argument rectangle, calling fn on each of them in the order
+** RTreeSearch would list them. Unlike RTreeSearch, it allocates nothing.
+** Returns the number of qualifying data rects.
+*/
+size_t RTreeSearchApply(RTree_t * rtp, Node_t * n, Rect_t * r,
+			void (*fn)(Leaf_t *, void *), void *arg)
+{
+    size_t hits = 0;
+
+    assert(n);
+    assert(n->level >= 0);
+    assert(r && fn);
+
+    rtp->SeTouchCount++;
+
+    if (n->level > 0) {		/* this is an internal node in the tree */
+	for (size_t i = 0; i < NODECARD; i++)
+	    if (n->branch[i].child && Overlap(r, &n->branch[i].rect))
+		hits += RTreeSearchApply(rtp, n->branch[i].child, r, fn, arg);
+    } else {			/* this is a leaf node */
+	/* RTreeSearch prepends the hits of a leaf to its list */
+	for (size_t i = NODECARD; i-- > 0;) {
+	    if (n->branch[i].child && Overlap(r, &n->branch[i].rect)) {
+		fn((Leaf_t *) & n->branch[i], arg);
+		hits++;
+	    }
+	}
+    }
+    return hits;
+}
+
+/* Load an empty index with n data rectangles at once, building it bottom up
+** rather than inserting them one by one. Each run of NODECARD consecutive
+** leaves goes into the same node, so the caller should order them to keep
+** nearby rectangles together, for example along a space filling curve.
+** Nodes are filled completely; the index may still be updated with
+** RTreeInsert and RTreeDelete afterwards.
+** Returns 0 on success, -1 if out of memory.
+*/
+int RTreeLoad(RTree_t * rtp, Leaf_t * leaves, size_t n)
+{
+    Node_t **nodes;
+    size_t cnt, level;
+
+    assert(rtp->root && rtp->root->count == 0 && rtp->root->level == 0);
+    if (n == 0)
+	return 0;
+
+    if (!(nodes = calloc((n + NODECARD - 1) / NODECARD, sizeof(Node_t *))))
+	return -1;
+
+    /* the leaf level */
+    cnt = 0;
+    for (size_t i = 0; i < n; i += NODECARD) {
+	Node_t *nd = cnt == 0 ? rtp->root : RTreeNewNode(rtp);
+	if (cnt > 0)
+	    rtp->LeafCount++;
+	nd->level = 0;
+	for (size_t j = i; j < n && j < i + NODECARD; j++) {
+	    for (size_t k = 0; k < NUMDIMS; k++)
+		assert(leaves[j].rect.boundary[k] <=
+		       leaves[j].rect.boundary[NUMDIMS + k]);
+	    nd->branch[nd->count].rect = leaves[j].rect;
+	    nd->branch[nd->count].child = leaves[j].data;
+	    nd->count++;
+	}
+	nodes[cnt++] = nd;
+    }
+    rtp->RectCount += (int)n;
+    rtp->EntryCount += (int)n;
+
+    /* parents, until one node covers the rest */
+    for (level = 1; cnt > 1; level++) {
+	size_t parents = 0;
+	for (size_t i = 0; i < cnt; i += NODECARD) {
+	    Node_t *nd = RTreeNewNode(rtp);
+	    rtp->NonLeafCount++;
+	    nd->level = (int)level;
+	    for (size_t j = i; j < cnt && j < i + NODECARD; j++) {
+		nd->branch[nd->count].rect = NodeCover(nodes[j]);
+		nd->branch[nd->count].child = nodes[j];
+		nd->count++;
+		rtp->EntryCount++;
+	    }
+	    nodes[parents++] = nd;
+	}
+	cnt = parents;
+    }
+    rtp->root = nodes[0];
+
+    free(nodes);
+    return 0;
+}
+
 /* Insert a data rectangle into an index structure.
 ** RTreeInsert provides for splitting the root;
 ** returns 1 if root was split, 0 if it was not.
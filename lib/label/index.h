@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -114,7 +116,10 @@ RTree_t *RTreeOpen(void);
 int RTreeClose(RTree_t * rtp);
 Node_t *RTreeNewIndex(RTree_t * rtp);
 LeafList_t *RTreeSearch(RTree_t *, Node_t *, Rect_t *);
+size_t RTreeSearchApply(RTree_t *, Node_t *, Rect_t *,
+			void (*)(Leaf_t *, void *), void *);
 int RTreeInsert(RTree_t *, Rect_t *, void *, Node_t **, int);
+int RTreeLoad(RTree_t *, Leaf_t *, size_t);
 int RTreeDelete(RTree_t *, Rect_t *, void *, Node_t **);
 
 LeafList_t *RTreeNewLeafList(Leaf_t * lp);
@@ -21,31 +21,11 @@
 
 extern int Verbose;
 
-static int icompare(Dt_t *, void *, void *, Dtdisc_t *);
-
-Dtdisc_t Hdisc = { offsetof(HDict_t, key), sizeof(int), -1, 0, 0,
-    icompare, 0, 0, 0
-};
-
-static int icompare(Dt_t * dt, void * v1, void * v2, Dtdisc_t * disc)
-{
-    (void)dt;
-    (void)disc;
-    int k1 = *((int *) v1), k2 = *((int *) v2);
-    return k1 - k2;
-}
-
 static XLabels_t *xlnew(object_t * objs, int n_objs, xlabel_t * lbls,
                         int n_lbls, label_params_t * params)
 {
     XLabels_t *xlp = NEW(XLabels_t);
 
-    /* used to load the rtree in hilbert space filling curve order */
-    if (!(xlp->hdx = dtopen(&Hdisc, Dtobag))) {
-	fprintf(stderr, "out of memory\n");
-	goto bad;
-    }
-
     /* for querying intersection candidates */
     if (!(xlp->spdx = RTreeOpen())) {
 	fprintf(stderr, "out of memory\n");
@@ -61,8 +41,6 @@ static XLabels_t *xlnew(object_t * objs, int n_objs, xlabel_t * lbls,
     return xlp;
 
   bad:
-    if (xlp->hdx)
-	dtclose(xlp->hdx);
     if (xlp->spdx)
 	RTreeClose(xlp->spdx);
     free(xlp);
@@ -331,61 +309,69 @@ recordlintrsx(XLabels_t * xlp, object_t * op, object_t * cp, Rect_t * rp,
     return a;
 }
 
+/* state of an xlintersections query, passed to xlintersect */
+typedef struct {
+    XLabels_t *xlp;
+    object_t *objp;
+    object_t **intrsx;
+    Rect_t rect;
+    BestPos_t bp;
+} XLQuery_t;
+
+/* score one object whose labeling area overlaps the label */
+static void xlintersect(Leaf_t * leaf, void *arg)
+{
+    XLQuery_t *q = arg;
+    object_t *objp = q->objp, *cp = leaf->data;
+    Rect_t srect;
+    double a, ra;
+
+    if (cp == objp)
+	return;
+
+    /* a point object inside the label; its labeling area encloses it, so
+     * the search finds all of these */
+    if (!(cp->sz.x > 0 && cp->sz.y > 0) && lblenclosing(objp, cp))
+	q->bp.n++;
+
+    /*label-object intersect */
+    objp2rect(cp, &srect);
+    a = aabbaabb(&q->rect, &srect);
+    if (a > 0.0) {
+	ra = recordointrsx(q->xlp, objp, cp, &q->rect, a, q->intrsx);
+	q->bp.n++;
+	q->bp.area += ra;
+    }
+    /*label-label intersect */
+    if (!cp->lbl || !cp->lbl->set)
+	return;
+    objplp2rect(cp, &srect);
+    a = aabbaabb(&q->rect, &srect);
+    if (a > 0.0) {
+	ra = recordlintrsx(q->xlp, objp, cp, &q->rect, a, q->intrsx);
+	q->bp.n++;
+	q->bp.area += ra;
+    }
+}
+
 /* find the objects and labels intersecting lp */
 static BestPos_t
 xlintersections(XLabels_t * xlp, object_t * objp, object_t * intrsx[XLNBR])
 {
-    Rect_t rect, srect;
-    BestPos_t bp;
+    XLQuery_t q;
 
     assert(objp->lbl);
 
-    bp.n = 0;
-    bp.area = 0.0;
-    bp.pos = objp->lbl->pos;
-
-    for(int i=0; i<xlp->n_objs; i++) {
-      if(objp == &xlp->objs[i]) continue;
-      if(xlp->objs[i].sz.x > 0 && xlp->objs[i].sz.y > 0) continue;
-      if(lblenclosing(objp, &xlp->objs[i]) ) {
-	bp.n++;
-      }
-    }
-
-    objplp2rect(objp, &rect);
+    q.xlp = xlp;
+    q.objp = objp;
+    q.intrsx = intrsx;
+    q.bp.n = 0;
+    q.bp.area = 0.0;
+    q.bp.pos = objp->lbl->pos;
 
-    LeafList_t *llp = RTreeSearch(xlp->spdx, xlp->spdx->root, &rect);
-    if (!llp)
-	return bp;
-
-    for (LeafList_t *ilp = llp; ilp; ilp = ilp->next) {
-	double a, ra;
-	object_t *cp = ilp->leaf->data;
-
-	if (cp == objp)
-	    continue;
-
-	/*label-object intersect */
-	objp2rect(cp, &srect);
-	a = aabbaabb(&rect, &srect);
-	if (a > 0.0) {
-	  ra = recordointrsx(xlp, objp, cp, &rect, a, intrsx);
-	  bp.n++;
-	  bp.area += ra;
-	}
-	/*label-label intersect */
-	if (!cp->lbl || !cp->lbl->set)
-	    continue;
-	objplp2rect(cp, &srect);
-	a = aabbaabb(&rect, &srect);
-	if (a > 0.0) {
-	  ra = recordlintrsx(xlp, objp, cp, &rect, a, intrsx);
-	  bp.n++;
-	  bp.area += ra;
-	}
-    }
-    RTreeLeafListFree(llp);
-    return bp;
+    objplp2rect(objp, &q.rect);
+    RTreeSearchApply(xlp->spdx, xlp->spdx->root, &q.rect, xlintersect, &q);
+    return q.bp;
 }
 
 /*
@@ -531,66 +517,50 @@ static BestPos_t xladjust(XLabels_t * xlp, object_t * objp)
     return bp;
 }
 
-/* load the hilbert sfc keyed tree */
-static int xlhdxload(XLabels_t * xlp)
+static int hcompare(const void *p, const void *q)
+{
+    const HLeaf_t *a = p, *b = q;
+
+    if (a->key != b->key)
+	return a->key < b->key ? -1 : 1;
+    /* keep objects with the same key in input order */
+    if (a->d.data != b->d.data)
+	return (object_t *) a->d.data < (object_t *) b->d.data ? -1 : 1;
+    return 0;
+}
+
+/* bulk load the rtree, with the objects in hilbert sfc order */
+static int xlinitialize(XLabels_t * xlp)
 {
     int order = xlhorder(xlp);
+    HLeaf_t *hl;
+    Leaf_t *leaves;
+    int r;
 
+    hl = N_NEW(xlp->n_objs ? xlp->n_objs : 1, HLeaf_t);
     for (int i = 0; i < xlp->n_objs; i++) {
-	HDict_t *hp;
 	point pi;
 
-	hp = NEW(HDict_t);
-
-	hp->d.data = &xlp->objs[i];
-	hp->d.rect = objplpmks(&xlp->objs[i]);
+	hl[i].d.data = &xlp->objs[i];
+	hl[i].d.rect = objplpmks(&xlp->objs[i]);
 	/* center of the labeling area */
-	pi.x = hp->d.rect.boundary[0] +
-	    (hp->d.rect.boundary[2] - hp->d.rect.boundary[0]) / 2;
-	pi.y = hp->d.rect.boundary[1] +
-	    (hp->d.rect.boundary[3] - hp->d.rect.boundary[1]) / 2;
+	pi.x = hl[i].d.rect.boundary[0] +
+	    (hl[i].d.rect.boundary[2] - hl[i].d.rect.boundary[0]) / 2;
+	pi.y = hl[i].d.rect.boundary[1] +
+	    (hl[i].d.rect.boundary[3] - hl[i].d.rect.boundary[1]) / 2;
 
-	hp->key = hd_hil_s_from_xy(pi, order);
-
-	if (!(dtinsert(xlp->hdx, hp)))
-	    return -1;
+	hl[i].key = hd_hil_s_from_xy(pi, order);
     }
-    return 0;
-}
+    qsort(hl, xlp->n_objs, sizeof(hl[0]), hcompare);
 
-static void xlhdxunload(XLabels_t * xlp)
-{
-  int size=dtsize(xlp->hdx), freed=0;
-  while(dtsize(xlp->hdx) ) {
-    void*vp=dtfinger(xlp->hdx);
-    assert(vp);
-    if(vp) {
-      dtdetach(xlp->hdx, vp);
-      free(vp);
-      freed++;
-    }
-  }
-  assert(size==freed);
-}
+    leaves = N_NEW(xlp->n_objs ? xlp->n_objs : 1, Leaf_t);
+    for (int i = 0; i < xlp->n_objs; i++)
+	leaves[i] = hl[i].d;
+    free(hl);
 
-static int xlspdxload(XLabels_t * xlp)
-{
-    for (HDict_t *op = dtfirst(xlp->hdx); op; op = dtnext(xlp->hdx, op)) {
-	/*          tree       rectangle    data        node             lvl */
-	RTreeInsert(xlp->spdx, &op->d.rect, op->d.data, &xlp->spdx->root, 0);
-    }
-    return 0;
-}
-
-static int xlinitialize(XLabels_t * xlp)
-{
-    int r=0;
-    if ((r = xlhdxload(xlp)) < 0)
-	return r;
-    if ((r = xlspdxload(xlp)) < 0)
-	return r;
-    xlhdxunload(xlp);
-    return dtclose(xlp->hdx);
+    r = RTreeLoad(xlp->spdx, leaves, xlp->n_objs);
+    free(leaves);
+    return r;
 }
 
 int
@@ -40,7 +40,6 @@ int placeLabels(object_t * objs, int n_objs,
 #ifdef XLABEL_INT
 #include <label/index.h>
 #include <logic.h>
-#include <cdt.h>
 
 #ifndef XLNDSCALE
 #define XLNDSCALE 72.0
@@ -78,11 +77,10 @@ int placeLabels(object_t * objs, int n_objs,
     pointf pos;
 } BestPos_t;
 
-typedef struct obyh {
-    Dtlink_t link;
-    int key;
+typedef struct {
+    unsigned int key;		// hilbert spatial code of the leaf
     Leaf_t d;
-} HDict_t;
+} HLeaf_t;
 
 typedef struct XLabels_s {
     object_t *objs;
@@ -91,7 +89,6 @@ typedef struct XLabels_s {
     int n_lbls;
     label_params_t *params;
 
-    Dt_t *hdx;			// splay tree keyed with hilbert spatial codes
     RTree_t *spdx;		// rtree
 
 } XLabels_t;
@@ -1454,6 +1454,10 @@ void neato_layout(Agraph_t * g)
 
 	    if (n_cc > 1) {
 		boolean *bp;
+		/* one component at a time: the shortest path heap in stuff.c
+		 * and the routing buffers of spline_edges are static, and
+		 * nodeInduce adds edges to the shared root graph
+		 */
 		for (i = 0; i < n_cc; i++) {
 		    gc = cc[i];
 		    nodeInduce(gc);
@@ -15,11 +15,11 @@
 
 #include <sparse/SparseMatrix.h>
 #include <neatogen/call_tri.h>
-#include <rbtree/red_black_tree.h>
 #include <common/types.h>
 #include <math.h>
 #include <common/memory.h>
 #include <common/globals.h>
+#include <string.h>
 #include <time.h>
 
 static void ideal_distance_avoid_overlap(int dim, SparseMatrix A, real *x, real *width, real *ideal_distance, real *tmax, real *tmin){
@@ -73,182 +73,124 @@ static void ideal_distance_avoid_overlap(int dim, SparseMatrix A, real *x, real
   return;
 }
 
-enum {INTV_OPEN, INTV_CLOSE};
-
-struct scan_point_struct{
+/* A node's box, as seen by the overlap sweep. */
+typedef struct {
+  real xlo, xhi, ylo, yhi;
   int node;
-  real x;
-  int status;
-};
-
-typedef struct scan_point_struct scan_point;
-
-
-static int comp_scan_points(const void *p, const void *q){
-  const scan_point *pp = (const scan_point *) p;
-  const scan_point *qq = (const scan_point *) q;
-  if (pp->x > qq->x){
-    return 1;
-  } else if (pp->x < qq->x){
-    return -1;
-  } else {
-    if (pp->node > qq->node){
-      return 1;
-    } else if (pp->node < qq->node){
-      return -1;
-    }
-    return 0;
-  }
-  return 0;
-}
-
-static void NodeDest(void* a) {
-  /*  free((int*)a);*/
-}
-
-static int NodeComp(const void* a,const void* b) {
-  return comp_scan_points(a,b);
-
+} overlap_box;
+
+/* Scratch space for overlap_sweep. overlap_scaling calls it once per
+ * bisection step, so the buffers are kept and reused across calls instead of
+ * being reallocated every time.
+ */
+typedef struct {
+  int n;
+  overlap_box *boxes; /* node boxes, sorted by left edge */
+  int *active;        /* boxes whose x-extent still reaches the sweep line */
+  int *irn, *jcn;     /* overlapping pairs found, in coordinate form */
+  int npairs, maxpairs;
+} overlap_workspace;
+
+static void overlap_workspace_init(overlap_workspace *ws){
+  memset(ws, 0, sizeof(*ws));
 }
 
-static void NodePrint(const void* a) {
-  const scan_point *aa;
-
-  aa = (const scan_point *) a;
-  fprintf(stderr, "node {%d, %f, %d}\n", aa->node, aa->x, aa->status);
-
+static void overlap_workspace_free(overlap_workspace *ws){
+  FREE(ws->boxes);
+  FREE(ws->active);
+  FREE(ws->irn);
+  FREE(ws->jcn);
 }
 
-static void InfoPrint(void* a) {
+static void add_overlap_pair(overlap_workspace *ws, int i, int j){
+  if (ws->npairs + 2 > ws->maxpairs){
+    ws->maxpairs = MAX(2*ws->maxpairs, 64);
+    ws->irn = RALLOC(ws->maxpairs, ws->irn, int);
+    ws->jcn = RALLOC(ws->maxpairs, ws->jcn, int);
+  }
+  ws->irn[ws->npairs] = i;
+  ws->jcn[ws->npairs++] = j;
+  ws->irn[ws->npairs] = j;
+  ws->jcn[ws->npairs++] = i;
 }
 
-static void InfoDest(void *a){
+static int comp_overlap_boxes(const void *p, const void *q){
+  const overlap_box *pp = (const overlap_box *) p;
+  const overlap_box *qq = (const overlap_box *) q;
+  if (pp->xlo > qq->xlo){
+    return 1;
+  } else if (pp->xlo < qq->xlo){
+    return -1;
+  }
+  return pp->node - qq->node;
 }
 
-static SparseMatrix get_overlap_graph(int dim, int n, real *x, real *width, int check_overlap_only){
-  /* if check_overlap_only = TRUE, we only check whether there is one overlap */
-  scan_point *scanpointsx, *scanpointsy;
-  int i, k, neighbor;
-  SparseMatrix A = NULL, B = NULL;
-  rb_red_blk_node *newNode, *newNode0, *newNode2 = NULL;
-  rb_red_blk_tree* treey;
-  real one = 1;
+static int overlap_sweep(overlap_workspace *ws, int dim, int n, real *x, real *width, int check_overlap_only){
+  /* find the pairs of overlapping boxes, leaving them in ws->irn/ws->jcn.
+     Returns whether there is any overlap. If check_overlap_only = TRUE, we
+     stop at the first overlap found and record no pairs.
 
-  A = SparseMatrix_new(n, n, 1, MATRIX_TYPE_REAL, FORMAT_COORD);
-
-  scanpointsx = N_GNEW(2*n,scan_point);
-  for (i = 0; i < n; i++){
-    scanpointsx[2*i].node = i;
-    scanpointsx[2*i].x = x[i*dim] - width[i*dim];
-    scanpointsx[2*i].status = INTV_OPEN;
-    scanpointsx[2*i+1].node = i+n;
-    scanpointsx[2*i+1].x = x[i*dim] + width[i*dim];
-    scanpointsx[2*i+1].status = INTV_CLOSE;
+     Sort and sweep: boxes are visited in order of their left edge, keeping a
+     flat array of the boxes whose x-extent still reaches the current one.
+     Boxes that touch in x are treated as overlapping in x, while in y the
+     centers have to be strictly closer than the sum of the half heights.
+  */
+  overlap_box *boxes;
+  int *active;
+  int i, k, nactive = 0;
+
+  if (n > ws->n){
+    ws->boxes = RALLOC(n, ws->boxes, overlap_box);
+    ws->active = RALLOC(n, ws->active, int);
+    ws->n = n;
   }
-  qsort(scanpointsx, 2*n, sizeof(scan_point), comp_scan_points);
+  boxes = ws->boxes;
+  active = ws->active;
+  ws->npairs = 0;
 
-  scanpointsy = N_GNEW(2*n,scan_point);
   for (i = 0; i < n; i++){
-    scanpointsy[i].node = i;
-    scanpointsy[i].x = x[i*dim+1] - width[i*dim+1];
-    scanpointsy[i].status = INTV_OPEN;
-    scanpointsy[i+n].node = i;
-    scanpointsy[i+n].x = x[i*dim+1] + width[i*dim+1];
-    scanpointsy[i+n].status = INTV_CLOSE;
+    boxes[i].xlo = x[i*dim] - width[i*dim];
+    boxes[i].xhi = x[i*dim] + width[i*dim];
+    boxes[i].ylo = x[i*dim+1] - width[i*dim+1];
+    boxes[i].yhi = x[i*dim+1] + width[i*dim+1];
+    boxes[i].node = i;
   }
+  qsort(boxes, n, sizeof(overlap_box), comp_overlap_boxes);
 
-
-  treey = RBTreeCreate(NodeComp,NodeDest,InfoDest,NodePrint,InfoPrint);
-
-  for (i = 0; i < 2*n; i++){
-#ifdef DEBUG_RBTREE
-    fprintf(stderr," k = %d node = %d x====%f\n",(scanpointsx[i].node)%n, (scanpointsx[i].node), (scanpointsx[i].x));
-#endif
-
-    k = (scanpointsx[i].node)%n;
-
-
-    if (scanpointsx[i].status == INTV_OPEN){
-#ifdef DEBUG_RBTREE
-      fprintf(stderr, "inserting...");
-      treey->PrintKey(&(scanpointsy[k]));
-#endif
-
-      RBTreeInsert(treey, &(scanpointsy[k]), NULL); /* add both open and close int for y */
-
-#ifdef DEBUG_RBTREE
-      fprintf(stderr, "inserting2...");
-      treey->PrintKey(&(scanpointsy[k+n]));
-#endif
-
-      RBTreeInsert(treey, &(scanpointsy[k+n]), NULL);
-    } else {
-      real bsta, bbsta, bsto, bbsto; int ii; 
-
-      assert(scanpointsx[i].node >= n);
-
-      newNode = newNode0 = RBExactQuery(treey, &(scanpointsy[k + n]));
-      ii = ((scan_point *)newNode->key)->node;
-      assert(ii < n);
-      bsta = scanpointsy[ii].x; bsto = scanpointsy[ii+n].x;
-
-#ifdef DEBUG_RBTREE
-      fprintf(stderr, "poping..%d....yinterval={%f,%f}\n", scanpointsy[k + n].node, bsta, bsto);
-      treey->PrintKey(newNode->key);
-#endif
-
-     assert(treey->nil != newNode);
-      while ((newNode) && ((newNode = TreePredecessor(treey, newNode)) != treey->nil)){
-	neighbor = (((scan_point *)newNode->key)->node)%n;
-	bbsta = scanpointsy[neighbor].x; bbsto = scanpointsy[neighbor+n].x;/* the y-interval of the node that has one end of the interval lower than the top of the leaving interval (bsto) */
-#ifdef DEBUG_RBTREE
-	fprintf(stderr," predecessor is node %d y = %f\n", ((scan_point *)newNode->key)->node, ((scan_point *)newNode->key)->x);
-#endif
-	if (neighbor != k){
-	  if (fabs(0.5*(bsta+bsto) - 0.5*(bbsta+bbsto)) < 0.5*(bsto-bsta) + 0.5*(bbsto-bbsta)){/* if the distance of the centers of the interval is less than sum of width, we have overlap */
-	    A = SparseMatrix_coordinate_form_add_entries(A, 1, &neighbor, &k, &one);
-#ifdef DEBUG_RBTREE
-	    fprintf(stderr,"======================================  %d %d\n",k,neighbor);
-#endif
-	    if (check_overlap_only) goto check_overlap_RETURN;
-	  }
-	} else {
-	  newNode2 = newNode;
-	}
-
-      }
-
-#ifdef DEBUG_RBTREE
-      fprintf(stderr, "deleteing...");
-      treey->PrintKey(newNode0->key);
-#endif
-
-      if (newNode0) RBDelete(treey,newNode0);
-
-
-     if (newNode2 && newNode2 != treey->nil && newNode2 != newNode0) {
-
-#ifdef DEBUG_RBTREE
-	fprintf(stderr, "deleteing2...");
-	treey->PrintKey(newNode2->key);
-#endif
-
-	if (newNode0) RBDelete(treey,newNode2);
+  for (i = 0; i < n; i++){
+    const overlap_box *b = &boxes[i];
+    int kept = 0;
+    for (k = 0; k < nactive; k++){
+      const overlap_box *a = &boxes[active[k]];
+      if (a->xhi < b->xlo) continue; /* a is now left of the sweep line */
+      active[kept++] = active[k];
+      if (fabs(0.5*(a->ylo+a->yhi) - 0.5*(b->ylo+b->yhi)) < 0.5*(a->yhi-a->ylo) + 0.5*(b->yhi-b->ylo)){
+	if (check_overlap_only) return TRUE;
+	add_overlap_pair(ws, a->node, b->node);
       }
-
     }
+    nactive = kept;
+    active[nactive++] = i;
   }
 
-check_overlap_RETURN:
-   FREE(scanpointsx);
-  FREE(scanpointsy);
-  RBTreeDestroy(treey);
+  return ws->npairs > 0;
+}
+
+static SparseMatrix get_overlap_graph(int dim, int n, real *x, real *width){
+  overlap_workspace ws;
+  SparseMatrix A;
 
-  B = SparseMatrix_from_coordinate_format(A);
-  SparseMatrix_delete(A);
-  A = SparseMatrix_symmetrize(B, FALSE);
-  SparseMatrix_delete(B);
+  overlap_workspace_init(&ws);
+  overlap_sweep(&ws, dim, n, x, width, FALSE);
+
+  /* callers add this to real matrices, so give it unit entries */
+  A = SparseMatrix_from_coordinate_arrays(ws.npairs, n, n, ws.irn, ws.jcn, NULL, MATRIX_TYPE_PATTERN, 0);
+  A = SparseMatrix_set_entries_to_real_one(A);
+  SparseMatrix_set_symmetric(A);
+  SparseMatrix_set_pattern_symmetric(A);
   if (Verbose) fprintf(stderr, "found %d clashes\n", A->nz);
+
+  overlap_workspace_free(&ws);
   return A;
 }
 
@@ -302,26 +244,26 @@ real overlap_scaling(int dim, int m, real *x, real *width, real scale_sta, real
      - for scaling up, we assume scale_sta, scale_sto <= 0
    */
   real scale = -1, scale_best = -1;
-  SparseMatrix C = NULL;
   int check_overlap_only = 1;
   int overlap = 0;
   real two = 2;
   int iter = 0;
+  overlap_workspace ws;
 
   assert(epsilon > 0);
 
+  overlap_workspace_init(&ws);
+
   if (scale_sta <= 0) {
     scale_sta = 0;
   } else {
     scale_coord(dim, m, x, scale_sta);
-    C = get_overlap_graph(dim, m, x, width, check_overlap_only);
-    if (!C || C->nz == 0) {
+    if (!overlap_sweep(&ws, dim, m, x, width, check_overlap_only)) {
       if (Verbose) fprintf(stderr," shrinking with %f works\n", scale_sta);
-      SparseMatrix_delete(C);
+      overlap_workspace_free(&ws);
       return scale_sta;
     }
     scale_coord(dim, m, x, 1./scale_sta);
-    SparseMatrix_delete(C);
   }
 
   if (scale_sto < 0){
@@ -334,9 +276,7 @@ real overlap_scaling(int dim, int m, real *x, real *width, real scale_sta, real
     do {
       scale_sto *= two;
       scale_coord(dim, m, x, two);
-      C = get_overlap_graph(dim, m, x, width, check_overlap_only);
-      overlap = (C && C->nz > 0);
-      SparseMatrix_delete(C);
+      overlap = overlap_sweep(&ws, dim, m, x, width, check_overlap_only);
     } while (overlap);
     scale_coord(dim, m, x, 1/scale_sto);/* unscale */
   }
@@ -348,10 +288,8 @@ real overlap_scaling(int dim, int m, real *x, real *width, real scale_sta, real
 
     scale = 0.5*(scale_sta + scale_sto);
     scale_coord(dim, m, x, scale);
-    C = get_overlap_graph(dim, m, x, width, check_overlap_only);
+    overlap = overlap_sweep(&ws, dim, m, x, width, check_overlap_only);
     scale_coord(dim, m, x, 1./scale);/* unscale */
-    overlap = (C && C->nz > 0);
-    SparseMatrix_delete(C);
     if (overlap){
       scale_sta = scale;
     } else {
@@ -359,6 +297,8 @@ real overlap_scaling(int dim, int m, real *x, real *width, real scale_sta, real
     }
   }
 
+  overlap_workspace_free(&ws);
+
   /* final scaling */
   scale_coord(dim, m, x, scale_best);
   return scale_best;
@@ -396,7 +336,7 @@ OverlapSmoother OverlapSmoother_new(SparseMatrix A, int m,
 
   if (!neighborhood_only){
     SparseMatrix C, D;
-    C = get_overlap_graph(dim, m, x, width, 0);
+    C = get_overlap_graph(dim, m, x, width);
     D = SparseMatrix_add(B, C);
     SparseMatrix_delete(B);
     SparseMatrix_delete(C);
@@ -66,35 +66,38 @@ void free_array(double **rv)
 }
 
 
+/* new_3array:
+ * As new_array, the m x n vectors of size p share one block of memory,
+ * as do the rows of pointers to them.
+ */
 static double ***new_3array(int m, int n, int p, double ival)
 {
     double ***rv;
-    int i, j, k;
-
-    rv = N_NEW(m + 1, double **);
-    for (i = 0; i < m; i++) {
-	rv[i] = N_NEW(n + 1, double *);
-	for (j = 0; j < n; j++) {
-	    rv[i][j] = N_NEW(p, double);
-	    for (k = 0; k < p; k++)
+    double **vecs;
+    double *mem;
+    size_t i, j, k;
+
+    rv = N_NEW(m, double **);
+    vecs = N_NEW((size_t)m * n, double *);
+    mem = N_NEW((size_t)m * n * p, double);
+    for (i = 0; i < (size_t)m; i++) {
+	rv[i] = vecs;
+	vecs += n;
+	for (j = 0; j < (size_t)n; j++) {
+	    rv[i][j] = mem;
+	    mem += p;
+	    for (k = 0; k < (size_t)p; k++)
 		rv[i][j][k] = ival;
 	}
-	rv[i][j] = NULL;	/* NULL terminate so we can clean up */
     }
-    rv[i] = NULL;
     return rv;
 }
 
 static void free_3array(double ***rv)
 {
-    int i, j;
-
     if (rv) {
-	for (i = 0; rv[i]; i++) {
-	    for (j = 0; rv[i][j]; j++)
-		free(rv[i][j]);
-	    free(rv[i]);
-	}
+	free(rv[0][0]);
+	free(rv[0]);
 	free(rv);
     }
 }
@@ -149,17 +149,6 @@ static void insertFn(Agnode_t * n, void *state)
     agsubnode((Agraph_t *) state,n,1);
 }
 
-/* markFn:
- */
-static int markFn (Agnode_t* n, int v)
-{
-    int ret;
-    if (v < 0) return ND_mark(n);
-    ret = ND_mark(n);
-    ND_mark(n) = (char) v;
-    return ret;
-}
-
 /* setPrefix:
  */
 static char*
@@ -182,6 +171,107 @@ setPrefix (char* pfx, size_t* lenp, char* buf, size_t buflen)
     return name;
 }
 
+/* find:
+ * Return the representative of the set containing i, halving the path
+ * to it on the way.
+ */
+static int find(int *parent, int i)
+{
+    while (parent[i] != i) {
+	parent[i] = parent[parent[i]];
+	i = parent[i];
+    }
+    return i;
+}
+
+/* ccompsIds:
+ * Label the nodes of g with the index of their connected component,
+ * without creating any subgraphs. The result is indexed by the position
+ * of each node in the agfstnode/agnxtnode order of g, and components are
+ * numbered in the order of their first node, as ccomps numbers its
+ * subgraphs. The number of components is returned in ncc.
+ * The caller must free the result.
+ * Returns NULL if graph is empty.
+ */
+int *ccompsIds(Agraph_t * g, int *ncc)
+{
+    int nn = agnnodes(g);
+    int *pos, *parent, *ids;
+    int i, c_cnt;
+    Agnode_t *n;
+    Agedge_t *e;
+
+    if (nn == 0) {
+	*ncc = 0;
+	return 0;
+    }
+
+    /* position of each node, by sequence number */
+    pos = N_GNEW((size_t) AGSEQ(aglstnode(g)) + 1, int);
+    parent = N_GNEW(nn, int);
+    i = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	pos[AGSEQ(n)] = i;
+	parent[i] = i;
+	i++;
+    }
+
+    /* union-find over the edges, keeping the earliest node of each set as
+     * its representative */
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    int t = find(parent, pos[AGSEQ(n)]);
+	    int h = find(parent, pos[AGSEQ(aghead(e))]);
+	    if (t < h)
+		parent[h] = t;
+	    else if (h < t)
+		parent[t] = h;
+	}
+    }
+    free(pos);
+
+    /* a node is the first of its component iff it represents it */
+    ids = N_GNEW(nn, int);
+    c_cnt = 0;
+    for (i = 0; i < nn; i++) {
+	int r = find(parent, i);
+	ids[i] = r == i ? c_cnt++ : ids[r];
+    }
+    free(parent);
+
+    *ncc = c_cnt;
+    return ids;
+}
+
+/* mkComps:
+ * Create the subgraphs of g for ncc components, and add each node to the
+ * one given by ids.
+ */
+static Agraph_t **mkComps(Agraph_t * g, int *ids, int ncc, char *pfx)
+{
+    char buffer[SMALLBUF];
+    char *name;
+    size_t len;
+    Agraph_t **ccs;
+    Agnode_t *n;
+    int i;
+
+    name = setPrefix (pfx, &len, buffer, SMALLBUF);
+    ccs = N_GNEW(ncc, Agraph_t *);
+    for (i = 0; i < ncc; i++) {
+	sprintf(name + len, "%d", i);
+	ccs[i] = agsubg(g, name, 1);
+	agbindrec(ccs[i], "Agraphinfo_t", sizeof(Agraphinfo_t), TRUE);	//node custom data
+    }
+    i = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	agsubnode(ccs[ids[i++]], n, 1);
+
+    if (name != buffer)
+	free(name);
+    return ccs;
+}
+
 /* pccomps:
  * Return an array of subgraphs consisting of the connected 
  * components of graph g. The number of components is returned in ncc. 
@@ -196,85 +286,42 @@ setPrefix (char* pfx, size_t* lenp, char* buf, size_t buflen)
  */
 Agraph_t **pccomps(Agraph_t * g, int *ncc, char *pfx, boolean * pinned)
 {
-    size_t c_cnt = 0;
-    char buffer[SMALLBUF];
-    char *name;
-    Agraph_t *out = 0;
+    int *ids, *newid;
+    int c_cnt, i, cnt;
     Agnode_t *n;
     Agraph_t **ccs;
-    size_t len;
-    size_t bnd = 10;
     boolean pin = FALSE;
-    stk_t stk;
-    blk_t blk;
-    Agnode_t* base[INITBUF];
-    int error = 0;
 
-    if (agnnodes(g) == 0) {
+    if (!(ids = ccompsIds(g, &c_cnt))) {
 	*ncc = 0;
 	return 0;
     }
-    name = setPrefix (pfx, &len, buffer, SMALLBUF);
-
-    ccs = N_GNEW(bnd, Agraph_t *);
-
-    initStk (&stk, &blk, base, insertFn, markFn);
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	UNMARK(&stk,n);
 
-    /* Component with pinned nodes */
+    /* the components holding pinned nodes become the first one */
+    newid = N_GNEW(c_cnt, int);
+    for (i = 0; i < c_cnt; i++)
+	newid[i] = -1;
+    i = 0;
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (MARKED(&stk,n) || !isPinned(n))
-	    continue;
-	if (!out) {
-	    sprintf(name + len, "%zu", c_cnt);
-	    out = agsubg(g, name,1);
-	    agbindrec(out, "Agraphinfo_t", sizeof(Agraphinfo_t), TRUE);	//node custom data
-	    ccs[c_cnt] = out;
-	    c_cnt++;
+	if (isPinned(n)) {
+	    newid[ids[i]] = 0;
 	    pin = TRUE;
 	}
-	if (dfs (g, n, out, &stk) == SIZE_MAX) {
-	    error = 1;
-	    goto packerror;
-	}
-    }
-
-    /* Remaining nodes */
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (MARKED(&stk,n))
-	    continue;
-	sprintf(name + len, "%zu", c_cnt);
-	out = agsubg(g, name,1);
-	agbindrec(out, "Agraphinfo_t", sizeof(Agraphinfo_t), TRUE);	//node custom data
-	if (dfs(g, n, out, &stk) == SIZE_MAX) {
-	    error = 1;
-	    goto packerror;
-	}
-	if (c_cnt == bnd) {
-	    bnd *= 2;
-	    ccs = RALLOC(bnd, ccs, Agraph_t *);
-	}
-	ccs[c_cnt] = out;
-	c_cnt++;
-    }
-packerror:
-    freeStk (&stk);
-    if (name != buffer)
-	free(name);
-    if (error) {
-	*ncc = 0;
-	for (size_t i=0; i < c_cnt; i++) {
-	    agclose (ccs[i]);
-	}
-	free (ccs);
-	ccs = NULL;
+	i++;
     }
-    else {
-	ccs = RALLOC(c_cnt, ccs, Agraph_t *);
-	*ncc = (int) c_cnt;
-	*pinned = pin;
+    cnt = pin ? 1 : 0;
+    for (i = 0; i < c_cnt; i++) {
+	if (newid[i] < 0)
+	    newid[i] = cnt++;
     }
+    for (i = 0, n = agfstnode(g); n; i++, n = agnxtnode(g, n))
+	ids[i] = newid[ids[i]];
+    free(newid);
+
+    ccs = mkComps(g, ids, cnt, pfx);
+    free(ids);
+    *ncc = cnt;
+    *pinned = pin;
     return ccs;
 }
 
@@ -289,55 +336,17 @@ packerror:
  */
 Agraph_t **ccomps(Agraph_t * g, int *ncc, char *pfx)
 {
-    size_t c_cnt = 0;
-    char buffer[SMALLBUF];
-    char *name;
-    Agraph_t *out;
-    Agnode_t *n;
+    int *ids;
+    int c_cnt;
     Agraph_t **ccs;
-    size_t len;
-    size_t bnd = 10;
-    stk_t stk;
-    blk_t blk;
-    Agnode_t* base[INITBUF];
 
-    if (agnnodes(g) == 0) {
+    if (!(ids = ccompsIds(g, &c_cnt))) {
 	*ncc = 0;
 	return 0;
     }
-    name = setPrefix (pfx, &len, buffer, SMALLBUF);
-
-    ccs = N_GNEW(bnd, Agraph_t *);
-    initStk (&stk, &blk, base, insertFn, markFn);
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	UNMARK(&stk,n);
-
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (MARKED(&stk,n))
-	    continue;
-	sprintf(name + len, "%zu", c_cnt);
-	out = agsubg(g, name,1);
-	agbindrec(out, "Agraphinfo_t", sizeof(Agraphinfo_t), TRUE);	//node custom data
-	if (dfs(g, n, out, &stk) == SIZE_MAX) {
-	    freeStk (&stk);
-	    free (ccs);
-	    if (name != buffer)
-	        free(name);
-	    *ncc = 0;
-	    return NULL;
-	}
-	if (c_cnt == bnd) {
-	    bnd *= 2;
-	    ccs = RALLOC(bnd, ccs, Agraph_t *);
-	}
-	ccs[c_cnt] = out;
-	c_cnt++;
-    }
-    freeStk (&stk);
-    ccs = RALLOC(c_cnt, ccs, Agraph_t *);
-    if (name != buffer)
-	free(name);
-    *ncc = (int) c_cnt;
+    ccs = mkComps(g, ids, c_cnt, pfx);
+    free(ids);
+    *ncc = c_cnt;
     return ccs;
 }
 
@@ -694,29 +703,15 @@ Agraph_t **cccomps(Agraph_t * g, int *ncc, char *pfx)
  */
 int isConnected(Agraph_t * g)
 {
-    Agnode_t *n;
-    int ret = 1;
-    size_t cnt = 0;
-    stk_t stk;
-    blk_t blk;
-    Agnode_t* base[INITBUF];
+    int *ids;
+    int c_cnt;
 
     if (agnnodes(g) == 0)
 	return 1;
 
-    initStk (&stk, &blk, base, NULL, markFn);
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	UNMARK(&stk,n);
-
-    n = agfstnode(g);
-    cnt = dfs(g, agfstnode(g), NULL, &stk);
-    freeStk (&stk);
-    if (cnt == SIZE_MAX) { /* dfs failed */
-	return -1;
-    }
-    if (cnt != (size_t) agnnodes(g))
-	ret = 0;
-    return ret;
+    ids = ccompsIds(g, &c_cnt);
+    free(ids);
+    return c_cnt == 1;
 }
 
 /* nodeInduce:
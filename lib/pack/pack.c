@@ -20,6 +20,8 @@
 #include <pack/pack.h>
 #include <common/pointset.h>
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
 
 #define strneq(a,b,n)		(!strncmp(a,b,n))
 
@@ -38,8 +40,28 @@ typedef struct {
     point *cells;		/* cells in covering polyomino */
     int nc;			/* no. of cells */
     int index;			/* index in original array */
+    /* the cells as a bitmap: row r, word k holds cells (mx + 64*k + b, my + r)
+     * for bits b */
+    int mx, my;
+    int mw, mh;			/* words per row, rows */
+    uint64_t *mask;
 } ginfo;
 
+/* Cells taken by the polyominoes placed so far, one bit per cell. Row r,
+ * word k holds cells (x0 + 64*k + b, y0 + r) for bits b. Cells outside the
+ * map are free. x0 is a multiple of 64, so the map grows by whole words.
+ */
+typedef struct {
+    int x0, y0;
+    int nw, h;			/* words per row, rows */
+    uint64_t *bits;
+} cellmap_t;
+
+#define WORDBITS 64
+
+/* floor of v / WORDBITS */
+#define WORD(v) ((v) >= 0 ? (v) / WORDBITS : ((v) + 1) / WORDBITS - 1)
+
 typedef struct {
     double width, height;
     int index;			/* index in original array */
@@ -215,6 +237,38 @@ fillEdge(Agedge_t * e, point p, PointSet * ps, int dx, int dy,
 
 }
 
+/* genMask:
+ * Set up the bitmap form of the polyomino's cells.
+ */
+static void genMask(ginfo * info)
+{
+    point *cells = info->cells;
+    int i, x, y, maxx, maxy;
+
+    if (info->nc == 0) {
+	info->mx = info->my = info->mw = info->mh = 0;
+	info->mask = NULL;
+	return;
+    }
+    info->mx = maxx = cells[0].x;
+    info->my = maxy = cells[0].y;
+    for (i = 1; i < info->nc; i++) {
+	info->mx = MIN(info->mx, cells[i].x);
+	info->my = MIN(info->my, cells[i].y);
+	maxx = MAX(maxx, cells[i].x);
+	maxy = MAX(maxy, cells[i].y);
+    }
+    info->mw = (maxx - info->mx) / WORDBITS + 1;
+    info->mh = maxy - info->my + 1;
+    info->mask = N_NEW(info->mw * info->mh, uint64_t);
+    for (i = 0; i < info->nc; i++) {
+	x = cells[i].x - info->mx;
+	y = cells[i].y - info->my;
+	info->mask[y * info->mw + x / WORDBITS] |=
+	    (uint64_t)1 << (x % WORDBITS);
+    }
+}
+
 /* genBox:
  * Generate polyomino info from graph using the bounding box of
  * the graph.
@@ -223,14 +277,13 @@ static void
 genBox(boxf bb0, ginfo * info, int ssize, unsigned int margin, point center,
 	char* s)
 {
-    PointSet *ps;
     int W, H;
     point UR, LL;
     box bb;
     int x, y;
+    point *cells;
 
     BF2B(bb0, bb);
-    ps = newPS();
 
     LL.x = center.x - margin;
     LL.y = center.y - margin;
@@ -239,12 +292,16 @@ genBox(boxf bb0, ginfo * info, int ssize, unsigned int margin, point center,
     CELL(LL, ssize);
     CELL(UR, ssize);
 
+    /* the cells of a box are distinct, so no point set is needed */
+    info->nc = (UR.x - LL.x + 1) * (UR.y - LL.y + 1);
+    info->cells = cells = N_NEW(info->nc, point);
     for (x = LL.x; x <= UR.x; x++)
-	for (y = LL.y; y <= UR.y; y++)
-	    addPS(ps, x, y);
-
-    info->cells = pointsOf(ps);
-    info->nc = sizeOf(ps);
+	for (y = LL.y; y <= UR.y; y++) {
+	    cells->x = x;
+	    cells->y = y;
+	    cells++;
+	}
+    genMask(info);
     W = GRID(bb0.UR.x - bb0.LL.x + 2 * margin, ssize);
     H = GRID(bb0.UR.y - bb0.LL.y + 2 * margin, ssize);
     info->perim = W + H;
@@ -257,8 +314,6 @@ genBox(boxf bb0, ginfo * info, int ssize, unsigned int margin, point center,
 	    fprintf(stderr, "  %d %d cell\n", info->cells[i].x,
 		    info->cells[i].y);
     }
-
-    freePS(ps);
 }
 
 /* genPoly:
@@ -395,6 +450,7 @@ genPoly(Agraph_t * root, Agraph_t * g, ginfo * info,
 
     info->cells = pointsOf(ps);
     info->nc = sizeOf(ps);
+    genMask(info);
     W = GRID(GD_bb(g).UR.x - GD_bb(g).LL.x + 2 * margin, ssize);
     H = GRID(GD_bb(g).UR.y - GD_bb(g).LL.y + 2 * margin, ssize);
     info->perim = W + H;
@@ -412,40 +468,157 @@ genPoly(Agraph_t * root, Agraph_t * g, ginfo * info,
     return 0;
 }
 
+/* newCellmap:
+ * Return an empty occupancy map. It covers no cells until growCellmap
+ * is first called, and every cell outside it counts as free.
+ */
+static cellmap_t *newCellmap(void)
+{
+    return NEW(cellmap_t);
+}
+
+static void freeCellmap(cellmap_t * map)
+{
+    free(map->bits);
+    free(map);
+}
+
+/* growCellmap:
+ * Make the map cover the cells from LL to UR. The map grows by at least
+ * half in each direction it grows in, so that placing many polyominoes
+ * costs amortized linear time.
+ */
+static void growCellmap(cellmap_t * map, point LL, point UR)
+{
+    int x0, y0, x1, y1, nw, h, r;
+    uint64_t *bits;
+
+    if (map->bits && WORD(LL.x) >= map->x0 / WORDBITS &&
+	WORD(UR.x) < map->x0 / WORDBITS + map->nw && LL.y >= map->y0 &&
+	UR.y < map->y0 + map->h)
+	return;
+
+    /* bounds, in words for x */
+    x0 = WORD(LL.x);
+    x1 = WORD(UR.x);
+    y0 = LL.y;
+    y1 = UR.y;
+    if (map->bits) {
+	if (x0 < map->x0 / WORDBITS)
+	    x0 = MIN(x0, map->x0 / WORDBITS - (map->nw + 1) / 2);
+	else
+	    x0 = map->x0 / WORDBITS;
+	if (x1 >= map->x0 / WORDBITS + map->nw)
+	    x1 = MAX(x1, map->x0 / WORDBITS + map->nw - 1 + (map->nw + 1) / 2);
+	else
+	    x1 = map->x0 / WORDBITS + map->nw - 1;
+	if (y0 < map->y0)
+	    y0 = MIN(y0, map->y0 - (map->h + 1) / 2);
+	else
+	    y0 = map->y0;
+	if (y1 >= map->y0 + map->h)
+	    y1 = MAX(y1, map->y0 + map->h - 1 + (map->h + 1) / 2);
+	else
+	    y1 = map->y0 + map->h - 1;
+    }
+    nw = x1 - x0 + 1;
+    h = y1 - y0 + 1;
+
+    bits = N_NEW(nw * h, uint64_t);
+    if (map->bits) {
+	for (r = 0; r < map->h; r++)
+	    memcpy(bits + (map->y0 + r - y0) * nw + map->x0 / WORDBITS - x0,
+		   map->bits + r * map->nw, map->nw * sizeof(uint64_t));
+	free(map->bits);
+    }
+    map->bits = bits;
+    map->x0 = x0 * WORDBITS;
+    map->y0 = y0;
+    map->nw = nw;
+    map->h = h;
+}
+
+/* markCells:
+ * Add the cells of the polyomino, moved by (x,y), to the map.
+ */
+static void markCells(cellmap_t * map, ginfo * info, int x, int y)
+{
+    point *cells = info->cells;
+    point LL, UR;
+    int i, cx;
+
+    if (info->nc == 0)
+	return;
+    LL.x = x + info->mx;
+    LL.y = y + info->my;
+    UR.x = LL.x + info->mw * WORDBITS - 1;
+    UR.y = LL.y + info->mh - 1;
+    growCellmap(map, LL, UR);
+
+    for (i = 0; i < info->nc; i++) {
+	cx = cells[i].x + x - map->x0;
+	map->bits[(cells[i].y + y - map->y0) * map->nw + cx / WORDBITS] |=
+	    (uint64_t)1 << (cx % WORDBITS);
+    }
+}
+
+/* collides:
+ * Check if any cell of the polyomino, moved by (x,y), is taken.
+ * This compares a word of the polyomino's mask, shifted into place,
+ * against the map at a time.
+ */
+static boolean collides(cellmap_t * map, ginfo * info, int x, int y)
+{
+    int c, q, s, r, r0, r1, k, w;
+    uint64_t m, *row, *mrow;
+
+    if (!map->bits)
+	return FALSE;
+
+    /* rows of the mask that fall on the map */
+    r0 = MAX(0, map->y0 - (y + info->my));
+    r1 = MIN(info->mh, map->y0 + map->h - (y + info->my));
+
+    /* word and bit of the map where the first column of the mask falls */
+    c = x + info->mx - map->x0;
+    q = WORD(c);
+    s = c - q * WORDBITS;
+
+    for (r = r0; r < r1; r++) {
+	row = map->bits + (y + info->my + r - map->y0) * map->nw;
+	mrow = info->mask + r * info->mw;
+	for (k = 0; k < info->mw; k++) {
+	    if (!(m = mrow[k]))
+		continue;
+	    w = q + k;
+	    if (w >= 0 && w < map->nw && (row[w] & (m << s)))
+		return TRUE;
+	    if (s && w + 1 >= 0 && w + 1 < map->nw
+		&& (row[w + 1] & (m >> (WORDBITS - s))))
+		return TRUE;
+	}
+    }
+    return FALSE;
+}
+
 /* fits:
  * Check if polyomino fits at given point.
- * If so, add cells to pointset, store point in place and return true.
+ * If so, add cells to the map, store point in place and return true.
  */
 static int
-fits(int x, int y, ginfo * info, PointSet * ps, point * place, int step, boxf* bbs)
+fits(int x, int y, ginfo * info, cellmap_t * map, point * place, int step, boxf* bbs)
 {
-    point *cells = info->cells;
     int n = info->nc;
-    point cell;
-    int i;
     point LL;
 
-    for (i = 0; i < n; i++) {
-	cell = *cells;
-	cell.x += x;
-	cell.y += y;
-	if (inPS(ps, cell))
-	    return 0;
-	cells++;
-    }
+    if (collides(map, info, x, y))
+	return 0;
 
     PF2P(bbs[info->index].LL, LL);
     place->x = step * x - LL.x;
     place->y = step * y - LL.y;
 
-    cells = info->cells;
-    for (i = 0; i < n; i++) {
-	cell = *cells;
-	cell.x += x;
-	cell.y += y;
-	insertPS(ps, cell);
-	cells++;
-    }
+    markCells(map, info, x, y);
 
     if (Verbose >= 2)
 	fprintf(stderr, "cc (%d cells) at (%d,%d) (%d,%d)\n", n, x, y,
@@ -459,18 +632,14 @@ fits(int x, int y, ginfo * info, PointSet * ps, point * place, int step, boxf* b
  * graph is constructed where it will be.
  */
 static void
-placeFixed(ginfo * info, PointSet * ps, point * place, point center)
+placeFixed(ginfo * info, cellmap_t * map, point * place, point center)
 {
-    point *cells = info->cells;
     int n = info->nc;
-    int i;
 
     place->x = -center.x;
     place->y = -center.y;
 
-    for (i = 0; i < n; i++) {
-	insertPS(ps, *cells++);
-    }
+    markCells(map, info, 0, 0);
 
     if (Verbose >= 2)
 	fprintf(stderr, "cc (%d cells) at (%d,%d)\n", n, place->x,
@@ -484,7 +653,7 @@ placeFixed(ginfo * info, PointSet * ps, point * place, point center)
  * First graph (i == 0) is centered on the origin if possible.
  */
 static void
-placeGraph(int i, ginfo * info, PointSet * ps, point * place, int step,
+placeGraph(int i, ginfo * info, cellmap_t * map, point * place, int step,
 	   unsigned int margin, boxf* bbs)
 {
     int x, y;
@@ -495,11 +664,11 @@ placeGraph(int i, ginfo * info, PointSet * ps, point * place, int step,
     if (i == 0) {
 	W = GRID(bb.UR.x - bb.LL.x + 2 * margin, step);
 	H = GRID(bb.UR.y - bb.LL.y + 2 * margin, step);
-	if (fits(-W / 2, -H / 2, info, ps, place, step, bbs))
+	if (fits(-W / 2, -H / 2, info, map, place, step, bbs))
 	    return;
     }
 
-    if (fits(0, 0, info, ps, place, step, bbs))
+    if (fits(0, 0, info, map, place, step, bbs))
 	return;
     W = ceil(bb.UR.x - bb.LL.x);
     H = ceil(bb.UR.y - bb.LL.y);
@@ -508,19 +677,19 @@ placeGraph(int i, ginfo * info, PointSet * ps, point * place, int step,
 	    x = 0;
 	    y = -bnd;
 	    for (; x < bnd; x++)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; y < bnd; y++)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; x > -bnd; x--)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; y > -bnd; y--)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; x < 0; x++)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	}
     } else {
@@ -528,19 +697,19 @@ placeGraph(int i, ginfo * info, PointSet * ps, point * place, int step,
 	    y = 0;
 	    x = -bnd;
 	    for (; y > -bnd; y--)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; x < bnd; x++)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; y < bnd; y++)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; x > -bnd; x--)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	    for (; y > 0; y--)
-		if (fits(x, y, info, ps, place, step, bbs))
+		if (fits(x, y, info, map, place, step, bbs))
 		    return;
 	}
     }
@@ -723,7 +892,7 @@ polyRects(int ng, boxf* gs, pack_info * pinfo)
     ginfo *info;
     ginfo **sinfo;
     point *places;
-    Dict_t *ps;
+    cellmap_t *map;
     int i;
     point center;
 
@@ -749,17 +918,19 @@ polyRects(int ng, boxf* gs, pack_info * pinfo)
     }
     qsort(sinfo, ng, sizeof(ginfo *), cmpf);
 
-    ps = newPS();
+    map = newCellmap();
     places = N_NEW(ng, point);
     for (i = 0; i < ng; i++)
-	placeGraph(i, sinfo[i], ps, places + (sinfo[i]->index),
+	placeGraph(i, sinfo[i], map, places + (sinfo[i]->index),
 		       stepSize, pinfo->margin, gs);
 
     free(sinfo);
-    for (i = 0; i < ng; i++)
+    for (i = 0; i < ng; i++) {
 	free(info[i].cells);
+	free(info[i].mask);
+    }
     free(info);
-    freePS(ps);
+    freeCellmap(map);
 
     if (Verbose > 1)
 	for (i = 0; i < ng; i++)
@@ -801,7 +972,7 @@ polyGraphs(int ng, Agraph_t ** gs, Agraph_t * root, pack_info * pinfo)
     ginfo *info;
     ginfo **sinfo;
     point *places;
-    Dict_t *ps;
+    cellmap_t *map;
     int i;
     boolean *fixed = pinfo->fixed;
     int fixed_cnt = 0;
@@ -869,30 +1040,32 @@ polyGraphs(int ng, Agraph_t ** gs, Agraph_t * root, pack_info * pinfo)
     }
     qsort(sinfo, ng, sizeof(ginfo *), cmpf);
 
-    ps = newPS();
+    map = newCellmap();
     places = N_NEW(ng, point);
     if (fixed) {
 	for (i = 0; i < ng; i++) {
 	    if (fixed[i])
-		placeFixed(sinfo[i], ps, places + (sinfo[i]->index),
+		placeFixed(sinfo[i], map, places + (sinfo[i]->index),
 			   center);
 	}
 	for (i = 0; i < ng; i++) {
 	    if (!fixed[i])
-		placeGraph(i, sinfo[i], ps, places + (sinfo[i]->index),
+		placeGraph(i, sinfo[i], map, places + (sinfo[i]->index),
 			   stepSize, pinfo->margin, bbs);
 	}
     } else {
 	for (i = 0; i < ng; i++)
-	    placeGraph(i, sinfo[i], ps, places + (sinfo[i]->index),
+	    placeGraph(i, sinfo[i], map, places + (sinfo[i]->index),
 		       stepSize, pinfo->margin, bbs);
     }
 
     free(sinfo);
-    for (i = 0; i < ng; i++)
+    for (i = 0; i < ng; i++) {
 	free(info[i].cells);
+	free(info[i].mask);
+    }
     free(info);
-    freePS(ps);
+    freeCellmap(map);
     free (bbs);
 
     if (Verbose > 1)
@@ -85,6 +85,7 @@ typedef unsigned int packval_t;
     PACK_API Agraph_t **ccomps(Agraph_t *, int *, char *);
     PACK_API Agraph_t **cccomps(Agraph_t *, int *, char *);
     PACK_API Agraph_t **pccomps(Agraph_t *, int *, char *, boolean *);
+    PACK_API int *ccompsIds(Agraph_t *, int *);
     PACK_API int nodeInduce(Agraph_t *);
     PACK_API Agraph_t *mapClust(Agraph_t *);
 #undef PACK_API
@@ -595,6 +595,8 @@ real StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim, r
   real *w, *dd, *d, *y = NULL, *x0 = NULL, *x00 = NULL, diag, diff = 1, *lambda = sm->lambda, alpha = 0., M = 0.;
   SparseMatrix Lc = NULL;
   real dij, dist;
+  Operator Ax = NULL, precond = NULL;
+  int ichol = 0;
 
 
   Lwdd = SparseMatrix_copy(Lwd);
@@ -627,6 +629,14 @@ real StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim, r
     M = ((real*) (sm->data))[1];
   }
 
+  /* Lw does not change while iterating, so factor it once */
+  if (sm->scheme != SM_SCHEME_UNIFORM_STRESS){
+    Ax = Operator_matmul_new(Lw);
+    precond = Operator_ichol_precon_new(Lw);
+    ichol = precond != NULL;
+    if (!ichol) precond = Operator_diag_precon_new(Lw);
+  }
+
   while (iter++ < maxit_sm && diff > tol){
 
     if (sm->scheme != SM_SCHEME_STRESS_APPROX){
@@ -703,7 +713,7 @@ real StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim, r
     if (sm->scheme == SM_SCHEME_UNIFORM_STRESS){
       uniform_stress_solve(Lw, alpha, dim, x, y, sm->tol_cg, sm->maxit_cg);
     } else {
-      SparseMatrix_solve(Lw, dim, x, y,  sm->tol_cg, sm->maxit_cg, SOLVE_METHOD_CG, &flag);
+      cg(Ax, precond, m, dim, x, y, sm->tol_cg, sm->maxit_cg);
       //SparseMatrix_solve(Lw, dim, x, y,  sm->tol_cg, 1, SOLVE_METHOD_JACOBI, &flag);
     }
 
@@ -731,6 +741,13 @@ real StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim, r
 #endif
 
  RETURN:
+  if (Ax) Operator_matmul_delete(Ax);
+  if (precond) {
+    if (ichol)
+      Operator_ichol_precon_delete(precond);
+    else
+      Operator_diag_precon_delete(precond);
+  }
   SparseMatrix_delete(Lwdd);
   if (Lc) {
     SparseMatrix_delete(Lc);
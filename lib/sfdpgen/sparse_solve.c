@@ -9,6 +9,7 @@
  *************************************************************************/
 
 #include <assert.h>
+#include <float.h>
 #include <string.h>
 #include <sfdpgen/sparse_solve.h>
 #include <sfdpgen/sfdpinternal.h>
@@ -64,7 +65,7 @@ static real *Operator_matmul_apply(Operator o, real *x, real *y){
   return y;
 }
 
-static Operator Operator_matmul_new(SparseMatrix A){
+Operator Operator_matmul_new(SparseMatrix A){
   Operator o;
 
   o = GNEW(struct Operator_struct);
@@ -74,7 +75,7 @@ static Operator Operator_matmul_new(SparseMatrix A){
 }
 
 
-static void Operator_matmul_delete(Operator o){
+void Operator_matmul_delete(Operator o){
   FREE(o);
 }
 
@@ -118,7 +119,7 @@ Operator Operator_uniform_stress_diag_precon_new(SparseMatrix A, real alpha){
 }
 
 
-static Operator Operator_diag_precon_new(SparseMatrix A){
+Operator Operator_diag_precon_new(SparseMatrix A){
   Operator o;
   real *diag;
   int i, j, m = A->m, *ia = A->ia, *ja = A->ja;
@@ -146,11 +147,133 @@ static Operator Operator_diag_precon_new(SparseMatrix A){
   return o;
 }
 
-static void Operator_diag_precon_delete(Operator o){
+void Operator_diag_precon_delete(Operator o){
   FREE(o->data);
   FREE(o);
 }
 
+/* incomplete Cholesky factor L, held as a CSR lower triangle with columns in
+ * ascending order, so the diagonal is the last entry of each row
+ */
+struct ichol_precon_data {
+  int n;
+  int *ia;
+  int *ja;
+  real *a;
+};
+
+static real *Operator_ichol_precon_apply(Operator o, real *x, real *y){
+  struct ichol_precon_data *d = (struct ichol_precon_data*) o->data;
+  int i, j, n = d->n, *ia = d->ia, *ja = d->ja;
+  real *a = d->a, s;
+
+  /* solve L w = x */
+  for (i = 0; i < n; i++){
+    s = x[i];
+    for (j = ia[i]; j < ia[i+1] - 1; j++) s -= a[j]*y[ja[j]];
+    y[i] = s/a[ia[i+1] - 1];
+  }
+
+  /* solve L^T y = w, column by column */
+  for (i = n - 1; i >= 0; i--){
+    y[i] /= a[ia[i+1] - 1];
+    for (j = ia[i]; j < ia[i+1] - 1; j++) y[ja[j]] -= a[j]*y[i];
+  }
+  return y;
+}
+
+/* Build a zero fill-in incomplete Cholesky preconditioner for the symmetric
+ * matrix A. Returns NULL if A has a non-positive or missing diagonal entry, in
+ * which case the caller should fall back to a diagonal preconditioner.
+ */
+Operator Operator_ichol_precon_new(SparseMatrix A){
+  Operator o;
+  struct ichol_precon_data *d;
+  int i, j, k, p, q, n = A->m, *ia = A->ia, *ja = A->ja, *li, *lj;
+  real *a = (real*) A->a, *la, *w, s, aii;
+
+  assert(A->type == MATRIX_TYPE_REAL);
+  assert(A->m == A->n);
+
+  /* The lower triangle of L has the pattern of the transposed upper triangle
+   * of A. Building it by scattering row i's entries (i, j), j >= i, into row j
+   * leaves the columns of every row of L in ascending order.
+   */
+  li = N_GNEW(n + 1, int);
+  for (i = 0; i <= n; i++) li[i] = 0;
+  for (i = 0; i < n; i++){
+    for (j = ia[i]; j < ia[i+1]; j++){
+      if (ja[j] >= i) li[ja[j]+1]++;
+    }
+  }
+  for (i = 0; i < n; i++) li[i+1] += li[i];
+  lj = N_GNEW(li[n], int);
+  la = N_GNEW(li[n], real);
+  for (i = 0; i < n; i++){
+    for (j = ia[i]; j < ia[i+1]; j++){
+      if (ja[j] >= i){
+	p = li[ja[j]]++;
+	lj[p] = i;
+	la[p] = a[j];
+      }
+    }
+  }
+  for (i = n; i > 0; i--) li[i] = li[i-1];
+  li[0] = 0;
+
+  /* row-oriented IC(0): w holds the row of L being computed, scattered by
+   * column, so that dropping fill-in comes for free from its zero entries
+   */
+  w = N_GNEW(n, real);
+  for (i = 0; i < n; i++) w[i] = 0.;
+  for (i = 0; i < n; i++){
+    if (li[i+1] == li[i] || lj[li[i+1] - 1] != i || la[li[i+1] - 1] <= 0){
+      FREE(w); FREE(li); FREE(lj); FREE(la);
+      return NULL;
+    }
+    aii = la[li[i+1] - 1];
+    for (p = li[i]; p < li[i+1] - 1; p++) w[lj[p]] = la[p];
+
+    s = aii;
+    for (p = li[i]; p < li[i+1] - 1; p++){
+      k = lj[p];
+      for (q = li[k]; q < li[k+1] - 1; q++) w[k] -= la[q]*w[lj[q]];
+      w[k] /= la[li[k+1] - 1];
+      s -= w[k]*w[k];
+    }
+    /* Laplacians are only semi-definite, so the last pivots can vanish or
+     * go negative through rounding. Keep the factor positive definite by
+     * falling back to the original diagonal entry.
+     */
+    if (s <= DBL_EPSILON*aii) s = aii;
+    la[li[i+1] - 1] = sqrt(s);
+
+    for (p = li[i]; p < li[i+1] - 1; p++){
+      la[p] = w[lj[p]];
+      w[lj[p]] = 0.;
+    }
+  }
+  FREE(w);
+
+  o = GNEW(struct Operator_struct);
+  o->data = d = GNEW(struct ichol_precon_data);
+  d->n = n;
+  d->ia = li;
+  d->ja = lj;
+  d->a = la;
+  o->Operator_apply = Operator_ichol_precon_apply;
+  return o;
+}
+
+void Operator_ichol_precon_delete(Operator o){
+  struct ichol_precon_data *d = (struct ichol_precon_data*) o->data;
+  FREE(d->ia);
+  FREE(d->ja);
+  FREE(d->a);
+  FREE(d);
+  FREE(o);
+}
+
 static real conjugate_gradient(Operator A, Operator precon, int n, real *x, real *rhs, real tol, int maxit){
   real *z, *r, *p, *q, res = 10*tol, alpha;
   real rho = 1.0e20, rho_old = 1, res0, beta;
@@ -299,6 +422,19 @@ real SparseMatrix_solve(SparseMatrix A, int dim, real *x0, real *rhs, real tol,
     Operator_matmul_delete(Ax);
     Operator_diag_precon_delete(precond);
     break;
+  case SOLVE_METHOD_CG_ICHOL:
+    Ax =  Operator_matmul_new(A);
+    precond = Operator_ichol_precon_new(A);
+    if (precond){
+      res = cg(Ax, precond, n, dim, x0, rhs, tol, maxit);
+      Operator_ichol_precon_delete(precond);
+    } else {
+      precond = Operator_diag_precon_new(A);
+      res = cg(Ax, precond, n, dim, x0, rhs, tol, maxit);
+      Operator_diag_precon_delete(precond);
+    }
+    Operator_matmul_delete(Ax);
+    break;
   case SOLVE_METHOD_JACOBI:{
     jacobi(A, dim, x0, rhs, maxit, flag);
     break;
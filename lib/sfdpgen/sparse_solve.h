@@ -12,7 +12,11 @@
 
 #include <sparse/SparseMatrix.h>
 
-enum {SOLVE_METHOD_CG, SOLVE_METHOD_JACOBI};
+/* SOLVE_METHOD_CG_ICHOL is CG with an incomplete Cholesky preconditioner.
+ * It requires a symmetric matrix and falls back to SOLVE_METHOD_CG if the
+ * factorization is not possible.
+ */
+enum {SOLVE_METHOD_CG, SOLVE_METHOD_JACOBI, SOLVE_METHOD_CG_ICHOL};
 
 typedef struct Operator_struct *Operator;
 
@@ -28,3 +32,14 @@ real SparseMatrix_solve(SparseMatrix A, int dim, real *x0, real *rhs, real tol,
 Operator Operator_uniform_stress_matmul(SparseMatrix A, real alpha);
 
 Operator Operator_uniform_stress_diag_precon_new(SparseMatrix A, real alpha);
+
+/* The operators SparseMatrix_solve builds for its CG methods, for callers
+ * that solve with the same matrix many times. Operator_ichol_precon_new
+ * returns NULL if A cannot be factored.
+ */
+Operator Operator_matmul_new(SparseMatrix A);
+void Operator_matmul_delete(Operator o);
+Operator Operator_diag_precon_new(SparseMatrix A);
+void Operator_diag_precon_delete(Operator o);
+Operator Operator_ichol_precon_new(SparseMatrix A);
+void Operator_ichol_precon_delete(Operator o);
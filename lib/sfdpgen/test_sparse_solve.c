@@ -0,0 +1,235 @@
+// basic unit tester for the conjugate gradient solvers
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// include the solver and what it needs so we can be compiled standalone
+#include <sfdpgen/sparse_solve.c>
+#include <sparse/SparseMatrix.c>
+#include <sparse/general.c>
+#include <sparse/BinaryHeap.c>
+#include <sparse/IntStack.c>
+#include <common/memory.c>
+
+// sparse/general.h switches assertions off, so turn them back on
+#undef NDEBUG
+#include <assert.h>
+
+unsigned char Verbose;
+
+// grid size, the matrices have K * K rows
+#define K 30
+#define N (K * K)
+
+static unsigned long long state = 88172645463325252ULL;
+
+static double rnd(void) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (double)(state % 1000000) / 1000000.0;
+}
+
+/* a weighted Laplacian of a grid, like the Lw of a stress majorization
+ * smoother, plus shift on the diagonal
+ */
+static SparseMatrix grid_laplacian(double shift) {
+  int irn[9 * N], jcn[9 * N], nz = 0;
+  double val[9 * N];
+
+  for (int i = 0; i < N; ++i) {
+    irn[nz] = jcn[nz] = i;
+    val[nz++] = shift;
+  }
+  for (int r = 0; r < K; ++r) {
+    for (int c = 0; c < K; ++c) {
+      int i = r * K + c;
+      int nbr[2] = {c + 1 < K ? i + 1 : -1, r + 1 < K ? i + K : -1};
+      for (int k = 0; k < 2; ++k) {
+        if (nbr[k] < 0)
+          continue;
+        double w = 0.5 + rnd();
+        irn[nz] = i;
+        jcn[nz] = nbr[k];
+        val[nz++] = -w;
+        irn[nz] = nbr[k];
+        jcn[nz] = i;
+        val[nz++] = -w;
+        irn[nz] = jcn[nz] = i;
+        val[nz++] = w;
+        irn[nz] = jcn[nz] = nbr[k];
+        val[nz++] = w;
+      }
+    }
+  }
+  return SparseMatrix_from_coordinate_arrays(nz, N, N, irn, jcn, val,
+                                             MATRIX_TYPE_REAL, sizeof(double));
+}
+
+// a matrix product that counts how often it is applied
+static int products;
+
+static real *counting_apply(Operator o, real *x, real *y) {
+  ++products;
+  return Operator_matmul_apply(o, x, y);
+}
+
+/* solve A x = b for dim right hand sides with the given preconditioner,
+ * returning the number of matrix products used
+ */
+static int solve(SparseMatrix A, Operator precond, int dim, const double *b,
+                 double *x) {
+  Operator Ax = Operator_matmul_new(A);
+  Ax->Operator_apply = counting_apply;
+  double *x0 = calloc(N * dim, sizeof(double));
+  assert(x0 != NULL);
+  for (int i = 0; i < N * dim; ++i)
+    x[i] = b[i];
+  products = 0;
+  cg(Ax, precond, N, dim, x0, x, 1e-10, 5 * N);
+  free(x0);
+  Operator_matmul_delete(Ax);
+  return products;
+}
+
+// largest entry of |A x - b|
+static double residual(SparseMatrix A, int dim, const double *x,
+                       const double *b) {
+  double r = 0, *ax = NULL, *xk = malloc(N * sizeof(double));
+  assert(xk != NULL);
+  for (int k = 0; k < dim; ++k) {
+    for (int i = 0; i < N; ++i)
+      xk[i] = x[i * dim + k];
+    SparseMatrix_multiply_vector(A, xk, &ax, FALSE);
+    for (int i = 0; i < N; ++i)
+      r = fmax(r, fabs(ax[i] - b[i * dim + k]));
+  }
+  free(xk);
+  free(ax);
+  return r;
+}
+
+// right hand sides A x for a random x
+static double *rhs(SparseMatrix A, int dim) {
+  double *x = malloc(N * dim * sizeof(double));
+  double *b = malloc(N * dim * sizeof(double));
+  double *xk = malloc(N * sizeof(double)), *bk = NULL;
+  assert(x != NULL && b != NULL && xk != NULL);
+  for (int i = 0; i < N * dim; ++i)
+    x[i] = rnd();
+  for (int k = 0; k < dim; ++k) {
+    for (int i = 0; i < N; ++i)
+      xk[i] = x[i * dim + k];
+    SparseMatrix_multiply_vector(A, xk, &bk, FALSE);
+    for (int i = 0; i < N; ++i)
+      b[i * dim + k] = bk[i];
+  }
+  free(x);
+  free(xk);
+  free(bk);
+  return b;
+}
+
+// IC(0) preconditioned CG should agree with diagonally preconditioned CG,
+// in fewer iterations
+static void test_ichol_vs_cg(double shift) {
+  const int dim = 2;
+  SparseMatrix A = grid_laplacian(shift);
+  double *b = rhs(A, dim);
+  double *x_cg = malloc(N * dim * sizeof(double));
+  double *x_ic = malloc(N * dim * sizeof(double));
+  assert(x_cg != NULL && x_ic != NULL);
+
+  Operator diag = Operator_diag_precon_new(A);
+  int n_cg = solve(A, diag, dim, b, x_cg);
+  Operator_diag_precon_delete(diag);
+
+  Operator ichol = Operator_ichol_precon_new(A);
+  assert(ichol != NULL);
+  int n_ic = solve(A, ichol, dim, b, x_ic);
+
+  // the same preconditioner can be used again
+  double *x_again = malloc(N * dim * sizeof(double));
+  assert(x_again != NULL);
+  assert(solve(A, ichol, dim, b, x_again) == n_ic);
+  for (int i = 0; i < N * dim; ++i)
+    assert(x_again[i] == x_ic[i]);
+  free(x_again);
+  Operator_ichol_precon_delete(ichol);
+
+  printf("(%d vs %d products) ", n_ic, n_cg);
+  assert(residual(A, dim, x_cg, b) < 1e-6);
+  assert(residual(A, dim, x_ic, b) < 1e-6);
+  assert(n_ic < n_cg);
+
+  // singular Laplacians determine the solution only up to a constant
+  if (shift > 0) {
+    for (int i = 0; i < N * dim; ++i)
+      assert(fabs(x_cg[i] - x_ic[i]) < 1e-5);
+  }
+
+  // SparseMatrix_solve gives the same
+  double *x0 = calloc(N * dim, sizeof(double));
+  double *x = malloc(N * dim * sizeof(double));
+  assert(x0 != NULL && x != NULL);
+  int flag = -1;
+  for (int i = 0; i < N * dim; ++i)
+    x[i] = b[i];
+  SparseMatrix_solve(A, dim, x0, x, 1e-10, 5 * N, SOLVE_METHOD_CG_ICHOL,
+                     &flag);
+  assert(flag == 0);
+  for (int i = 0; i < N * dim; ++i)
+    assert(x[i] == x_ic[i]);
+
+  free(x0);
+  free(x);
+  free(x_cg);
+  free(x_ic);
+  free(b);
+  SparseMatrix_delete(A);
+}
+
+static void test_ichol_definite(void) { test_ichol_vs_cg(0.01); }
+
+static void test_ichol_laplacian(void) { test_ichol_vs_cg(0); }
+
+// matrices that cannot be factored fall back to the diagonal preconditioner
+static void test_ichol_fallback(void) {
+  int irn[] = {0, 0, 1, 1}, jcn[] = {0, 1, 0, 1};
+  double val[] = {0, 1, 1, 2};
+  SparseMatrix A = SparseMatrix_from_coordinate_arrays(
+      4, 2, 2, irn, jcn, val, MATRIX_TYPE_REAL, sizeof(double));
+  assert(Operator_ichol_precon_new(A) == NULL);
+
+  double x0[] = {0, 0}, x[] = {1, 3};
+  int flag = -1;
+  SparseMatrix_solve(A, 1, x0, x, 1e-12, 10, SOLVE_METHOD_CG_ICHOL, &flag);
+  assert(flag == 0);
+  assert(fabs(x[0] - 1) < 1e-9 && fabs(x[1] - 1) < 1e-9);
+  SparseMatrix_delete(A);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(ichol_definite);
+  RUN(ichol_laplacian);
+  RUN(ichol_fallback);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
@@ -76,53 +76,61 @@ SparseMatrix SparseMatrix_transpose(SparseMatrix A){
   jb = B->ja;
 
   for (i = 0; i <= n; i++) ib[i] = 0;
-  for (i = 0; i < m; i++){
-    for (j = ia[i]; j < ia[i+1]; j++){
-      ib[ja[j]+1]++;
-    }
-  }
+  /* the rows of a CSR matrix are contiguous, so column counts can be
+   * accumulated with one flat pass over ja */
+  for (j = 0; j < ia[m]; j++) ib[ja[j]+1]++;
 
   for (i = 0; i < n; i++) ib[i+1] += ib[i];
 
+  /* ib[c] is used as the insertion cursor for column c. Each entry is looked
+   * up once and written through a single index, rather than re-indexing
+   * ib[ja[j]] for every array touched.
+   */
   switch (A->type){
   case MATRIX_TYPE_REAL:{
-    real *a = (real*) A->a;
-    real *b = (real*) B->a;
+    const real *a = A->a;
+    real *b = B->a;
     for (i = 0; i < m; i++){
-      for (j = ia[i]; j < ia[i+1]; j++){
-	jb[ib[ja[j]]] = i;
-	b[ib[ja[j]]++] = a[j];
+      const int row_end = ia[i+1];
+      for (j = ia[i]; j < row_end; j++){
+	const int p = ib[ja[j]]++;
+	jb[p] = i;
+	b[p] = a[j];
       }
     }
     break;
   }
   case MATRIX_TYPE_COMPLEX:{
-    real *a = (real*) A->a;
-    real *b = (real*) B->a;
+    const real *a = A->a;
+    real *b = B->a;
     for (i = 0; i < m; i++){
-      for (j = ia[i]; j < ia[i+1]; j++){
-	jb[ib[ja[j]]] = i;
-	b[2*ib[ja[j]]] = a[2*j];
-	b[2*ib[ja[j]]+1] = a[2*j+1];
-	ib[ja[j]]++;
+      const int row_end = ia[i+1];
+      for (j = ia[i]; j < row_end; j++){
+	const int p = ib[ja[j]]++;
+	jb[p] = i;
+	b[2*p] = a[2*j];
+	b[2*p+1] = a[2*j+1];
       }
     }
     break;
   }
   case MATRIX_TYPE_INTEGER:{
-    int *ai = (int*) A->a;
-    int *bi = (int*) B->a;
+    const int *ai = A->a;
+    int *bi = B->a;
     for (i = 0; i < m; i++){
-      for (j = ia[i]; j < ia[i+1]; j++){
-	jb[ib[ja[j]]] = i;
-	bi[ib[ja[j]]++] = ai[j];
+      const int row_end = ia[i+1];
+      for (j = ia[i]; j < row_end; j++){
+	const int p = ib[ja[j]]++;
+	jb[p] = i;
+	bi[p] = ai[j];
       }
     }
     break;
   }
   case MATRIX_TYPE_PATTERN:
     for (i = 0; i < m; i++){
-      for (j = ia[i]; j < ia[i+1]; j++){
+      const int row_end = ia[i+1];
+      for (j = ia[i]; j < row_end; j++){
 	jb[ib[ja[j]]++] = i;
       }
     }
@@ -757,97 +765,68 @@ static SparseMatrix SparseMatrix_from_coordinate_arrays_internal(int nz, int m,
     ia[i] = 0;
   }
 
+  /* validate the coordinates and count the entries of each row in a single
+   * pass, shared by all matrix types */
+  for (i = 0; i < nz; i++){
+    if (irn[i] < 0 || irn[i] >= m || jcn[i] < 0 || jcn[i] >= n) {
+      assert(0);
+      SparseMatrix_delete(A);
+      return NULL;
+    }
+    ia[irn[i]+1]++;
+  }
+  for (i = 0; i < m; i++) ia[i+1] += ia[i];
+
+  /* scatter the entries, using ia[r] as the insertion cursor for row r */
   switch (type){
   case MATRIX_TYPE_REAL:
     val = (real*) val0;
     a = (real*) A->a;
     for (i = 0; i < nz; i++){
-      if (irn[i] < 0 || irn[i] >= m || jcn[i] < 0 || jcn[i] >= n) {
-	assert(0);
-	return NULL;
-      }
-      ia[irn[i]+1]++;
-    }
-    for (i = 0; i < m; i++) ia[i+1] += ia[i];
-    for (i = 0; i < nz; i++){
-      a[ia[irn[i]]] = val[i];
-      ja[ia[irn[i]]++] = jcn[i];
+      const int p = ia[irn[i]]++;
+      a[p] = val[i];
+      ja[p] = jcn[i];
     }
-    for (i = m; i > 0; i--) ia[i] = ia[i - 1];
-    ia[0] = 0;
     break;
   case MATRIX_TYPE_COMPLEX:
     val = (real*) val0;
     a = (real*) A->a;
     for (i = 0; i < nz; i++){
-      if (irn[i] < 0 || irn[i] >= m || jcn[i] < 0 || jcn[i] >= n) {
-	assert(0);
-	return NULL;
-      }
-      ia[irn[i]+1]++;
+      const int p = ia[irn[i]]++;
+      a[2*p] = val[2*i];
+      a[2*p+1] = val[2*i+1];
+      ja[p] = jcn[i];
     }
-    for (i = 0; i < m; i++) ia[i+1] += ia[i];
-    for (i = 0; i < nz; i++){
-      a[2*ia[irn[i]]] = *(val++);
-      a[2*ia[irn[i]]+1] = *(val++);
-      ja[ia[irn[i]]++] = jcn[i];
-    }
-    for (i = m; i > 0; i--) ia[i] = ia[i - 1];
-    ia[0] = 0;
     break;
   case MATRIX_TYPE_INTEGER:
     vali = (int*) val0;
     ai = (int*) A->a;
     for (i = 0; i < nz; i++){
-      if (irn[i] < 0 || irn[i] >= m || jcn[i] < 0 || jcn[i] >= n) {
-	assert(0);
-	return NULL;
-      }
-      ia[irn[i]+1]++;
-    }
-    for (i = 0; i < m; i++) ia[i+1] += ia[i];
-    for (i = 0; i < nz; i++){
-      ai[ia[irn[i]]] = vali[i];
-      ja[ia[irn[i]]++] = jcn[i];
+      const int p = ia[irn[i]]++;
+      ai[p] = vali[i];
+      ja[p] = jcn[i];
     }
-    for (i = m; i > 0; i--) ia[i] = ia[i - 1];
-    ia[0] = 0;
     break;
   case MATRIX_TYPE_PATTERN:
-    for (i = 0; i < nz; i++){
-      if (irn[i] < 0 || irn[i] >= m || jcn[i] < 0 || jcn[i] >= n) {
-	assert(0);
-	return NULL;
-      }
-      ia[irn[i]+1]++;
-    }
-    for (i = 0; i < m; i++) ia[i+1] += ia[i];
     for (i = 0; i < nz; i++){
       ja[ia[irn[i]]++] = jcn[i];
     }
-    for (i = m; i > 0; i--) ia[i] = ia[i - 1];
-    ia[0] = 0;
     break;
   case MATRIX_TYPE_UNKNOWN:
-    for (i = 0; i < nz; i++){
-      if (irn[i] < 0 || irn[i] >= m || jcn[i] < 0 || jcn[i] >= n) {
-	assert(0);
-	return NULL;
-      }
-      ia[irn[i]+1]++;
-    }
-    for (i = 0; i < m; i++) ia[i+1] += ia[i];
     memcpy(A->a, val0, A->size*((size_t)nz));
     for (i = 0; i < nz; i++){
       ja[ia[irn[i]]++] = jcn[i];
     }
-    for (i = m; i > 0; i--) ia[i] = ia[i - 1];
-    ia[0] = 0;
     break;
   default:
     assert(0);
+    SparseMatrix_delete(A);
     return NULL;
   }
+
+  /* the cursors now point one past the end of each row; shift them back */
+  for (i = m; i > 0; i--) ia[i] = ia[i - 1];
+  ia[0] = 0;
   A->nz = nz;
 
 
@@ -999,6 +978,14 @@ SparseMatrix SparseMatrix_add(SparseMatrix A, SparseMatrix B){
   return C;
 }
 
+/* Products that write each row of the result from that row of A alone are
+ * split over threads when built with OpenMP. Every row is still summed in
+ * the same order, so the result does not depend on the number of threads.
+ * Below PARALLEL_NZ nonzeros a product is too quick to be worth starting
+ * the threads for.
+ */
+#define PARALLEL_NZ 50000
+
 static void SparseMatrix_multiply_dense1(SparseMatrix A, real *v, real **res, int dim){
   /* A v where v a dense matrix of second dimension dim. Real only for now. */
   int i, j, k, *ia, *ja, m;
@@ -1014,10 +1001,17 @@ static void SparseMatrix_multiply_dense1(SparseMatrix A, real *v, real **res, in
   u = *res;
 
   if (!u) u = MALLOC(sizeof(real)*((size_t) m)*((size_t) dim));
+#ifdef _OPENMP
+#pragma omp parallel for private(j, k) schedule(static) if (ia[m] >= PARALLEL_NZ)
+#endif
   for (i = 0; i < m; i++){
-    for (k = 0; k < dim; k++) u[i*dim+k] = 0.;
-    for (j = ia[i]; j < ia[i+1]; j++){
-      for (k = 0; k < dim; k++) u[i*dim+k] += a[j]*v[ja[j]*dim+k];
+    real *ui = &u[i*dim];
+    const int row_end = ia[i+1];
+    for (k = 0; k < dim; k++) ui[k] = 0.;
+    for (j = ia[i]; j < row_end; j++){
+      const real aj = a[j];
+      const real *vj = &v[ja[j]*dim];
+      for (k = 0; k < dim; k++) ui[k] += aj*vj[k];
     }
   }
 
@@ -1045,24 +1039,35 @@ void SparseMatrix_multiply_vector(SparseMatrix A, real *v, real **res, int trans
   n = A->n;
   u = *res;
 
+  /* Row sums are accumulated in a local rather than in u[i], so the compiler
+   * can keep them in a register instead of reloading through a pointer that
+   * may alias a or v.
+   */
   switch (A->type){
   case MATRIX_TYPE_REAL:
     a = (real*) A->a;
     if (v){
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(real)*((size_t)m));
+#ifdef _OPENMP
+#pragma omp parallel for private(j) schedule(static) if (ia[m] >= PARALLEL_NZ)
+#endif
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += a[j]*v[ja[j]];
+	  real sum = 0.;
+	  const int row_end = ia[i+1];
+	  for (j = ia[i]; j < row_end; j++){
+	    sum += a[j]*v[ja[j]];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(real)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
 	for (i = 0; i < m; i++){
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[ja[j]] += a[j]*v[i];
+	  const real vi = v[i];
+	  const int row_end = ia[i+1];
+	  for (j = ia[i]; j < row_end; j++){
+	    u[ja[j]] += a[j]*vi;
 	  }
 	}
       }
@@ -1071,18 +1076,18 @@ void SparseMatrix_multiply_vector(SparseMatrix A, real *v, real **res, int trans
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(real)*((size_t)m));
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += a[j];
+	  real sum = 0.;
+	  const int row_end = ia[i+1];
+	  for (j = ia[i]; j < row_end; j++){
+	    sum += a[j];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(real)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
-	for (i = 0; i < m; i++){
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[ja[j]] += a[j];
-	  }
+	for (j = 0; j < ia[m]; j++){
+	  u[ja[j]] += a[j];
 	}
       }
     }
@@ -1092,18 +1097,25 @@ void SparseMatrix_multiply_vector(SparseMatrix A, real *v, real **res, int trans
     if (v){
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(real)*((size_t)m));
+#ifdef _OPENMP
+#pragma omp parallel for private(j) schedule(static) if (ia[m] >= PARALLEL_NZ)
+#endif
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += ai[j]*v[ja[j]];
+	  real sum = 0.;
+	  const int row_end = ia[i+1];
+	  for (j = ia[i]; j < row_end; j++){
+	    sum += ai[j]*v[ja[j]];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(real)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
 	for (i = 0; i < m; i++){
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[ja[j]] += ai[j]*v[i];
+	  const real vi = v[i];
+	  const int row_end = ia[i+1];
+	  for (j = ia[i]; j < row_end; j++){
+	    u[ja[j]] += ai[j]*vi;
 	  }
 	}
       }
@@ -1112,18 +1124,18 @@ void SparseMatrix_multiply_vector(SparseMatrix A, real *v, real **res, int trans
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(real)*((size_t)m));
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += ai[j];
+	  real sum = 0.;
+	  const int row_end = ia[i+1];
+	  for (j = ia[i]; j < row_end; j++){
+	    sum += ai[j];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(real)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
-	for (i = 0; i < m; i++){
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[ja[j]] += ai[j];
-	  }
+	for (j = 0; j < ia[m]; j++){
+	  u[ja[j]] += ai[j];
 	}
       }
     }
@@ -1194,17 +1206,20 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
       real *c = (real*) C->a;
       ic[0] = 0;
       for (i = 0; i < m; i++){
+	const int row_start = nz;
 	for (j = ia[i]; j < ia[i+1]; j++){
+	  const real aj = a[j];
 	  jj = ja[j];
 	  for (k = ib[jj]; k < ib[jj+1]; k++){
-	    if (mask[jb[k]] < ic[i]){
-	      mask[jb[k]] = nz;
-	      jc[nz] = jb[k];
-	      c[nz] = a[j]*b[k];
+	    const int col = jb[k];
+	    if (mask[col] < row_start){
+	      mask[col] = nz;
+	      jc[nz] = col;
+	      c[nz] = aj*b[k];
 	      nz++;
 	    } else {
-	      assert(jc[mask[jb[k]]] == jb[k]);
-	      c[mask[jb[k]]] += a[j]*b[k];
+	      assert(jc[mask[col]] == col);
+	      c[mask[col]] += aj*b[k];
 	    }
 	  }
 	}
@@ -1249,17 +1264,20 @@ SparseMatrix SparseMatrix_multiply(SparseMatrix A, SparseMatrix B){
       int *c = (int*) C->a;
       ic[0] = 0;
       for (i = 0; i < m; i++){
+	const int row_start = nz;
 	for (j = ia[i]; j < ia[i+1]; j++){
+	  const int aj = a[j];
 	  jj = ja[j];
 	  for (k = ib[jj]; k < ib[jj+1]; k++){
-	    if (mask[jb[k]] < ic[i]){
-	      mask[jb[k]] = nz;
-	      jc[nz] = jb[k];
-	      c[nz] = a[j]*b[k];
+	    const int col = jb[k];
+	    if (mask[col] < row_start){
+	      mask[col] = nz;
+	      jc[nz] = col;
+	      c[nz] = aj*b[k];
 	      nz++;
 	    } else {
-	      assert(jc[mask[jb[k]]] == jb[k]);
-	      c[mask[jb[k]]] += a[j]*b[k];
+	      assert(jc[mask[col]] == col);
+	      c[mask[col]] += aj*b[k];
 	    }
 	  }
 	}
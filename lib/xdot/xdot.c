@@ -9,6 +9,7 @@
  *************************************************************************/
 
 #include <xdot/xdot.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -94,13 +95,94 @@ static void agxbfree(agxbuf * xb)
 	free(xb->buf);
 }
 
+/* Storage for the points and strings of the ops of a compact xdot, which
+ * are kept in the same block as the ops array. While parsing, references
+ * into the arena are stored in the pointer fields of the ops as offsets,
+ * since the arena moves as it grows. finishCompact turns them into pointers.
+ */
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} arena_t;
+
+#define OFF2PTR(o) ((void*)(uintptr_t)(o))
+#define ARENA_ALIGN 8
+
+/* arenaAlloc:
+ * Reserve n bytes in the arena, aligned for doubles.
+ * Return the offset of the reserved space.
+ */
+static size_t arenaAlloc(arena_t *a, size_t n)
+{
+    size_t off = (a->len + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (off + n > a->cap) {
+	size_t cap = a->cap ? 2 * a->cap : BUFSIZ;
+	while (cap < off + n)
+	    cap *= 2;
+	a->buf = realloc(a->buf, cap);
+	a->cap = cap;
+    }
+    a->len = off + n;
+    return off;
+}
+
+/* arenaStr:
+ * Copy the first n bytes of s into the arena as a NUL-terminated string.
+ * Return its offset.
+ */
+static size_t arenaStr(arena_t *a, const char *s, size_t n)
+{
+    size_t off = arenaAlloc(a, n + 1);
+
+    memcpy(a->buf + off, s, n);
+    a->buf[off + n] = '\0';
+    return off;
+}
+
+/* xdot_strtod:
+ * strtod for the numbers in xdot. Plain decimals with up to 15 significant
+ * digits, which is what Graphviz writes, are converted directly: the digits
+ * and the power of ten are then exact doubles, so a single division gives
+ * the correctly rounded result, the same as strtod. Anything else, such as
+ * exponents, hex, inf or nan, is passed to strtod.
+ */
+static double xdot_strtod(const char *s, char **endp)
+{
+    static const double pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char *p = s;
+    unsigned long long m = 0;
+    int ndigits = 0, nfrac = 0, neg = 0;
+    double d;
+
+    while (isspace((unsigned char)*p))
+	p++;
+    if (*p == '-' || *p == '+')
+	neg = *p++ == '-';
+    for (; isdigit((unsigned char)*p); p++, ndigits++)
+	m = m * 10 + (*p - '0');
+    if (*p == '.') {
+	for (p++; isdigit((unsigned char)*p); p++, ndigits++, nfrac++)
+	    m = m * 10 + (*p - '0');
+    }
+    if (ndigits == 0 || ndigits > 15 || nfrac > 22 || isalpha((unsigned char)*p))
+	return strtod(s, endp);
+    d = (double)m / pow10[nfrac];
+    *endp = (char*)p;
+    return neg ? -d : d;
+}
+
 /* the parse functions should return NULL on error */
 static char *parseReal(char *s, double *fp)
 {
     char *p;
     double d;
 
-    d = strtod(s, &p);
+    d = xdot_strtod(s, &p);
     if (p == s) return 0;
 	
     *fp = d;
@@ -134,25 +216,25 @@ static char *parseRect(char *s, xdot_rect * rp)
 {
     char* endp;
 
-    rp->x = strtod (s, &endp);
+    rp->x = xdot_strtod (s, &endp);
     if (s == endp)
 	return 0;
     else
 	s = endp;
 
-    rp->y = strtod (s, &endp);
+    rp->y = xdot_strtod (s, &endp);
     if (s == endp)
 	return 0;
     else
 	s = endp;
 
-    rp->w = strtod (s, &endp);
+    rp->w = xdot_strtod (s, &endp);
     if (s == endp)
 	return 0;
     else
 	s = endp;
 
-    rp->h = strtod (s, &endp);
+    rp->h = xdot_strtod (s, &endp);
     if (s == endp)
 	return 0;
     else
@@ -161,28 +243,40 @@ static char *parseRect(char *s, xdot_rect * rp)
     return s;
 }
 
-static char *parsePolyline(char *s, xdot_polyline * pp)
+/* parsePolyline:
+ * Parse a point count followed by the points. If a is non-NULL, the points
+ * are stored in the arena, otherwise they are malloc'ed.
+ */
+static char *parsePolyline(char *s, xdot_polyline * pp, arena_t *a)
 {
     int i;
+    size_t off = 0;
     xdot_point *pts;
     xdot_point *ps;
     char* endp;
 
     s = parseInt(s, &i);
     if (!s) return s;
-    pts = ps = N_NEW(i, xdot_point);
+    if (a) {
+	if (i < 0) return 0;
+	off = arenaAlloc(a, i * sizeof(xdot_point));
+	pts = (xdot_point*)(a->buf + off);
+    }
+    else
+	pts = N_NEW(i, xdot_point);
+    ps = pts;
     pp->cnt = i;
     for (i = 0; i < pp->cnt; i++) {
-	ps->x = strtod (s, &endp);
+	ps->x = xdot_strtod (s, &endp);
 	if (s == endp) {
-	    free (pts);
+	    if (!a) free (pts);
 	    return 0;
 	}
 	else
 	    s = endp;
-	ps->y = strtod (s, &endp);
+	ps->y = xdot_strtod (s, &endp);
 	if (s == endp) {
-	    free (pts);
+	    if (!a) free (pts);
 	    return 0;
 	}
 	else
@@ -190,15 +284,18 @@ static char *parsePolyline(char *s, xdot_polyline * pp)
 	ps->z = 0;
 	ps++;
     }
-    pp->pts = pts;
+    pp->pts = a ? OFF2PTR(off) : pts;
     return s;
 }
 
-static char *parseString(char *s, char **sp)
+/* parseString:
+ * Parse a length-prefixed string. If a is non-NULL, the string is stored
+ * in the arena, otherwise it is malloc'ed.
+ */
+static char *parseString(char *s, char **sp, arena_t *a)
 {
     int i;
     char *c;
-    char *p;
     s = parseInt(s, &i);
     if (!s || i <= 0) return 0;
     while (*s && *s != '-') s++;
@@ -206,20 +303,18 @@ static char *parseString(char *s, char **sp)
     else {
 	return 0;
     }
-    c = N_NEW(i + 1, char);
-    p = c;
-    while (i > 0 && *s) {
-	*p++ = *s++;
-	i--;
-    }
-    if (i > 0) {
-	free (c);
+    /* the input must hold all i bytes of the string */
+    if (strnlen(s, i) < (size_t)i)
 	return 0;
+    if (a) {
+	*sp = OFF2PTR(arenaStr(a, s, i));
+	return s + i;
     }
-
-    *p = '\0';
+    c = N_NEW(i + 1, char);
+    memcpy(c, s, i);
+    c[i] = '\0';
     *sp = c;
-    return s;
+    return s + i;
 }
 
 static char *parseAlign(char *s, xdot_align * ap)
@@ -236,11 +331,70 @@ static char *parseAlign(char *s, xdot_align * ap)
     return s;
 }
 
+/* arenaGradient:
+ * Move the stops of gradient clr, and their colors, into the arena.
+ */
+static void arenaGradient(arena_t *a, xdot_color *clr)
+{
+    int i, n;
+    size_t off, coff;
+    xdot_color_stop *stops, *st;
+
+    if (clr->type == xd_linear) {
+	n = clr->u.ling.n_stops;
+	stops = clr->u.ling.stops;
+    }
+    else {
+	n = clr->u.ring.n_stops;
+	stops = clr->u.ring.stops;
+    }
+    off = arenaAlloc(a, n * sizeof(xdot_color_stop));
+    for (i = 0; i < n; i++) {
+	coff = arenaStr(a, stops[i].color, strlen(stops[i].color));
+	st = (xdot_color_stop*)(a->buf + off) + i;
+	st->frac = stops[i].frac;
+	st->color = OFF2PTR(coff);
+    }
+    freeXDotColor(clr);
+    if (clr->type == xd_linear)
+	clr->u.ling.stops = OFF2PTR(off);
+    else
+	clr->u.ring.stops = OFF2PTR(off);
+}
+
+/* parseColor:
+ * Parse the length-prefixed color string of a 'c' or 'C' op into clr.
+ */
+static char *parseColor(char *s, xdot_color *clr, arena_t *a)
+{
+    char *cs;
+
+    s = parseString(s, &cs, a);
+    if (!s) return 0;
+    if (!a) {
+	if (!parseXDotColor (cs, clr)) {
+	    free (cs);
+	    return 0;
+	}
+	/* a gradient has its own copies of the colors */
+	if (clr->type != xd_none)
+	    free (cs);
+	return s;
+    }
+    if (!parseXDotColor (a->buf + (uintptr_t)cs, clr))
+	return 0;
+    if (clr->type == xd_none)
+	clr->u.clr = cs;
+    else
+	arenaGradient(a, clr);
+    return s;
+}
+
 #define CHK(s) if(!s){*error=1;return 0;}
 
-static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
+static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error,
+                     arena_t *a)
 {
-    char* cs;
     xdot_color clr;
 
     *error = 0;
@@ -265,7 +419,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'P':
 	op->kind = xd_filled_polygon;
-	s = parsePolyline(s, &op->u.polygon);
+	s = parsePolyline(s, &op->u.polygon, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_polygon];
@@ -273,7 +427,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'p':
 	op->kind = xd_unfilled_polygon;
-	s = parsePolyline(s, &op->u.polygon);
+	s = parsePolyline(s, &op->u.polygon, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_polygon];
@@ -281,7 +435,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'b':
 	op->kind = xd_filled_bezier;
-	s = parsePolyline(s, &op->u.bezier);
+	s = parsePolyline(s, &op->u.bezier, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_bezier];
@@ -289,17 +443,15 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'B':
 	op->kind = xd_unfilled_bezier;
-	s = parsePolyline(s, &op->u.bezier);
+	s = parsePolyline(s, &op->u.bezier, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_bezier];
 	break;
 
     case 'c':
-	s = parseString(s, &cs);
+	s = parseColor(s, &clr, a);
 	CHK(s);
-	cs = parseXDotColor (cs, &clr);
-	CHK(cs);
 	if (clr.type == xd_none) {
 	    op->kind = xd_pen_color;
 	    op->u.color = clr.u.clr;
@@ -315,10 +467,8 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	break;
 
     case 'C':
-	s = parseString(s, &cs);
+	s = parseColor(s, &clr, a);
 	CHK(s);
-	cs = parseXDotColor (cs, &clr);
-	CHK(cs);
 	if (clr.type == xd_none) {
 	    op->kind = xd_fill_color;
 	    op->u.color = clr.u.clr;
@@ -335,7 +485,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'L':
 	op->kind = xd_polyline;
-	s = parsePolyline(s, &op->u.polyline);
+	s = parsePolyline(s, &op->u.polyline, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_polyline];
@@ -351,7 +501,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	CHK(s);
 	s = parseReal(s, &op->u.text.width);
 	CHK(s);
-	s = parseString(s, &op->u.text.text);
+	s = parseString(s, &op->u.text.text, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_text];
@@ -361,7 +511,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	op->kind = xd_font;
 	s = parseReal(s, &op->u.font.size);
 	CHK(s);
-	s = parseString(s, &op->u.font.name);
+	s = parseString(s, &op->u.font.name, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_font];
@@ -369,7 +519,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'S':
 	op->kind = xd_style;
-	s = parseString(s, &op->u.style);
+	s = parseString(s, &op->u.style, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_style];
@@ -379,7 +529,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	op->kind = xd_image;
 	s = parseRect(s, &op->u.image.pos);
 	CHK(s);
-	s = parseString(s, &op->u.image.name);
+	s = parseString(s, &op->u.image.name, a);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_image];
@@ -423,6 +573,12 @@ xdot *parseXDotFOn (char *s, drawfunc_t fns[], int sz, xdot* x)
     if (!s)
 	return x;
 
+    /* the ops of a compact xdot cannot be moved */
+    if (x && (x->flags & XDOT_COMPACT)) {
+	x->flags |= XDOT_PARSE_ERROR;
+	return x;
+    }
+
     if (!x) {
 	x = NEW(xdot);
 	if (sz <= sizeof(xdot_op))
@@ -445,7 +601,7 @@ xdot *parseXDotFOn (char *s, drawfunc_t fns[], int sz, xdot* x)
 	memset(ops + initcnt*sz, '\0', (bufsz - initcnt)*sz);
     }
 
-    while ((s = parseOp(&op, s, fns, &error))) {
+    while ((s = parseOp(&op, s, fns, &error, NULL))) {
 	if (x->cnt == bufsz) {
 	    oldsz = bufsz;
 	    bufsz *= 2;
@@ -480,6 +636,572 @@ xdot *parseXDot(char *s)
     return parseXDotF(s, 0, 0);
 }
 
+/* rebaseOp:
+ * Turn the arena offsets in op into pointers into the arena at base.
+ */
+static void rebaseOp(xdot_op *op, char *base)
+{
+#define REBASE(p) ((p) = (void*)(base + (uintptr_t)(p)))
+    int i, n;
+    xdot_color_stop *stops;
+
+    switch (op->kind) {
+    case xd_filled_polygon:
+    case xd_unfilled_polygon:
+    case xd_filled_bezier:
+    case xd_unfilled_bezier:
+    case xd_polyline:
+	REBASE(op->u.polyline.pts);
+	break;
+    case xd_text:
+	REBASE(op->u.text.text);
+	break;
+    case xd_fill_color:
+    case xd_pen_color:
+	REBASE(op->u.color);
+	break;
+    case xd_grad_fill_color:
+    case xd_grad_pen_color:
+	if (op->u.grad_color.type == xd_linear) {
+	    REBASE(op->u.grad_color.u.ling.stops);
+	    stops = op->u.grad_color.u.ling.stops;
+	    n = op->u.grad_color.u.ling.n_stops;
+	}
+	else {
+	    REBASE(op->u.grad_color.u.ring.stops);
+	    stops = op->u.grad_color.u.ring.stops;
+	    n = op->u.grad_color.u.ring.n_stops;
+	}
+	for (i = 0; i < n; i++)
+	    REBASE(stops[i].color);
+	break;
+    case xd_font:
+	REBASE(op->u.font.name);
+	break;
+    case xd_style:
+	REBASE(op->u.style);
+	break;
+    case xd_image:
+	REBASE(op->u.image.name);
+	break;
+    default:
+	break;
+    }
+#undef REBASE
+}
+
+/* finishCompact:
+ * Make an xdot of the cnt ops of size sz at the start of block, whose data
+ * is at opsz bytes into the block.
+ */
+static xdot *finishCompact(char *block, size_t opsz, int cnt, int sz, int flags)
+{
+    xdot *x;
+    int i;
+
+    for (i = 0; i < cnt; i++)
+	rebaseOp((xdot_op *) (block + i * sz), block + opsz);
+
+    x = NEW(xdot);
+    x->cnt = cnt;
+    x->sz = sz;
+    x->ops = (xdot_op *) block;
+    x->flags = flags | XDOT_COMPACT;
+    return x;
+}
+
+#define ALIGNED(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* compactXDot:
+ * Build a compact xdot from the array of cnt ops of size sz and the arena
+ * holding their data, by appending the arena to the ops array. Takes
+ * ownership of ops and the arena. Returns NULL if cnt is 0.
+ */
+static xdot *compactXDot(char *ops, int cnt, int sz, arena_t *a, int flags)
+{
+    size_t opsz;
+
+    if (cnt == 0) {
+	free(ops);
+	free(a->buf);
+	return NULL;
+    }
+    opsz = ALIGNED((size_t)cnt * sz);
+    ops = realloc(ops, opsz + a->len);
+    if (a->len)
+	memcpy(ops + opsz, a->buf, a->len);
+    free(a->buf);
+    return finishCompact(ops, opsz, cnt, sz, flags);
+}
+
+/* parseXDotCompact:
+ * Parse s like parseXDotF, but keep the points and strings of all ops in a
+ * single block together with the ops array, so parsing needs a handful of
+ * allocations however many ops there are, and freeXDot only one free.
+ */
+xdot *parseXDotCompact(char *s, drawfunc_t fns[], int sz)
+{
+    xdot_op op;
+    char *ops;
+    int cnt = 0, bufsz = XDBSIZE;
+    int error = 0, flags = 0;
+    arena_t a = {0};
+    size_t mark;
+
+    if (!s)
+	return NULL;
+    if (sz <= sizeof(xdot_op))
+	sz = sizeof(xdot_op);
+
+    /* the input length is a fair estimate of the space needed */
+    a.cap = strlen(s) + 1;
+    a.buf = malloc(a.cap);
+    ops = calloc(bufsz, sz);
+    for (;;) {
+	mark = a.len;
+	if (!(s = parseOp(&op, s, fns, &error, &a))) {
+	    a.len = mark;	/* drop the data of a partially parsed op */
+	    break;
+	}
+	if (cnt == bufsz) {
+	    ops = realloc(ops, 2 * bufsz * sz);
+	    memset(ops + bufsz*sz, '\0', bufsz*sz);
+	    bufsz *= 2;
+	}
+	*(xdot_op *) (ops + cnt * sz) = op;
+	cnt++;
+    }
+    if (error)
+	flags |= XDOT_PARSE_ERROR;
+    return compactXDot(ops, cnt, sz, &a, flags);
+}
+
+/* Binary form of an xdot, as written by sprintXDotBinary:
+ *   "XDB1", op count (u32), then per op its xdot_kind (u8) and data:
+ *     ellipse:           x y w h (f64)
+ *     polygon, bezier,
+ *     polyline:          point count (u32), x y (f64) per point
+ *     text:              x y (f64), align (u8), width (f64), text (str)
+ *     color, style:      str
+ *     gradient color:    type (u8), x0 y0 [r0] x1 y1 [r1] (f64),
+ *                        stop count (u32), frac (f64) and color (str) per stop
+ *     font:              size (f64), name (str)
+ *     image:             x y w h (f64), name (str)
+ *     fontchar:          u32
+ * Integers and doubles are little endian; a str is a byte count (u32)
+ * followed by the bytes, without a terminating NUL.
+ */
+#define XDOT_BINARY_MAGIC "XDB1"
+
+static void binBytes(agxbuf *xb, const void *p, size_t n)
+{
+    if (xb->ptr + n > xb->eptr)
+	agxbmore(xb, n);
+    memcpy(xb->ptr, p, n);
+    xb->ptr += n;
+}
+
+static void binU8(agxbuf *xb, unsigned v)
+{
+    agxbputc(xb, (char)v);
+}
+
+static void binU32(agxbuf *xb, uint32_t v)
+{
+    unsigned char b[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+	b[i] = (unsigned char)(v >> (8 * i));
+    binBytes(xb, b, 4);
+}
+
+static void binF64(agxbuf *xb, double d)
+{
+    unsigned char b[8];
+    uint64_t v;
+    int i;
+
+    memcpy(&v, &d, sizeof(v));
+    for (i = 0; i < 8; i++)
+	b[i] = (unsigned char)(v >> (8 * i));
+    binBytes(xb, b, 8);
+}
+
+static void binStr(agxbuf *xb, const char *s)
+{
+    size_t n = strlen(s);
+
+    binU32(xb, (uint32_t)n);
+    binBytes(xb, s, n);
+}
+
+static void binRect(agxbuf *xb, xdot_rect *r)
+{
+    binF64(xb, r->x);
+    binF64(xb, r->y);
+    binF64(xb, r->w);
+    binF64(xb, r->h);
+}
+
+static void binPolyline(agxbuf *xb, xdot_polyline *p)
+{
+    int i;
+
+    binU32(xb, (uint32_t)p->cnt);
+    for (i = 0; i < p->cnt; i++) {
+	binF64(xb, p->pts[i].x);
+	binF64(xb, p->pts[i].y);
+    }
+}
+
+static void binGradient(agxbuf *xb, xdot_color *cp)
+{
+    int i, n_stops;
+    xdot_color_stop *stops;
+
+    binU8(xb, cp->type);
+    if (cp->type == xd_linear) {
+	binF64(xb, cp->u.ling.x0);
+	binF64(xb, cp->u.ling.y0);
+	binF64(xb, cp->u.ling.x1);
+	binF64(xb, cp->u.ling.y1);
+	n_stops = cp->u.ling.n_stops;
+	stops = cp->u.ling.stops;
+    }
+    else {
+	binF64(xb, cp->u.ring.x0);
+	binF64(xb, cp->u.ring.y0);
+	binF64(xb, cp->u.ring.r0);
+	binF64(xb, cp->u.ring.x1);
+	binF64(xb, cp->u.ring.y1);
+	binF64(xb, cp->u.ring.r1);
+	n_stops = cp->u.ring.n_stops;
+	stops = cp->u.ring.stops;
+    }
+    binU32(xb, (uint32_t)n_stops);
+    for (i = 0; i < n_stops; i++) {
+	binF64(xb, stops[i].frac);
+	binStr(xb, stops[i].color);
+    }
+}
+
+/* sprintXDotBinary:
+ * Return the binary form of x in a malloc'ed buffer, storing its
+ * length in *len.
+ */
+unsigned char *sprintXDotBinary(xdot *x, size_t *len)
+{
+    agxbuf xb;
+    xdot_op *op;
+    char *base = (char *) (x->ops);
+    int i;
+
+    agxbinit(&xb, 0, NULL);
+    binBytes(&xb, XDOT_BINARY_MAGIC, 4);
+    binU32(&xb, (uint32_t)x->cnt);
+    for (i = 0; i < x->cnt; i++) {
+	op = (xdot_op *) (base + i * x->sz);
+	binU8(&xb, op->kind);
+	switch (op->kind) {
+	case xd_filled_ellipse:
+	case xd_unfilled_ellipse:
+	    binRect(&xb, &op->u.ellipse);
+	    break;
+	case xd_filled_polygon:
+	case xd_unfilled_polygon:
+	case xd_filled_bezier:
+	case xd_unfilled_bezier:
+	case xd_polyline:
+	    binPolyline(&xb, &op->u.polyline);
+	    break;
+	case xd_text:
+	    binF64(&xb, op->u.text.x);
+	    binF64(&xb, op->u.text.y);
+	    binU8(&xb, op->u.text.align);
+	    binF64(&xb, op->u.text.width);
+	    binStr(&xb, op->u.text.text);
+	    break;
+	case xd_fill_color:
+	case xd_pen_color:
+	    binStr(&xb, op->u.color);
+	    break;
+	case xd_grad_fill_color:
+	case xd_grad_pen_color:
+	    binGradient(&xb, &op->u.grad_color);
+	    break;
+	case xd_font:
+	    binF64(&xb, op->u.font.size);
+	    binStr(&xb, op->u.font.name);
+	    break;
+	case xd_style:
+	    binStr(&xb, op->u.style);
+	    break;
+	case xd_image:
+	    binRect(&xb, &op->u.image.pos);
+	    binStr(&xb, op->u.image.name);
+	    break;
+	case xd_fontchar:
+	    binU32(&xb, op->u.fontchar);
+	    break;
+	}
+    }
+    *len = xb.ptr - xb.buf;
+    return xb.buf;
+}
+
+/* reader for the binary form; each get function returns 0 if the input
+ * is exhausted
+ */
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+} binreader_t;
+
+static int getU8(binreader_t *r, unsigned *v)
+{
+    if (r->end - r->p < 1) return 0;
+    *v = *r->p++;
+    return 1;
+}
+
+static int getU32(binreader_t *r, uint32_t *v)
+{
+    int i;
+
+    if (r->end - r->p < 4) return 0;
+    *v = 0;
+    for (i = 0; i < 4; i++)
+	*v |= (uint32_t)r->p[i] << (8 * i);
+    r->p += 4;
+    return 1;
+}
+
+static int getF64(binreader_t *r, double *d)
+{
+    uint64_t v = 0;
+    int i;
+
+    if (r->end - r->p < 8) return 0;
+    for (i = 0; i < 8; i++)
+	v |= (uint64_t)r->p[i] << (8 * i);
+    memcpy(d, &v, sizeof(v));
+    r->p += 8;
+    return 1;
+}
+
+/* getStr:
+ * Read a string into the arena, storing its offset in *sp.
+ */
+static int getStr(binreader_t *r, arena_t *a, char **sp)
+{
+    uint32_t n;
+
+    if (!getU32(r, &n) || (size_t)(r->end - r->p) < n) return 0;
+    *sp = OFF2PTR(arenaStr(a, (const char*)r->p, n));
+    r->p += n;
+    return 1;
+}
+
+static int getRect(binreader_t *r, xdot_rect *rp)
+{
+    return getF64(r, &rp->x) && getF64(r, &rp->y) && getF64(r, &rp->w)
+	&& getF64(r, &rp->h);
+}
+
+static int getPolyline(binreader_t *r, arena_t *a, xdot_polyline *pp)
+{
+    uint32_t i, n;
+    size_t off;
+    xdot_point *ps;
+
+    /* check the count against the input before allocating for it */
+    if (!getU32(r, &n) || n > INT32_MAX || (size_t)(r->end - r->p) / 16 < n)
+	return 0;
+    off = arenaAlloc(a, n * sizeof(xdot_point));
+    ps = (xdot_point*)(a->buf + off);
+    for (i = 0; i < n; i++) {
+	getF64(r, &ps[i].x);
+	getF64(r, &ps[i].y);
+	ps[i].z = 0;
+    }
+    pp->cnt = (int)n;
+    pp->pts = OFF2PTR(off);
+    return 1;
+}
+
+static int getGradient(binreader_t *r, arena_t *a, xdot_color *clr)
+{
+    unsigned type;
+    uint32_t i, n;
+    size_t off;
+    double frac;
+    char *color;
+    int ok;
+
+    if (!getU8(r, &type))
+	return 0;
+    if (type == xd_linear) {
+	clr->type = xd_linear;
+	ok = getF64(r, &clr->u.ling.x0) && getF64(r, &clr->u.ling.y0)
+	    && getF64(r, &clr->u.ling.x1) && getF64(r, &clr->u.ling.y1);
+    }
+    else if (type == xd_radial) {
+	clr->type = xd_radial;
+	ok = getF64(r, &clr->u.ring.x0) && getF64(r, &clr->u.ring.y0)
+	    && getF64(r, &clr->u.ring.r0) && getF64(r, &clr->u.ring.x1)
+	    && getF64(r, &clr->u.ring.y1) && getF64(r, &clr->u.ring.r1);
+    }
+    else
+	return 0;
+    /* each stop takes at least 12 bytes of input */
+    if (!ok || !getU32(r, &n) || n > INT32_MAX
+	|| (size_t)(r->end - r->p) / 12 < n)
+	return 0;
+    off = arenaAlloc(a, n * sizeof(xdot_color_stop));
+    for (i = 0; i < n; i++) {
+	if (!getF64(r, &frac) || !getStr(r, a, &color))
+	    return 0;
+	((xdot_color_stop*)(a->buf + off))[i].frac = (float)frac;
+	((xdot_color_stop*)(a->buf + off))[i].color = color;
+    }
+    if (clr->type == xd_linear) {
+	clr->u.ling.n_stops = (int)n;
+	clr->u.ling.stops = OFF2PTR(off);
+    }
+    else {
+	clr->u.ring.n_stops = (int)n;
+	clr->u.ring.stops = OFF2PTR(off);
+    }
+    return 1;
+}
+
+/* getOp:
+ * Read one op of the binary form. Returns 0 on error.
+ */
+static int getOp(binreader_t *r, arena_t *a, xdot_op *op, drawfunc_t fns[])
+{
+    unsigned kind, align;
+    uint32_t u;
+    xop_kind xop;
+    int ok;
+
+    if (!getU8(r, &kind))
+	return 0;
+    op->kind = kind;
+    switch (kind) {
+    case xd_filled_ellipse:
+    case xd_unfilled_ellipse:
+	ok = getRect(r, &op->u.ellipse);
+	xop = xop_ellipse;
+	break;
+    case xd_filled_polygon:
+    case xd_unfilled_polygon:
+	ok = getPolyline(r, a, &op->u.polygon);
+	xop = xop_polygon;
+	break;
+    case xd_filled_bezier:
+    case xd_unfilled_bezier:
+	ok = getPolyline(r, a, &op->u.bezier);
+	xop = xop_bezier;
+	break;
+    case xd_polyline:
+	ok = getPolyline(r, a, &op->u.polyline);
+	xop = xop_polyline;
+	break;
+    case xd_text:
+	ok = getF64(r, &op->u.text.x) && getF64(r, &op->u.text.y)
+	    && getU8(r, &align) && align <= xd_right
+	    && getF64(r, &op->u.text.width)
+	    && getStr(r, a, &op->u.text.text);
+	if (ok)
+	    op->u.text.align = align;
+	xop = xop_text;
+	break;
+    case xd_fill_color:
+    case xd_pen_color:
+	ok = getStr(r, a, &op->u.color);
+	xop = kind == xd_fill_color ? xop_fill_color : xop_pen_color;
+	break;
+    case xd_grad_fill_color:
+    case xd_grad_pen_color:
+	ok = getGradient(r, a, &op->u.grad_color);
+	xop = xop_grad_color;
+	break;
+    case xd_font:
+	ok = getF64(r, &op->u.font.size) && getStr(r, a, &op->u.font.name);
+	xop = xop_font;
+	break;
+    case xd_style:
+	ok = getStr(r, a, &op->u.style);
+	xop = xop_style;
+	break;
+    case xd_image:
+	ok = getRect(r, &op->u.image.pos) && getStr(r, a, &op->u.image.name);
+	xop = xop_image;
+	break;
+    case xd_fontchar:
+	ok = getU32(r, &u);
+	if (ok)
+	    op->u.fontchar = u;
+	xop = xop_fontchar;
+	break;
+    default:
+	return 0;
+    }
+    if (ok && fns)
+	op->drawfunc = fns[xop];
+    return ok;
+}
+
+/* parseXDotBinary:
+ * Read the binary form written by sprintXDotBinary into a compact xdot,
+ * as made by parseXDotCompact. As with parseXDotF, ops up to an error in
+ * the input are kept and the XDOT_PARSE_ERROR flag is set.
+ */
+xdot *parseXDotBinary(const unsigned char *buf, size_t len, drawfunc_t fns[],
+                      int sz)
+{
+    binreader_t r = {buf, buf + len};
+    xdot_op *op;
+    char *ops;
+    uint32_t n, i;
+    int cnt = 0, flags = 0;
+    arena_t a = {0};
+    size_t mark;
+
+    if (!buf || len < 8 || memcmp(buf, XDOT_BINARY_MAGIC, 4))
+	return NULL;
+    r.p += 4;
+    getU32(&r, &n);
+    /* each op takes at least 5 bytes of input */
+    if (n > (size_t)(r.end - r.p) / 5)
+	n = (uint32_t)((size_t)(r.end - r.p) / 5);
+    if (n == 0)
+	return NULL;
+    if (sz <= sizeof(xdot_op))
+	sz = sizeof(xdot_op);
+
+    /* decoded, points and strings take at most twice the space they do in
+     * the input, padding included, so the arena should not need to grow
+     */
+    a.cap = 2 * len;
+    a.buf = malloc(a.cap);
+    ops = malloc((size_t)n * sz);
+    for (i = 0; i < n; i++) {
+	op = (xdot_op *) (ops + cnt * sz);
+	memset(op, 0, sz);
+	mark = a.len;
+	if (!getOp(&r, &a, op, fns)) {
+	    a.len = mark;
+	    flags |= XDOT_PARSE_ERROR;
+	    break;
+	}
+	cnt++;
+    }
+    return compactXDot(ops, cnt, sz, &a, flags);
+}
+
 typedef void (*pf) (char *, void *);
 
 /* trim:
@@ -935,7 +1657,9 @@ void freeXDot (xdot * x)
     for (i = 0; i < x->cnt; i++) {
 	op = (xdot_op *) (base + i * x->sz);
 	if (ff) ff (op);
-	freeXOpData(op);
+	/* the data of compact ops is part of the ops block */
+	if (!(x->flags & XDOT_COMPACT))
+	    freeXOpData(op);
     }
     free(base);
     free(x);
@@ -1038,7 +1762,7 @@ radGradient (char* cp, xdot_color* clr)
 	s = parseReal(s, &d);
 	CHK1(s);
 	stops[i].frac = d;
-	s = parseString(s, &stops[i].color);
+	s = parseString(s, &stops[i].color, NULL);
 	CHK1(s);
     }
     clr->u.ring.stops = stops;
@@ -1075,7 +1799,7 @@ linGradient (char* cp, xdot_color* clr)
 	s = parseReal(s, &d);
 	CHK1(s);
 	stops[i].frac = d;
-	s = parseString(s, &stops[i].color);
+	s = parseString(s, &stops[i].color, NULL);
 	CHK1(s);
     }
     clr->u.ling.stops = stops;
@@ -139,6 +139,7 @@ struct _xdot_op {
 };
 
 #define XDOT_PARSE_ERROR 1
+#define XDOT_COMPACT 2  /* op data is stored in the ops block */
 
 typedef struct {
     int cnt;  /* no. of xdot ops */
@@ -170,6 +171,9 @@ typedef struct {
 XDOT_API xdot* parseXDotF (char*, drawfunc_t opfns[], int sz);
 XDOT_API xdot* parseXDotFOn (char*, drawfunc_t opfns[], int sz, xdot*);
 XDOT_API xdot* parseXDot (char*);
+XDOT_API xdot* parseXDotCompact (char*, drawfunc_t opfns[], int sz);
+XDOT_API xdot* parseXDotBinary (const unsigned char*, size_t len, drawfunc_t opfns[], int sz);
+XDOT_API unsigned char* sprintXDotBinary (xdot*, size_t* len);
 XDOT_API char* sprintXDot (xdot*);
 XDOT_API void fprintXDot (FILE*, xdot*);
 XDOT_API void jsonXDot (FILE*, xdot*);
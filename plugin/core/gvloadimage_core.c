@@ -360,6 +360,13 @@ gvplugin_installed_t gvloadimage_core_types[] = {
 
     {FORMAT_SVG_SVG, "svg:svg", 1, &engine_svg, NULL},
 
+    {FORMAT_PNG_SVG, "png:svg_compact", 1, &engine_svg, NULL},
+    {FORMAT_GIF_SVG, "gif:svg_compact", 1, &engine_svg, NULL},
+    {FORMAT_JPEG_SVG, "jpeg:svg_compact", 1, &engine_svg, NULL},
+    {FORMAT_JPEG_SVG, "jpe:svg_compact", 1, &engine_svg, NULL},
+    {FORMAT_JPEG_SVG, "jpg:svg_compact", 1, &engine_svg, NULL},
+    {FORMAT_SVG_SVG, "svg:svg_compact", 1, &engine_svg, NULL},
+
     {FORMAT_PNG_VML, "png:vml", 1, &engine_vml, NULL},
     {FORMAT_GIF_VML, "gif:vml", 1, &engine_vml, NULL},
     {FORMAT_JPEG_VML, "jpeg:vml", 1, &engine_vml, NULL},
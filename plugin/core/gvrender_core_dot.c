@@ -26,6 +26,7 @@
 #include <gvc/gvplugin_render.h>
 #include <gvc/gvplugin_device.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/dtos.h>
 #include <common/utils.h>
 #include <gvc/gvio.h>
 
@@ -131,8 +132,9 @@ static void xdot_fmt_num (char* buf, double v)
         strcpy(buf, "0 ");
         return;
     }
-    sprintf(buf, "%.02f", v);
-    xdot_trim_zeros (buf, 1);
+    size_t len = dtos2(buf, v);
+    buf[len] = ' ';
+    buf[len + 1] = '\0';
 }
 
 static void xdot_point(agxbuf *xb, pointf p)
@@ -14,6 +14,7 @@
 #include <io.h>
 #endif
 
+#include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -27,6 +28,7 @@
 #include <gvc/gvplugin_render.h>
 #include <gvc/gvplugin_device.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/dtos.h>
 #include <common/utils.h>
 #include <gvc/gvc.h>
 #include <gvc/gvio.h>
@@ -39,6 +41,7 @@ typedef enum {
 	FORMAT_JSON0,
 	FORMAT_DOT_JSON,
 	FORMAT_XDOT_JSON,
+	FORMAT_NDJSON,
 } format_type;
 
 typedef struct {
@@ -310,7 +313,7 @@ static void write_xdots (char * val, GVJ_t * job, state_t* sp)
 
     if (!val || *val == '\0') return;
 
-    cmds = parseXDot(val);
+    cmds = parseXDotCompact(val, NULL, 0);
     if (!cmds) {
 	agerr(AGWARN, "Could not parse xdot \"%s\"\n", val);
 	return;
@@ -716,6 +719,433 @@ static void json_end_graph(GVJ_t *job)
     write_graph(g, job, TRUE, &sp);
 }
 
+/* Streaming output: rather than rendering the graph to xdot and then
+ * walking the graph to print the parsed ops, -Tndjson writes one JSON
+ * object per line straight from the render callbacks. Each node, edge and
+ * cluster is bracketed by a "begin" and an "end" line, and each draw op
+ * carries the xdot attribute it would have been stored in. Pen, fill, style
+ * and font ops are only written when they change within an attribute.
+ */
+
+typedef struct {
+    state_t sp;
+    emit_state_t emit_state;
+    boolean have_pen, have_fill, have_font;
+    unsigned char pen[4], fill[4];
+    double penwidth;
+    char **rawstyle;
+    double fontsize;
+    char *fontname;
+    unsigned int fontflags;
+} ndjson_state_t;
+
+static ndjson_state_t nd;
+
+static const char *ndjson_attr[] = {
+    "_draw_", "_draw_", "_tdraw_", "_hdraw_",
+    "_ldraw_", "_ldraw_", "_tldraw_", "_hldraw_",
+    "_draw_", "_draw_", "_ldraw_", "_ldraw_",
+};
+
+static void ndjson_reset(void)
+{
+    nd.have_pen = nd.have_fill = nd.have_font = FALSE;
+    nd.penwidth = PENWIDTH_NORMAL;
+    nd.rawstyle = NULL;
+    nd.fontflags = 0;
+}
+
+static void ndjson_num(GVJ_t *job, double v)
+{
+    char buf[CHARS_FOR_NUL_TERM_DTOS2];
+    size_t len;
+
+    if (v > -0.00000001 && v < 0.00000001)
+	v = 0;
+    len = dtos2(buf, v);
+    gvwrite(job, buf, len);
+}
+
+static void ndjson_point(GVJ_t *job, pointf p)
+{
+    gvputs(job, "[");
+    ndjson_num(job, p.x);
+    gvputs(job, ",");
+    ndjson_num(job, yDir(p.y));
+    gvputs(job, "]");
+}
+
+static void ndjson_str(GVJ_t *job, const char *key, char *s)
+{
+    gvprintf(job, ",\"%s\": \"%s\"", key, stoj(s, &nd.sp));
+}
+
+/* ndjson_op:
+ * Start the line for a draw op, first resetting the cached drawing state
+ * if we have moved on to a different xdot attribute.
+ */
+static void ndjson_op(GVJ_t *job, char op)
+{
+    emit_state_t emit_state = job->obj->emit_state;
+
+    if (emit_state != nd.emit_state) {
+	ndjson_reset();
+	nd.emit_state = emit_state;
+    }
+    gvprintf(job, "{\"attr\": \"%s\",\"op\": \"%c\"", ndjson_attr[emit_state], op);
+}
+
+static void ndjson_begin(GVJ_t *job, const char *type, void *obj)
+{
+    ndjson_reset();
+    nd.emit_state = job->obj->emit_state;
+    gvprintf(job, "{\"begin\": \"%s\"", type);
+    ndjson_str(job, "name", agnameof(obj));
+    if (agobjkind(obj) == AGEDGE) {
+	ndjson_str(job, "tail", agnameof(agtail((edge_t*)obj)));
+	ndjson_str(job, "head", agnameof(aghead((edge_t*)obj)));
+    }
+    gvputs(job, "}\n");
+}
+
+static void ndjson_end(GVJ_t *job, const char *type)
+{
+    gvprintf(job, "{\"end\": \"%s\"}\n", type);
+}
+
+static void ndjson_color(GVJ_t *job, char op, gvcolor_t *clr)
+{
+    unsigned char *rgba = clr->u.rgba;
+
+    ndjson_op(job, op);
+    gvputs(job, ",\"grad\": \"none\"");
+    if (rgba[3] == 0xFF)
+	gvprintf(job, ",\"color\": \"#%02x%02x%02x\"}\n", rgba[0], rgba[1], rgba[2]);
+    else
+	gvprintf(job, ",\"color\": \"#%02x%02x%02x%02x\"}\n",
+	    rgba[0], rgba[1], rgba[2], rgba[3]);
+}
+
+static void ndjson_pencolor(GVJ_t *job)
+{
+    obj_state_t *obj = job->obj;
+
+    if (obj->emit_state == nd.emit_state && nd.have_pen
+	    && !memcmp(nd.pen, obj->pencolor.u.rgba, sizeof(nd.pen)))
+	return;
+    ndjson_color(job, 'c', &obj->pencolor);
+    memcpy(nd.pen, obj->pencolor.u.rgba, sizeof(nd.pen));
+    nd.have_pen = TRUE;
+}
+
+static void ndjson_fillcolor(GVJ_t *job)
+{
+    obj_state_t *obj = job->obj;
+
+    if (obj->emit_state == nd.emit_state && nd.have_fill
+	    && !memcmp(nd.fill, obj->fillcolor.u.rgba, sizeof(nd.fill)))
+	return;
+    ndjson_color(job, 'C', &obj->fillcolor);
+    memcpy(nd.fill, obj->fillcolor.u.rgba, sizeof(nd.fill));
+    nd.have_fill = TRUE;
+}
+
+static void ndjson_stop(GVJ_t *job, float frac, gvcolor_t *clr)
+{
+    unsigned char *rgba = clr->u.rgba;
+
+    gvputs(job, "{\"frac\": ");
+    ndjson_num(job, frac);
+    if (rgba[3] == 0xFF)
+	gvprintf(job, ", \"color\": \"#%02x%02x%02x\"}", rgba[0], rgba[1], rgba[2]);
+    else
+	gvprintf(job, ", \"color\": \"#%02x%02x%02x%02x\"}",
+	    rgba[0], rgba[1], rgba[2], rgba[3]);
+}
+
+/* ndjson_gradient:
+ * Write a gradient fill op, using the same geometry as the xdot renderer.
+ */
+static void ndjson_gradient(GVJ_t *job, int filled, pointf *A, int n)
+{
+    obj_state_t *obj = job->obj;
+    float angle = obj->gradient_angle * M_PI / 180;
+    pointf G[2], c1;
+    double r2;
+
+    ndjson_op(job, 'C');
+    if (filled == GRADIENT) {
+	get_gradient_points(A, G, n, angle, 2);
+	gvputs(job, ",\"grad\": \"linear\",\"p0\": ");
+	ndjson_point(job, G[0]);
+	gvputs(job, ",\"p1\": ");
+	ndjson_point(job, G[1]);
+    }
+    else {
+	get_gradient_points(A, G, n, 0, 3);
+	r2 = G[1].y;
+	c1 = G[0];
+	if (angle != 0) {
+	    c1.x += (r2/4) * cos(angle);
+	    c1.y += (r2/4) * sin(angle);
+	}
+	gvputs(job, ",\"grad\": \"radial\",\"p0\": [");
+	ndjson_num(job, c1.x);
+	gvputs(job, ",");
+	ndjson_num(job, yDir(c1.y));
+	gvputs(job, ",");
+	ndjson_num(job, r2/4);
+	gvputs(job, "],\"p1\": [");
+	ndjson_num(job, G[0].x);
+	gvputs(job, ",");
+	ndjson_num(job, yDir(G[0].y));
+	gvputs(job, ",");
+	ndjson_num(job, r2);
+	gvputs(job, "]");
+    }
+    gvputs(job, ",\"stops\": [");
+    if (obj->gradient_frac > 0) {
+	ndjson_stop(job, obj->gradient_frac, &obj->fillcolor);
+	gvputs(job, ",");
+	ndjson_stop(job, obj->gradient_frac, &obj->stopcolor);
+    }
+    else {
+	ndjson_stop(job, 0, &obj->fillcolor);
+	gvputs(job, ",");
+	ndjson_stop(job, 1, &obj->stopcolor);
+    }
+    gvputs(job, "]}\n");
+    /* the next plain fill has to be written out again */
+    nd.have_fill = FALSE;
+}
+
+static void ndjson_style(GVJ_t *job)
+{
+    obj_state_t *obj = job->obj;
+    char *p, **s;
+    int more;
+
+    if (obj->emit_state != nd.emit_state) {
+	ndjson_reset();
+	nd.emit_state = obj->emit_state;
+    }
+
+    if (obj->penwidth != nd.penwidth) {
+	nd.penwidth = obj->penwidth;
+	ndjson_op(job, 'S');
+	gvputs(job, ",\"style\": \"setlinewidth(");
+	ndjson_num(job, obj->penwidth);
+	gvputs(job, ")\"}\n");
+    }
+
+    if (obj->rawstyle == nd.rawstyle)
+	return;
+    nd.rawstyle = obj->rawstyle;
+    if (!(s = obj->rawstyle))
+	return;
+
+    while ((p = *s++)) {
+	if (streq(p, "filled") || streq(p, "bold") || streq(p, "setlinewidth")) continue;
+	ndjson_op(job, 'S');
+	gvprintf(job, ",\"style\": \"%s", stoj(p, &nd.sp));
+	while (*p)
+	    p++;
+	p++;
+	if (*p) {  /* arguments */
+	    gvputs(job, "(");
+	    more = 0;
+	    while (*p) {
+		if (more)
+		    gvputs(job, ",");
+		gvputs(job, stoj(p, &nd.sp));
+		while (*p) p++;
+		p++;
+		more++;
+	    }
+	    gvputs(job, ")");
+	}
+	gvputs(job, "\"}\n");
+    }
+}
+
+static void ndjson_fill(GVJ_t *job, int filled, pointf *A, int n)
+{
+    if (filled == GRADIENT || filled == RGRADIENT)
+	ndjson_gradient(job, filled, A, n);
+    else
+	ndjson_fillcolor(job);
+}
+
+static void ndjson_points(GVJ_t *job, char op, pointf *A, int n)
+{
+    int i;
+
+    ndjson_op(job, op);
+    gvputs(job, ",\"points\": [");
+    for (i = 0; i < n; i++) {
+	if (i > 0) gvputs(job, ",");
+	ndjson_point(job, A[i]);
+    }
+    gvputs(job, "]}\n");
+}
+
+static void ndjson_begin_graph(GVJ_t *job)
+{
+    graph_t *g = job->obj->u.g;
+
+    nd.sp.Level = 0;
+    nd.sp.isLatin = GD_charset(g) == CHAR_LATIN1;
+    nd.sp.doXDot = TRUE;
+    nd.sp.Attrs_not_written_flag = 0;
+    ndjson_reset();
+    nd.emit_state = job->obj->emit_state;
+
+    gvputs(job, "{\"begin\": \"graph\"");
+    ndjson_str(job, "name", agnameof(g));
+    gvprintf(job, ",\"directed\": %s", agisdirected(g) ? "true" : "false");
+    gvprintf(job, ",\"strict\": %s", agisstrict(g) ? "true" : "false");
+    gvputs(job, ",\"bb\": [");
+    ndjson_num(job, GD_bb(g).LL.x);
+    gvputs(job, ",");
+    ndjson_num(job, yDir(GD_bb(g).LL.y));
+    gvputs(job, ",");
+    ndjson_num(job, GD_bb(g).UR.x);
+    gvputs(job, ",");
+    ndjson_num(job, yDir(GD_bb(g).UR.y));
+    gvputs(job, "]}\n");
+}
+
+static void ndjson_end_graph(GVJ_t *job)
+{
+    ndjson_end(job, "graph");
+}
+
+static void ndjson_begin_cluster(GVJ_t *job)
+{
+    ndjson_begin(job, "cluster", job->obj->u.sg);
+}
+
+static void ndjson_end_cluster(GVJ_t *job)
+{
+    ndjson_end(job, "cluster");
+}
+
+static void ndjson_begin_node(GVJ_t *job)
+{
+    ndjson_begin(job, "node", job->obj->u.n);
+}
+
+static void ndjson_end_node(GVJ_t *job)
+{
+    ndjson_end(job, "node");
+}
+
+static void ndjson_begin_edge(GVJ_t *job)
+{
+    ndjson_begin(job, "edge", job->obj->u.e);
+}
+
+static void ndjson_end_edge(GVJ_t *job)
+{
+    ndjson_end(job, "edge");
+}
+
+static void ndjson_textspan(GVJ_t *job, pointf p, textspan_t *span)
+{
+    unsigned int flags = span->font ? span->font->flags : 0;
+    char align;
+
+    if (job->obj->emit_state != nd.emit_state) {
+	ndjson_reset();
+	nd.emit_state = job->obj->emit_state;
+    }
+    if (span->font && (!nd.have_font || nd.fontsize != span->font->size
+	    || nd.fontname != span->font->name)) {
+	ndjson_op(job, 'F');
+	gvputs(job, ",\"size\": ");
+	ndjson_num(job, span->font->size);
+	ndjson_str(job, "face", span->font->name);
+	gvputs(job, "}\n");
+	nd.fontsize = span->font->size;
+	nd.fontname = span->font->name;
+	nd.have_font = TRUE;
+    }
+    ndjson_pencolor(job);
+    if (nd.fontflags != flags) {
+	ndjson_op(job, 't');
+	gvprintf(job, ",\"fontchar\": %u}\n", flags);
+	nd.fontflags = flags;
+    }
+
+    switch (span->just) {
+    case 'l':
+	align = 'l';
+	break;
+    case 'r':
+	align = 'r';
+	break;
+    default:
+	align = 'c';
+	break;
+    }
+    p.y += span->yoffset_centerline;
+    ndjson_op(job, 'T');
+    gvputs(job, ",\"pt\": ");
+    ndjson_point(job, p);
+    gvprintf(job, ",\"align\": \"%c\",\"width\": ", align);
+    ndjson_num(job, span->size.x);
+    ndjson_str(job, "text", span->str);
+    gvputs(job, "}\n");
+}
+
+static void ndjson_ellipse(GVJ_t *job, pointf *A, int filled)
+{
+    ndjson_style(job);
+    ndjson_pencolor(job);
+    if (filled)
+	ndjson_fill(job, filled, A, 2);
+    ndjson_op(job, filled ? 'E' : 'e');
+    gvputs(job, ",\"rect\": [");
+    ndjson_num(job, A[0].x);
+    gvputs(job, ",");
+    ndjson_num(job, yDir(A[0].y));
+    gvputs(job, ",");
+    ndjson_num(job, A[1].x - A[0].x);
+    gvputs(job, ",");
+    ndjson_num(job, A[1].y - A[0].y);
+    gvputs(job, "]}\n");
+}
+
+static void ndjson_polygon(GVJ_t *job, pointf *A, int n, int filled)
+{
+    ndjson_style(job);
+    ndjson_pencolor(job);
+    if (filled)
+	ndjson_fill(job, filled, A, n);
+    ndjson_points(job, filled ? 'P' : 'p', A, n);
+}
+
+static void ndjson_bezier(GVJ_t *job, pointf *A, int n, int arrow_at_start,
+                          int arrow_at_end, int filled)
+{
+    (void)arrow_at_start;
+    (void)arrow_at_end;
+
+    ndjson_style(job);
+    ndjson_pencolor(job);
+    if (filled)
+	ndjson_fill(job, filled, A, n);
+    /* follow -Tjson, which names the ops as the xdot parser reports them */
+    ndjson_points(job, filled ? 'B' : 'b', A, n);
+}
+
+static void ndjson_polyline(GVJ_t *job, pointf *A, int n)
+{
+    ndjson_style(job);
+    ndjson_pencolor(job);
+    ndjson_points(job, 'L', A, n);
+}
+
 gvrender_engine_t json_engine = {
     0,				/* json_begin_job */
     0,				/* json_end_job */
@@ -749,6 +1179,39 @@ gvrender_engine_t json_engine = {
     0,				/* json_library_shape */
 };
 
+gvrender_engine_t ndjson_engine = {
+    0,				/* ndjson_begin_job */
+    0,				/* ndjson_end_job */
+    ndjson_begin_graph,
+    ndjson_end_graph,
+    0,				/* ndjson_begin_layer */
+    0,				/* ndjson_end_layer */
+    0,				/* ndjson_begin_page */
+    0,				/* ndjson_end_page */
+    ndjson_begin_cluster,
+    ndjson_end_cluster,
+    0,				/* ndjson_begin_nodes */
+    0,				/* ndjson_end_nodes */
+    0,				/* ndjson_begin_edges */
+    0,				/* ndjson_end_edges */
+    ndjson_begin_node,
+    ndjson_end_node,
+    ndjson_begin_edge,
+    ndjson_end_edge,
+    0,				/* ndjson_begin_anchor */
+    0,				/* ndjson_end_anchor */
+    0,				/* ndjson_begin_label */
+    0,				/* ndjson_end_label */
+    ndjson_textspan,
+    0,				/* ndjson_resolve_color */
+    ndjson_ellipse,
+    ndjson_polygon,
+    ndjson_bezier,
+    ndjson_polyline,
+    0,				/* ndjson_comment */
+    0,				/* ndjson_library_shape */
+};
+
 gvrender_features_t render_features_json1 = {
     GVRENDER_DOES_TRANSFORM,	/* not really - uses raw graph coords */  /* flags */
     0.,                         /* default pad - graph units */
@@ -768,6 +1231,14 @@ gvrender_features_t render_features_json = {
     COLOR_STRING,		/* color_type */
 };
 
+gvrender_features_t render_features_ndjson = {
+    GVRENDER_DOES_TRANSFORM,	/* not really - uses raw graph coords */  /* flags */
+    0.,                         /* default pad - graph units */
+    NULL,			/* knowncolors */
+    0,				/* sizeof knowncolors */
+    RGBA_BYTE,			/* color_type */
+};
+
 gvdevice_features_t device_features_json_nop = {
     LAYOUT_NOT_REQUIRED,	/* flags */
     {0.,0.},			/* default margin - points */
@@ -787,6 +1258,7 @@ gvplugin_installed_t gvrender_json_types[] = {
     {FORMAT_JSON0, "json0", 1, &json_engine, &render_features_json},
     {FORMAT_DOT_JSON, "dot_json", 1, &json_engine, &render_features_json},
     {FORMAT_XDOT_JSON, "xdot_json", 1, &json_engine, &render_features_json},
+    {FORMAT_NDJSON, "ndjson", 1, &ndjson_engine, &render_features_ndjson},
     {0, NULL, 0, NULL, NULL}
 };
 
@@ -795,5 +1267,6 @@ gvplugin_installed_t gvdevice_json_types[] = {
     {FORMAT_JSON0, "json0:json", 1, NULL, &device_features_json},
     {FORMAT_DOT_JSON, "dot_json:json", 1, NULL, &device_features_json_nop},
     {FORMAT_XDOT_JSON, "xdot_json:json", 1, NULL, &device_features_json_nop},
+    {FORMAT_NDJSON, "ndjson:ndjson", 1, NULL, &device_features_json},
     {0, NULL, 0, NULL, NULL}
 };
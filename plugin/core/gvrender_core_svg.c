@@ -21,12 +21,15 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
 #include <common/macros.h>
 #include <common/const.h>
+#include <common/memory.h>
 
 #include <gvc/gvplugin_render.h>
 #include <cgraph/agxbuf.h>
@@ -34,7 +37,9 @@
 #include <gvc/gvplugin_device.h>
 #include <gvc/gvio.h>
 #include <gvc/gvcint.h>
+#include <cgraph/dtos.h>
 #include <cgraph/strcasecmp.h>
+#include <cdt/cdt.h>
 
 #define LOCALNAMEPREFIX		'%'
 
@@ -45,7 +50,150 @@
 // optimized gvputs for string literals
 #define GVPUTS(job, str) gvwrite((job), (str), sizeof(str) - 1)
 
-typedef enum { FORMAT_SVG, FORMAT_SVGZ, } format_type;
+typedef enum { FORMAT_SVG, FORMAT_SVGZ, FORMAT_SVG_COMPACT, FORMAT_SVGZ_COMPACT, } format_type;
+
+/* -Tsvg_compact writes each distinct shape and gradient once, as a
+ * definition referred to by <use> or url(), and each distinct style once,
+ * as a CSS class. Definitions are written just before their first use, so
+ * the output is still produced in a single pass.
+ */
+#define COMPACT(job) \
+    ((job)->render.id == FORMAT_SVG_COMPACT || (job)->render.id == FORMAT_SVGZ_COMPACT)
+
+typedef struct {
+    Dtlink_t link;
+    char *key;		/* text of the definition */
+    int id;
+} svg_def_t;
+
+static void svg_def_free(Dt_t *dt, void *obj, Dtdisc_t *disc)
+{
+    (void)dt;
+    (void)disc;
+
+    free(obj);
+}
+
+static Dtdisc_t svg_def_disc = {
+    offsetof(svg_def_t, key),
+    -1,
+    offsetof(svg_def_t, link),
+    NIL(Dtmake_f),
+    svg_def_free,
+    NIL(Dtcompar_f),
+    NIL(Dthash_f),
+    NIL(Dtmemory_f),
+    NIL(Dtevent_f)
+};
+
+static Dt_t *svg_defs;	/* definitions written in the current graph */
+static int svg_ndefs;	/* not reset, so ids stay unique within a file */
+
+/* svg_def:
+ * Return the id of the definition with the given text, noting whether
+ * it has not been seen before and so still has to be written.
+ */
+static int svg_def(char *key, bool *isnew)
+{
+    svg_def_t *d;
+    size_t len;
+
+    if ((d = dtmatch(svg_defs, key))) {
+	*isnew = false;
+	return d->id;
+    }
+    len = strlen(key) + 1;
+    d = gmalloc(sizeof(svg_def_t) + len);
+    d->key = (char *)(d + 1);
+    memcpy(d->key, key, len);
+    d->id = svg_ndefs++;
+    dtinsert(svg_defs, d);
+    *isnew = true;
+    return d->id;
+}
+
+/* svg_class:
+ * Return the CSS class for the declarations in css, which is
+ * enclosed in braces, writing its rule if it is new.
+ */
+static int svg_class(GVJ_t * job, agxbuf * css)
+{
+    bool isnew;
+    char *rule = agxbuse(css);
+    int id = svg_def(rule, &isnew);
+
+    if (isnew) {
+	gvprintf(job, "<style>.s_%d", id);
+	gvputs(job, rule);
+	GVPUTS(job, "</style>\n");
+    }
+    return id;
+}
+
+/* svg_attr:
+ * Write a presentation attribute, or add it as a declaration to css.
+ */
+static void svg_attr(GVJ_t * job, agxbuf * css, const char *name,
+		     const char *value)
+{
+    if (css) {
+	agxbprint(css, "%s:%s;", name, value);
+    } else {
+	gvprintf(job, " %s=\"", name);
+	gvputs(job, value);
+	GVPUTS(job, "\"");
+    }
+}
+
+static void svg_xbdouble(agxbuf * xb, double num)
+{
+    char buf[CHARS_FOR_NUL_TERM_DTOS2];
+
+    gvformatdouble(buf, num);
+    agxbput(xb, buf);
+}
+
+/* svg_css_family:
+ * Add a font-family list to css, quoting all but the generic families.
+ */
+static void svg_css_family(agxbuf * css, const char *family)
+{
+    static const char *generic[] = {
+	"serif", "sans-serif", "monospace", "cursive", "fantasy", NULL
+    };
+    const char **g;
+    const char *end, *stop;
+    size_t len;
+
+    agxbput(css, "font-family:");
+    for (;;) {
+	end = strchr(family, ',');
+	len = end ? (size_t)(end - family) : strlen(family);
+	for (g = generic; *g; g++)
+	    if (strlen(*g) == len && strncmp(*g, family, len) == 0)
+		break;
+	if (*g) {
+	    agxbput(css, *g);
+	} else {
+	    /* escape anything that could end the string, the rule or the
+	     * <style> element */
+	    agxbputc(css, '"');
+	    for (stop = family + len; family < stop; family++) {
+		if (isalnum((unsigned char)*family) || *family == ' '
+		    || *family == '-' || *family == '_' || *family == '.')
+		    agxbputc(css, *family);
+		else
+		    agxbprint(css, "\\%x ", (unsigned char)*family);
+	    }
+	    agxbputc(css, '"');
+	}
+	if (!end)
+	    break;
+	agxbputc(css, ',');
+	family = end + 1;
+    }
+    agxbputc(css, ';');
+}
 
 /* SVG dash array */
 static char *sdasharray = "5,2";
@@ -103,60 +251,116 @@ static void svg_print_id_class(GVJ_t * job, char* id, char* idx, char* kind, voi
     GVPUTS(job, "\"");
 }
 
-static void svg_print_color(GVJ_t * job, gvcolor_t color)
+/* svg_color:
+ * Format a color into buf, which must hold at least 12 bytes.
+ */
+static char *svg_color(char *buf, gvcolor_t color)
 {
     switch (color.type) {
     case COLOR_STRING:
-	gvputs(job, color.u.string);
-	break;
+	return color.u.string;
     case RGBA_BYTE:
 	if (color.u.rgba[3] == 0)	/* transparent */
-	    GVPUTS(job, "transparent");
+	    strcpy(buf, "transparent");
 	else
-	    gvprintf(job, "#%02x%02x%02x",
-		     color.u.rgba[0], color.u.rgba[1], color.u.rgba[2]);
-	break;
+	    sprintf(buf, "#%02x%02x%02x",
+		    color.u.rgba[0], color.u.rgba[1], color.u.rgba[2]);
+	return buf;
     default:
 	assert(0);		/* internal error */
+	return "black";
+    }
+}
+
+/* svg_opacity:
+ * Format the alpha of a color into buf, or return NULL if it is opaque
+ * or fully transparent.
+ */
+static char *svg_opacity(char *buf, gvcolor_t color)
+{
+    if (color.type == RGBA_BYTE && color.u.rgba[3] > 0
+	&& color.u.rgba[3] < 255) {
+	sprintf(buf, "%f", ((float) color.u.rgba[3] / 255.0));
+	return buf;
     }
+    return NULL;
 }
 
-static void svg_grstyle(GVJ_t * job, int filled, int gid)
+/* svg_grstyle:
+ * Write the paint of a shape as attributes, or add it to css.
+ */
+static void svg_grstyle(GVJ_t * job, agxbuf * css, int filled, int gid)
 {
     obj_state_t *obj = job->obj;
+    char buf[CHARS_FOR_NUL_TERM_DTOS2];
+    char *opacity;
 
-    GVPUTS(job, " fill=\"");
     if (filled == GRADIENT) {
-	gvprintf(job, "url(#l_%d)", gid);
+	sprintf(buf, "url(#l_%d)", gid);
+	svg_attr(job, css, "fill", buf);
     } else if (filled == RGRADIENT) {
-	gvprintf(job, "url(#r_%d)", gid);
+	sprintf(buf, "url(#r_%d)", gid);
+	svg_attr(job, css, "fill", buf);
     } else if (filled) {
-	svg_print_color(job, obj->fillcolor);
-	if (obj->fillcolor.type == RGBA_BYTE
-	    && obj->fillcolor.u.rgba[3] > 0
-	    && obj->fillcolor.u.rgba[3] < 255)
-	    gvprintf(job, "\" fill-opacity=\"%f",
-		     ((float) obj->fillcolor.u.rgba[3] / 255.0));
+	svg_attr(job, css, "fill", svg_color(buf, obj->fillcolor));
+	if ((opacity = svg_opacity(buf, obj->fillcolor)))
+	    svg_attr(job, css, "fill-opacity", opacity);
     } else {
-	GVPUTS(job, "none");
+	svg_attr(job, css, "fill", "none");
     }
-    GVPUTS(job, "\" stroke=\"");
-    svg_print_color(job, obj->pencolor);
+    svg_attr(job, css, "stroke", svg_color(buf, obj->pencolor));
     if (obj->penwidth != PENWIDTH_NORMAL) {
-	GVPUTS(job, "\" stroke-width=\"");
-        gvprintdouble(job, obj->penwidth);
+	gvformatdouble(buf, obj->penwidth);
+	if (css)	/* CSS lengths need a unit */
+	    strcat(buf, "px");
+	svg_attr(job, css, "stroke-width", buf);
     }
     if (obj->pen == PEN_DASHED) {
-	gvprintf(job, "\" stroke-dasharray=\"%s", sdasharray);
+	svg_attr(job, css, "stroke-dasharray", sdasharray);
     } else if (obj->pen == PEN_DOTTED) {
-	gvprintf(job, "\" stroke-dasharray=\"%s", sdotarray);
+	svg_attr(job, css, "stroke-dasharray", sdotarray);
     }
-    if (obj->pencolor.type == RGBA_BYTE && obj->pencolor.u.rgba[3] > 0
-	&& obj->pencolor.u.rgba[3] < 255)
-	gvprintf(job, "\" stroke-opacity=\"%f",
-		 ((float) obj->pencolor.u.rgba[3] / 255.0));
+    if ((opacity = svg_opacity(buf, obj->pencolor)))
+	svg_attr(job, css, "stroke-opacity", opacity);
+}
 
-    GVPUTS(job, "\"");
+/* svg_grclass:
+ * -Tsvg_compact: return the CSS class for the paint of a shape.
+ */
+static int svg_grclass(GVJ_t * job, int filled, int gid)
+{
+    agxbuf css;
+    int id;
+
+    agxbinit(&css, 0, NULL);
+    agxbputc(&css, '{');
+    svg_grstyle(job, &css, filled, gid);
+    agxbputc(&css, '}');
+    id = svg_class(job, &css);
+    agxbfree(&css);
+    return id;
+}
+
+/* svg_use:
+ * -Tsvg_compact: write a reference at p to the shape whose definition
+ * is in shape, writing the definition first if it is new.
+ */
+static void svg_use(GVJ_t * job, agxbuf * shape, pointf p, int cls)
+{
+    bool isnew;
+    char *def = agxbuse(shape);
+    int id = svg_def(def, &isnew);
+
+    if (isnew) {
+	GVPUTS(job, "<defs>\n<");
+	gvputs(job, def);
+	gvprintf(job, " id=\"d_%d\"/>\n</defs>\n", id);
+    }
+    gvprintf(job, "<use xlink:href=\"#d_%d\" x=\"", id);
+    gvprintdouble(job, p.x);
+    GVPUTS(job, "\" y=\"");
+    gvprintdouble(job, -p.y);
+    gvprintf(job, "\" class=\"s_%d\"/>\n", cls);
 }
 
 static void svg_comment(GVJ_t * job, char *str)
@@ -213,11 +417,21 @@ static void svg_begin_graph(GVJ_t * job)
     /* namespace of xlink */
                 " xmlns:xlink=\"http://www.w3.org/1999/xlink\""
                 ">\n");
+
+    if (COMPACT(job)) {
+	if (svg_defs)
+	    dtclose(svg_defs);
+	svg_defs = dtopen(&svg_def_disc, Dtset);
+    }
 }
 
 static void svg_end_graph(GVJ_t * job)
 {
     GVPUTS(job, "</svg>\n");
+    if (svg_defs) {
+	dtclose(svg_defs);
+	svg_defs = NULL;
+    }
 }
 
 static void svg_begin_layer(GVJ_t * job, char *layername, int layerNum,
@@ -364,34 +578,22 @@ static void svg_end_anchor(GVJ_t * job)
                 "</g>\n");
 }
 
-static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
+/* svg_textstyle:
+ * Write the font and color of a text span as attributes, or add them
+ * to css.
+ */
+static void svg_textstyle(GVJ_t * job, agxbuf * css, textspan_t * span)
 {
     obj_state_t *obj = job->obj;
     PostscriptAlias *pA;
     char *family = NULL, *weight = NULL, *stretch = NULL, *style = NULL;
+    unsigned char vbuf[64];
+    char buf[64];
+    char *opacity;
     unsigned int flags;
+    agxbuf value;
 
-    GVPUTS(job, "<text");
-    switch (span->just) {
-    case 'l':
-	GVPUTS(job, " text-anchor=\"start\"");
-	break;
-    case 'r':
-	GVPUTS(job, " text-anchor=\"end\"");
-	break;
-    default:
-    case 'n':
-	GVPUTS(job, " text-anchor=\"middle\"");
-	break;
-    }
-    p.y += span->yoffset_centerline;
-    if (!obj->labeledgealigned) {
-	GVPUTS(job, " x=\"");
-        gvprintdouble(job, p.x);
-        GVPUTS(job, "\" y=\"");
-        gvprintdouble(job, -p.y);
-        GVPUTS(job, "\"");
-    }
+    agxbinit(&value, sizeof(vbuf), vbuf);
     pA = span->font->postscript_alias;
     if (pA) {
 	switch (GD_fontnames(job->gvc->g)) {
@@ -414,60 +616,117 @@ static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	}
 	stretch = pA->stretch;
 
-	gvprintf(job, " font-family=\"%s", family);
+	if (family)
+	    agxbput(&value, family);
 	if (pA->svg_font_family)
-	    gvprintf(job, ",%s", pA->svg_font_family);
-	GVPUTS(job, "\"");
+	    agxbprint(&value, ",%s", pA->svg_font_family);
+	if (css)
+	    svg_css_family(css, agxbuse(&value));
+	else
+	    svg_attr(job, css, "font-family", agxbuse(&value));
 	if (weight)
-	    gvprintf(job, " font-weight=\"%s\"", weight);
+	    svg_attr(job, css, "font-weight", weight);
 	if (stretch)
-	    gvprintf(job, " font-stretch=\"%s\"", stretch);
+	    svg_attr(job, css, "font-stretch", stretch);
 	if (style)
-	    gvprintf(job, " font-style=\"%s\"", style);
-    } else
-	gvprintf(job, " font-family=\"%s\"", span->font->name);
+	    svg_attr(job, css, "font-style", style);
+    } else if (css)
+	svg_css_family(css, span->font->name);
+    else
+	svg_attr(job, css, "font-family", span->font->name);
     if ((span->font) && (flags = span->font->flags)) {
 	if ((flags & HTML_BF) && !weight)
-	    GVPUTS(job, " font-weight=\"bold\"");
+	    svg_attr(job, css, "font-weight", "bold");
 	if ((flags & HTML_IF) && !style)
-	    GVPUTS(job, " font-style=\"italic\"");
+	    svg_attr(job, css, "font-style", "italic");
 	if ((flags & (HTML_UL|HTML_S|HTML_OL))) {
+	    /* CSS separates the values with spaces */
+	    const char *sep = css ? " " : ",";
 	    int comma = 0;
-	    GVPUTS(job, " text-decoration=\"");
 	    if ((flags & HTML_UL)) {
-		GVPUTS(job, "underline");
+		agxbput(&value, "underline");
 		comma = 1;
 	    }
 	    if ((flags & HTML_OL)) {
-		gvprintf(job, "%soverline", (comma?",":""));
+		agxbprint(&value, "%soverline", (comma?sep:""));
 		comma = 1;
 	    }
 	    if ((flags & HTML_S))
-		gvprintf(job, "%sline-through", (comma?",":""));
-	    GVPUTS(job, "\"");
+		agxbprint(&value, "%sline-through", (comma?sep:""));
+	    svg_attr(job, css, "text-decoration", agxbuse(&value));
 	}
 	if ((flags & HTML_SUP))
-	    GVPUTS(job, " baseline-shift=\"super\"");
+	    svg_attr(job, css, "baseline-shift", "super");
 	if ((flags & HTML_SUB))
-	    GVPUTS(job, " baseline-shift=\"sub\"");
+	    svg_attr(job, css, "baseline-shift", "sub");
     }
 
-    gvprintf(job, " font-size=\"%.2f\"", span->font->size);
+    sprintf(buf, css ? "%.2fpx" : "%.2f", span->font->size);
+    svg_attr(job, css, "font-size", buf);
     switch (obj->pencolor.type) {
     case COLOR_STRING:
 	if (strcasecmp(obj->pencolor.u.string, "black"))
-	    gvprintf(job, " fill=\"%s\"", obj->pencolor.u.string);
+	    svg_attr(job, css, "fill", obj->pencolor.u.string);
 	break;
     case RGBA_BYTE:
-	gvprintf(job, " fill=\"#%02x%02x%02x\"",
-		 obj->pencolor.u.rgba[0], obj->pencolor.u.rgba[1],
-		 obj->pencolor.u.rgba[2]);
-	if (obj->pencolor.u.rgba[3] > 0 && obj->pencolor.u.rgba[3] < 255)
-	    gvprintf(job, " fill-opacity=\"%f\"", ((float) obj->pencolor.u.rgba[3] / 255.0));
+	sprintf(buf, "#%02x%02x%02x",
+		obj->pencolor.u.rgba[0], obj->pencolor.u.rgba[1],
+		obj->pencolor.u.rgba[2]);
+	svg_attr(job, css, "fill", buf);
+	if ((opacity = svg_opacity(buf, obj->pencolor)))
+	    svg_attr(job, css, "fill-opacity", opacity);
 	break;
     default:
 	assert(0);		/* internal error */
     }
+    agxbfree(&value);
+}
+
+static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
+{
+    obj_state_t *obj = job->obj;
+    char *anchor;
+    int cls = 0;
+
+    switch (span->just) {
+    case 'l':
+	anchor = "start";
+	break;
+    case 'r':
+	anchor = "end";
+	break;
+    default:
+    case 'n':
+	anchor = "middle";
+	break;
+    }
+    if (COMPACT(job)) {
+	agxbuf css;
+
+	agxbinit(&css, 0, NULL);
+	agxbputc(&css, '{');
+	svg_attr(job, &css, "text-anchor", anchor);
+	svg_textstyle(job, &css, span);
+	agxbputc(&css, '}');
+	cls = svg_class(job, &css);
+	agxbfree(&css);
+	GVPUTS(job, "<text");
+    } else {
+	GVPUTS(job, "<text");
+	svg_attr(job, NULL, "text-anchor", anchor);
+    }
+    p.y += span->yoffset_centerline;
+    if (!obj->labeledgealigned) {
+	GVPUTS(job, " x=\"");
+        gvprintdouble(job, p.x);
+        GVPUTS(job, "\" y=\"");
+        gvprintdouble(job, -p.y);
+        GVPUTS(job, "\"");
+    }
+    if (COMPACT(job))
+	gvprintf(job, " class=\"s_%d\"", cls);
+    else
+	svg_textstyle(job, NULL, span);
     GVPUTS(job, ">");
     if (obj->labeledgealigned) {
 	gvprintf(job, "<textPath xlink:href=\"#%s_p\" startOffset=\"50%%\">", xml_string(obj->id));
@@ -481,6 +740,50 @@ static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
     GVPUTS(job, "</text>\n");
 }
 
+/* svg_stop:
+ * Add a gradient stop at offset, a string, to xb.
+ */
+static void svg_stop(agxbuf * xb, const char *offset, gvcolor_t color)
+{
+    char buf[16];
+    char *opacity;
+
+    agxbprint(xb, "<stop offset=\"%s\" style=\"stop-color:", offset);
+    agxbput(xb, svg_color(buf, color));
+    agxbput(xb, ";stop-opacity:");
+    agxbput(xb, (opacity = svg_opacity(buf, color)) ? opacity : "1.");
+    agxbput(xb, ";\"/>\n");
+}
+
+/* svg_gradient:
+ * Write the gradient whose element name is the first word of xb,
+ * followed by its attributes and stops, with the given id prefix.
+ * For -Tsvg_compact, an identical gradient written earlier is reused.
+ * Return the id of the gradient.
+ */
+static int svg_gradient(GVJ_t * job, agxbuf * xb, char prefix, int *counter)
+{
+    char *def = agxbuse(xb);
+    char *attrs = strchr(def, ' ');
+    bool isnew = true;
+    int id;
+
+    if (COMPACT(job))
+	id = svg_def(def, &isnew);
+    else
+	id = (*counter)++;
+    if (isnew) {
+	GVPUTS(job, "<defs>\n<");
+	gvwrite(job, def, (size_t)(attrs - def));
+	gvprintf(job, " id=\"%c_%d\"", prefix, id);
+	gvputs(job, attrs);
+	gvwrite(job, "</", 2);
+	gvwrite(job, def, (size_t)(attrs - def));
+	GVPUTS(job, ">\n</defs>\n");
+    }
+    return id;
+}
+
 /* svg_gradstyle
  * Outputs the SVG statements that define the gradient pattern
  */
@@ -489,48 +792,37 @@ static int svg_gradstyle(GVJ_t * job, pointf * A, int n)
     pointf G[2];
     float angle;
     static int gradId;
-    int id = gradId++;
+    char offset[16];
+    agxbuf xb;
+    int id;
 
     obj_state_t *obj = job->obj;
     angle = obj->gradient_angle * M_PI / 180;	//angle of gradient line
     G[0].x = G[0].y = G[1].x = G[1].y = 0.;
     get_gradient_points(A, G, n, angle, 0);	//get points on gradient line
 
-    gvprintf(job,
-	     "<defs>\n<linearGradient id=\"l_%d\" gradientUnits=\"userSpaceOnUse\" ", id);
-    GVPUTS(job, "x1=\"");
-    gvprintdouble(job, G[0].x);
-    GVPUTS(job, "\" y1=\"");
-    gvprintdouble(job, G[0].y);
-    GVPUTS(job, "\" x2=\"");
-    gvprintdouble(job, G[1].x);
-    GVPUTS(job, "\" y2=\"");
-    gvprintdouble(job, G[1].y);
-    GVPUTS(job, "\" >\n");
+    agxbinit(&xb, 0, NULL);
+    agxbput(&xb, "linearGradient gradientUnits=\"userSpaceOnUse\" x1=\"");
+    svg_xbdouble(&xb, G[0].x);
+    agxbput(&xb, "\" y1=\"");
+    svg_xbdouble(&xb, G[0].y);
+    agxbput(&xb, "\" x2=\"");
+    svg_xbdouble(&xb, G[1].x);
+    agxbput(&xb, "\" y2=\"");
+    svg_xbdouble(&xb, G[1].y);
+    agxbput(&xb, "\" >\n");
     if (obj->gradient_frac > 0)
-	gvprintf(job, "<stop offset=\"%.03f\" style=\"stop-color:", obj->gradient_frac - 0.001);
-    else
-	GVPUTS(job, "<stop offset=\"0\" style=\"stop-color:");
-    svg_print_color(job, obj->fillcolor);
-    GVPUTS(job, ";stop-opacity:");
-    if (obj->fillcolor.type == RGBA_BYTE && obj->fillcolor.u.rgba[3] > 0
-	&& obj->fillcolor.u.rgba[3] < 255)
-	gvprintf(job, "%f", ((float) obj->fillcolor.u.rgba[3] / 255.0));
+	sprintf(offset, "%.03f", obj->gradient_frac - 0.001);
     else
-	GVPUTS(job, "1.");
-    GVPUTS(job, ";\"/>\n");
+	strcpy(offset, "0");
+    svg_stop(&xb, offset, obj->fillcolor);
     if (obj->gradient_frac > 0)
-	gvprintf(job, "<stop offset=\"%.03f\" style=\"stop-color:", obj->gradient_frac);
+	sprintf(offset, "%.03f", obj->gradient_frac);
     else
-	GVPUTS(job, "<stop offset=\"1\" style=\"stop-color:");
-    svg_print_color(job, obj->stopcolor);
-    GVPUTS(job, ";stop-opacity:");
-    if (obj->stopcolor.type == RGBA_BYTE && obj->stopcolor.u.rgba[3] > 0
-	&& obj->stopcolor.u.rgba[3] < 255)
-	gvprintf(job, "%f", ((float) obj->stopcolor.u.rgba[3] / 255.0));
-    else
-	GVPUTS(job, "1.");
-    GVPUTS(job, ";\"/>\n</linearGradient>\n</defs>\n");
+	strcpy(offset, "1");
+    svg_stop(&xb, offset, obj->stopcolor);
+    id = svg_gradient(job, &xb, 'l', &gradId);
+    agxbfree(&xb);
     return id;
 }
 
@@ -542,7 +834,8 @@ static int svg_rgradstyle(GVJ_t * job)
     float angle;
     int ifx, ify;
     static int rgradId;
-    int id = rgradId++;
+    agxbuf xb;
+    int id;
 
     obj_state_t *obj = job->obj;
     angle = obj->gradient_angle * M_PI / 180;	//angle of gradient line
@@ -552,43 +845,72 @@ static int svg_rgradstyle(GVJ_t * job)
 	ifx = 50 * (1 + cos(angle));
 	ify = 50 * (1 - sin(angle));
     }
-    gvprintf(job,
-	     "<defs>\n<radialGradient id=\"r_%d\" cx=\"50%%\" cy=\"50%%\" r=\"75%%\" fx=\"%d%%\" fy=\"%d%%\">\n",
-	     id, ifx, ify);
-    GVPUTS(job, "<stop offset=\"0\" style=\"stop-color:");
-    svg_print_color(job, obj->fillcolor);
-    GVPUTS(job, ";stop-opacity:");
-    if (obj->fillcolor.type == RGBA_BYTE && obj->fillcolor.u.rgba[3] > 0
-	&& obj->fillcolor.u.rgba[3] < 255)
-	gvprintf(job, "%f", ((float) obj->fillcolor.u.rgba[3] / 255.0));
-    else
-	GVPUTS(job, "1.");
-    GVPUTS(job, ";\"/>\n"
-                "<stop offset=\"1\" style=\"stop-color:");
-    svg_print_color(job, obj->stopcolor);
-    GVPUTS(job, ";stop-opacity:");
-    if (obj->stopcolor.type == RGBA_BYTE && obj->stopcolor.u.rgba[3] > 0
-	&& obj->stopcolor.u.rgba[3] < 255)
-	gvprintf(job, "%f", ((float) obj->stopcolor.u.rgba[3] / 255.0));
-    else
-	GVPUTS(job, "1.");
-    GVPUTS(job, ";\"/>\n</radialGradient>\n</defs>\n");
+    agxbinit(&xb, 0, NULL);
+    agxbprint(&xb,
+	      "radialGradient cx=\"50%%\" cy=\"50%%\" r=\"75%%\" fx=\"%d%%\" fy=\"%d%%\">\n",
+	      ifx, ify);
+    svg_stop(&xb, "0", obj->fillcolor);
+    svg_stop(&xb, "1", obj->stopcolor);
+    id = svg_gradient(job, &xb, 'r', &rgradId);
+    agxbfree(&xb);
     return id;
 }
 
 
+/* svg_relative:
+ * -Tsvg_compact: return the n points of A relative to the first, so that
+ * shapes differing only in position share a definition.
+ */
+static pointf *svg_relative(pointf * A, int n)
+{
+    pointf *R = N_NEW(n, pointf);
+    int i;
+
+    for (i = 0; i < n; i++) {
+	R[i].x = A[i].x - A[0].x;
+	R[i].y = A[i].y - A[0].y;
+    }
+    return R;
+}
+
+/* svg_fill:
+ * Write the gradient a shape is filled with, if any, returning its id.
+ */
+static int svg_fill(GVJ_t * job, pointf * A, int n, int filled)
+{
+    if (filled == GRADIENT)
+	return svg_gradstyle(job, A, n);
+    if (filled == RGRADIENT)
+	return svg_rgradstyle(job);
+    return 0;
+}
+
 static void svg_ellipse(GVJ_t * job, pointf * A, int filled)
 {
-    int gid = 0;
+    int gid;
 
     /* A[] contains 2 points: the center and corner. */
-    if (filled == GRADIENT) {
-	gid = svg_gradstyle(job, A, 2);
-    } else if (filled == (RGRADIENT)) {
-	gid = svg_rgradstyle(job);
+    if (COMPACT(job)) {
+	pointf *R = svg_relative(A, 2);
+	int cls;
+	agxbuf shape;
+
+	gid = svg_fill(job, R, 2, filled);
+	cls = svg_grclass(job, filled, gid);
+	agxbinit(&shape, 0, NULL);
+	agxbput(&shape, "ellipse rx=\"");
+	svg_xbdouble(&shape, R[1].x);
+	agxbput(&shape, "\" ry=\"");
+	svg_xbdouble(&shape, R[1].y);
+	agxbputc(&shape, '"');
+	svg_use(job, &shape, A[0], cls);
+	agxbfree(&shape);
+	free(R);
+	return;
     }
+    gid = svg_fill(job, A, 2, filled);
     GVPUTS(job, "<ellipse");
-    svg_grstyle(job, filled, gid);
+    svg_grstyle(job, NULL, filled, gid);
     GVPUTS(job, " cx=\"");
     gvprintdouble(job, A[0].x);
     GVPUTS(job, "\" cy=\"");
@@ -607,21 +929,51 @@ svg_bezier(GVJ_t * job, pointf * A, int n, int arrow_at_start,
     (void)arrow_at_start;
     (void)arrow_at_end;
 
-    int gid = 0;
+    int gid, cls;
     obj_state_t *obj = job->obj;
-  
-    if (filled == GRADIENT) {
-	gid = svg_gradstyle(job, A, n);
-    } else if (filled == (RGRADIENT)) {
-	gid = svg_rgradstyle(job);
+
+    /* edge splines are rarely repeated and may be named for textPath, so
+     * only the outlines of nodes and clusters are shared */
+    if (COMPACT(job) && obj->type != EDGE_OBJTYPE && !obj->labeledgealigned) {
+	pointf *R = svg_relative(A, n);
+	agxbuf shape;
+	int i;
+
+	gid = svg_fill(job, R, n, filled);
+	cls = svg_grclass(job, filled, gid);
+	agxbinit(&shape, 0, NULL);
+	agxbput(&shape, "path d=\"");
+	for (i = 0; i < n; i++) {
+	    agxbputc(&shape, i == 0 ? 'M' : i == 1 ? 'C' : ' ');
+	    svg_xbdouble(&shape, R[i].x);
+	    agxbputc(&shape, ',');
+	    svg_xbdouble(&shape, -R[i].y);
+	}
+	agxbputc(&shape, '"');
+	svg_use(job, &shape, A[0], cls);
+	agxbfree(&shape);
+	free(R);
+	return;
+    }
+    gid = svg_fill(job, A, n, filled);
+    if (COMPACT(job)) {
+	cls = svg_grclass(job, filled, gid);
+	GVPUTS(job, "<path");
+	if (obj->labeledgealigned) {
+	    GVPUTS(job, " id=\"");
+	    gvputs(job, xml_string(obj->id));
+	    GVPUTS(job, "_p\"");
+	}
+	gvprintf(job, " class=\"s_%d\"", cls);
+    } else {
+	GVPUTS(job, "<path");
+	if (obj->labeledgealigned) {
+	    GVPUTS(job, " id=\"");
+	    gvputs(job, xml_string(obj->id));
+	    GVPUTS(job, "_p\" ");
+	}
+	svg_grstyle(job, NULL, filled, gid);
     }
-    GVPUTS(job, "<path");
-    if (obj->labeledgealigned) {
-	GVPUTS(job, " id=\"");
-	gvputs(job, xml_string(obj->id));
-	GVPUTS(job, "_p\" ");
-    } 
-    svg_grstyle(job, filled, gid);
     GVPUTS(job, " d=\"");
     svg_bzptarray(job, A, n);
     GVPUTS(job, "\"/>\n");
@@ -629,14 +981,32 @@ svg_bezier(GVJ_t * job, pointf * A, int n, int arrow_at_start,
 
 static void svg_polygon(GVJ_t * job, pointf * A, int n, int filled)
 {
-    int i, gid = 0;
-    if (filled == GRADIENT) {
-	gid = svg_gradstyle(job, A, n);
-    } else if (filled == (RGRADIENT)) {
-	gid = svg_rgradstyle(job);
+    int i, gid;
+
+    if (COMPACT(job)) {
+	pointf *R = svg_relative(A, n);
+	agxbuf shape;
+	int cls;
+
+	gid = svg_fill(job, R, n, filled);
+	cls = svg_grclass(job, filled, gid);
+	agxbinit(&shape, 0, NULL);
+	agxbput(&shape, "polygon points=\"");
+	for (i = 0; i < n; i++) {
+	    svg_xbdouble(&shape, R[i].x);
+	    agxbputc(&shape, ',');
+	    svg_xbdouble(&shape, -R[i].y);
+	    agxbputc(&shape, ' ');
+	}
+	agxbput(&shape, "0,0\"");
+	svg_use(job, &shape, A[0], cls);
+	agxbfree(&shape);
+	free(R);
+	return;
     }
+    gid = svg_fill(job, A, n, filled);
     GVPUTS(job, "<polygon");
-    svg_grstyle(job, filled, gid);
+    svg_grstyle(job, NULL, filled, gid);
     GVPUTS(job, " points=\"");
     for (i = 0; i < n; i++) {
         gvprintdouble(job, A[i].x);
@@ -655,8 +1025,13 @@ static void svg_polyline(GVJ_t * job, pointf * A, int n)
 {
     int i;
 
-    GVPUTS(job, "<polyline");
-    svg_grstyle(job, 0, 0);
+    if (COMPACT(job)) {
+	int cls = svg_grclass(job, 0, 0);
+	gvprintf(job, "<polyline class=\"s_%d\"", cls);
+    } else {
+	GVPUTS(job, "<polyline");
+	svg_grstyle(job, NULL, 0, 0);
+    }
     GVPUTS(job, " points=\"");
     for (i = 0; i < n; i++) {
         gvprintdouble(job, A[i].x);
@@ -769,6 +1144,7 @@ gvdevice_features_t device_features_svgz = {
 
 gvplugin_installed_t gvrender_svg_types[] = {
     {FORMAT_SVG, "svg", 1, &svg_engine, &render_features_svg},
+    {FORMAT_SVG_COMPACT, "svg_compact", 1, &svg_engine, &render_features_svg},
     {0, NULL, 0, NULL, NULL}
 };
 
@@ -776,6 +1152,10 @@ gvplugin_installed_t gvdevice_svg_types[] = {
     {FORMAT_SVG, "svg:svg", 1, NULL, &device_features_svg},
 #if HAVE_LIBZ
     {FORMAT_SVGZ, "svgz:svg", 1, NULL, &device_features_svgz},
+#endif
+    {FORMAT_SVG_COMPACT, "svg_compact:svg_compact", 1, NULL, &device_features_svg},
+#if HAVE_LIBZ
+    {FORMAT_SVGZ_COMPACT, "svgz_compact:svg_compact", 1, NULL, &device_features_svgz},
 #endif
     {0, NULL, 0, NULL, NULL}
 };
@@ -17,6 +17,7 @@
 
 #include <gvc/gvplugin_render.h>
 #include <gvc/gvplugin_device.h>
+#include <gvc/gvplugin_textlayout.h>
 #include <gvc/gvio.h>
 #include <gvc/gvcint.h>
 #include <cgraph/agxbuf.h>
@@ -328,6 +329,13 @@ static void lasi_textspan(GVJ_t * job, pointf p, textspan_t * span)
     if (job->obj->pencolor.u.HSVA[3] < .5)
 	return;  /* skip transparent text */
 
+    /* spans whose size came from the text measurement cache have no layout */
+    if (!span->layout) {
+	gvtextlayout_engine_t *gvte = job->gvc->textlayout.engine;
+	if (gvte && gvte->textlayout)
+	    gvte->textlayout(span, NULL);
+    }
+
     if (span->layout) {
 	pango_font = pango_layout_get_font_description((PangoLayout*)(span->layout));
 	font = pango_font_description_get_family(pango_font);
@@ -361,8 +369,7 @@ static void lasi_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	    case PANGO_WEIGHT_HEAVY: weight = HEAVY; break;
 	}
     }
-    else {
-	pA = span->font->postscript_alias;
+    else if ((pA = span->font->postscript_alias)) {
 	font = pA->svg_font_family;
 	stretch = NORMAL_STRETCH;
 	if (pA->svg_font_style
@@ -377,6 +384,13 @@ static void lasi_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	else
 	    weight = NORMAL_WEIGHT;
     }
+    else {
+	font = span->font->name;
+	stretch = NORMAL_STRETCH;
+	style = NORMAL_STYLE;
+	variant = NORMAL_VARIANT;
+	weight = NORMAL_WEIGHT;
+    }
 
     ps_set_color(job, &(job->obj->pencolor));
     Context *ctxt = reinterpret_cast<Context*>(job->context);
@@ -1 +1,5 @@
 #define FONT_DPI 96.
+
+#include <gvc/gvplugin_textlayout.h>
+
+extern boolean pango_textlayout(textspan_t * span, char **fontpath);
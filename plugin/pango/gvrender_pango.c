@@ -275,6 +275,10 @@ static void cairogen_textspan(GVJ_t * job, pointf p, textspan_t * span)
     }
     p.y += span->yoffset_centerline + span->yoffset_layout;
 
+    /* spans whose size came from the text measurement cache have no layout */
+    if (!span->layout && !pango_textlayout(span, NULL))
+	return;
+
     cairo_move_to (cr, p.x, -p.y);
     cairo_save(cr);
     cairo_scale(cr, POINTS_PER_INCH / FONT_DPI, POINTS_PER_INCH / FONT_DPI);
@@ -19,6 +19,7 @@
 
 #include <pango/pangocairo.h>
 #include "gvgetfontlist.h"
+#include "gvplugin_pango.h"
 #ifdef HAVE_PANGO_FC_FONT_LOCK_FACE
 #include <pango/pangofc-font.h>
 #endif
@@ -48,8 +49,6 @@ static char* pango_psfontResolve (PostscriptAlias* pa)
     return buf;
 }
 
-#define FONT_DPI 96.
-
 #define ENABLE_PANGO_MARKUP
 #ifdef ENABLE_PANGO_MARKUP
 #define FULL_MARKUP "<span weight=\"bold\" style=\"italic\" underline=\"single\"><sup><sub></sub></sup></span>"
@@ -65,7 +64,8 @@ static char *xstrdup(const char *str) {
   return s;
 }
 
-static boolean pango_textlayout(textspan_t * span, char **fontpath)
+/* also used by the cairo renderer for spans measured without a layout */
+boolean pango_textlayout(textspan_t * span, char **fontpath)
 {
     static char buf[1024];  /* returned in fontpath, only good until next call */
     static PangoFontMap *fontmap;
@@ -0,0 +1,56 @@
+// agxgetdouble and agxgetlong should agree with strtod and strtol
+
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int check(void *obj, Agsym_t *sym) {
+  const char *s = agxget(obj, sym);
+  char *endp;
+  int rc = EXIT_SUCCESS;
+
+  // twice each, and alternating, so that cached results are compared too
+  for (int i = 0; i < 2; ++i) {
+    double d;
+    double ed = strtod(s, &endp);
+    int dok = agxgetdouble(obj, sym, &d) == 0;
+    if (dok != (endp != s) || (dok && d != ed)) {
+      fprintf(stderr, "agxgetdouble(\"%s\") disagrees with strtod\n", s);
+      rc = EXIT_FAILURE;
+    }
+
+    long l;
+    long el = strtol(s, &endp, 10);
+    int lok = agxgetlong(obj, sym, &l) == 0;
+    if (lok != (endp != s) || (lok && l != el)) {
+      fprintf(stderr, "agxgetlong(\"%s\") disagrees with strtol\n", s);
+      rc = EXIT_FAILURE;
+    }
+  }
+  return rc;
+}
+
+int main(void) {
+
+  const char *values[] = {"", "1", "-2.5", "1e3", " 7", "x", "3,4", "0x10"};
+  const size_t n = sizeof(values) / sizeof(values[0]);
+
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agsym_t *sym = agattr(g, AGNODE, "width", "0.75");
+  int rc = EXIT_SUCCESS;
+
+  for (size_t i = 0; i < n; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%zu", i);
+    Agnode_t *node = agnode(g, name, 1);
+    // the default first, shared by every node, then a value of its own
+    if (check(node, sym) != EXIT_SUCCESS)
+      rc = EXIT_FAILURE;
+    agxset(node, sym, values[i]);
+    if (check(node, sym) != EXIT_SUCCESS)
+      rc = EXIT_FAILURE;
+  }
+
+  agclose(g);
+  return rc;
+}
@@ -0,0 +1,42 @@
+// setting an attribute to its own value should keep the value intact
+
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(void) {
+
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agnode_t *n = agnode(g, "n", 1);
+
+  // declare attributes one by one, so the node's values have to grow
+  char name[32];
+  for (int i = 0; i < 100; ++i) {
+    snprintf(name, sizeof(name), "a%d", i);
+    agattr(g, AGNODE, name, "default");
+  }
+
+  // a value held by no other object, reassigned to itself
+  Agsym_t *sym = agattr(g, AGNODE, "a42", NULL);
+  agxset(n, sym, "unique to n");
+  agxset(n, sym, agxget(n, sym));
+  if (strcmp(agxget(n, sym), "unique to n") != 0) {
+    fprintf(stderr, "value lost: \"%s\"\n", agxget(n, sym));
+    return EXIT_FAILURE;
+  }
+
+  // a node created after the declarations sees every default
+  Agnode_t *m = agnode(g, "m", 1);
+  for (sym = agnxtattr(g, AGNODE, NULL); sym != NULL;
+       sym = agnxtattr(g, AGNODE, sym)) {
+    if (strcmp(agxget(m, sym), "default") != 0) {
+      fprintf(stderr, "%s: expected default, got \"%s\"\n", sym->name,
+              agxget(m, sym));
+      return EXIT_FAILURE;
+    }
+  }
+
+  agclose(g);
+  return EXIT_SUCCESS;
+}
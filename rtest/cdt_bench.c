@@ -0,0 +1,205 @@
+// times the Cdt set methods on the dictionary work Cgraph does for a graph:
+// interning its names and attribute values, as refstr does, and mapping the
+// ids of its nodes and edges, as the id dictionaries of a graph do
+//
+// usage: cdt_bench graph.gv [repeats]
+
+#include <graphviz/cdt.h>
+#include <graphviz/cgraph.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+  Dtlink_t link;
+  IDTYPE id;
+  char *name;
+} item_t;
+
+static int cmpid(Dt_t *d, void *a, void *b, Dtdisc_t *disc) {
+  (void)d;
+  (void)disc;
+  IDTYPE x = *(IDTYPE *)a, y = *(IDTYPE *)b;
+  return x < y ? -1 : x > y;
+}
+
+// integer keys, like the id dictionaries of a graph
+static Dtdisc_t Iddisc = {offsetof(item_t, id), sizeof(IDTYPE),
+                          offsetof(item_t, link), NULL, NULL, cmpid,
+                          NULL, NULL, NULL};
+
+// string keys, like refstr interning
+static Dtdisc_t Strdisc = {offsetof(item_t, name), -1, offsetof(item_t, link),
+                           NULL, NULL, NULL, NULL, NULL, NULL};
+
+/* what the graph asks of its dictionaries */
+
+static char **strs;     // strings, in the order they are interned
+static size_t nstrs;
+static item_t *nodes;   // nodes, in creation order
+static size_t nnodes;
+static item_t *edges;   // edges, in creation order
+static IDTYPE *ends;    // the tail and head id of each edge
+static size_t nedges;
+
+static void *alloc(size_t n, size_t size) {
+  void *p = calloc(n ? n : 1, size);
+  if (p == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  return p;
+}
+
+// record an object's attribute values, or count them if strs is NULL
+static void values(void *obj, int kind, size_t *n) {
+  for (Agsym_t *sym = agnxtattr(agroot(obj), kind, NULL); sym != NULL;
+       sym = agnxtattr(agroot(obj), kind, sym)) {
+    if (strs != NULL)
+      strs[*n] = agxget(obj, sym);
+    ++*n;
+  }
+}
+
+static void record(Agraph_t *g) {
+  size_t n = 0;
+
+  for (int pass = 0; pass < 2; ++pass) {
+    n = nnodes = nedges = 0;
+    for (Agnode_t *v = agfstnode(g); v != NULL; v = agnxtnode(g, v)) {
+      if (strs != NULL) {
+        strs[n] = agnameof(v);
+        nodes[nnodes].id = AGID(v);
+      }
+      ++n;
+      ++nnodes;
+      values(v, AGNODE, &n);
+      for (Agedge_t *e = agfstout(g, v); e != NULL; e = agnxtout(g, e)) {
+        if (strs != NULL) {
+          edges[nedges].id = AGID(e);
+          ends[2 * nedges] = AGID(agtail(e));
+          ends[2 * nedges + 1] = AGID(aghead(e));
+        }
+        ++nedges;
+        values(e, AGEDGE, &n);
+      }
+    }
+    if (strs == NULL) {
+      strs = alloc(n, sizeof(char *));
+      nodes = alloc(nnodes, sizeof(item_t));
+      edges = alloc(nedges, sizeof(item_t));
+      ends = alloc(2 * nedges, sizeof(IDTYPE));
+    }
+  }
+  nstrs = n;
+}
+
+/* timing */
+
+static double seconds(clock_t start) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// intern every string, looking it up first as agstrdup does, and return
+// the number of distinct strings
+static size_t intern(Dtmethod_t *meth, item_t *pool) {
+  Dt_t *dt = dtopen(&Strdisc, meth);
+  size_t distinct = 0;
+  for (size_t i = 0; i < nstrs; ++i) {
+    item_t key = {.name = strs[i]};
+    if (dtsearch(dt, &key) == NULL) {
+      pool[distinct].name = strs[i];
+      dtinsert(dt, &pool[distinct++]);
+    }
+  }
+  dtclose(dt);
+  return distinct;
+}
+
+// map node and edge ids, find the ends of each edge by id as the parser
+// does, then walk the nodes and edges in id order; return the number of
+// objects found
+static size_t ids(Dtmethod_t *meth) {
+  Dt_t *n_id = dtopen(&Iddisc, meth);
+  Dt_t *e_id = dtopen(&Iddisc, meth);
+  size_t found = 0;
+  for (size_t i = 0; i < nnodes; ++i)
+    dtinsert(n_id, &nodes[i]);
+  for (size_t i = 0; i < nedges; ++i) {
+    found += dtmatch(n_id, &ends[2 * i]) != NULL;
+    found += dtmatch(n_id, &ends[2 * i + 1]) != NULL;
+    if (dtmatch(e_id, &edges[i].id) == NULL)
+      dtinsert(e_id, &edges[i]);
+  }
+  for (void *o = dtfirst(n_id); o != NULL; o = dtnext(n_id, o))
+    ++found;
+  for (void *o = dtfirst(e_id); o != NULL; o = dtnext(e_id, o))
+    ++found;
+  dtclose(n_id);
+  dtclose(e_id);
+  return found;
+}
+
+int main(int argc, char **argv) {
+
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s graph.gv [repeats]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  int repeats = argc > 2 ? atoi(argv[2]) : 20;
+
+  FILE *f = fopen(argv[1], "r");
+  if (f == NULL) {
+    fprintf(stderr, "failed to open %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  Agraph_t *g = agread(f, NULL);
+  fclose(f);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  record(g);
+  printf("%s: %zu strings, %zu nodes, %zu edges, %d repeats\n", argv[1],
+         nstrs, nnodes, nedges, repeats);
+
+  struct {
+    const char *name;
+    Dtmethod_t *meth;
+  } all[] = {{"Dtset", Dtset}, {"Dtohash", Dtohash},
+             {"Dtoset", Dtoset}, {"Dtbtree", Dtbtree}};
+  item_t *pool = alloc(nstrs, sizeof(item_t));
+  size_t distinct = 0, found = 0;
+  printf("%-8s %8s %8s\n", "method", "intern", "ids");
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i) {
+    size_t d = 0, n = 0;
+    clock_t start = clock();
+    for (int k = 0; k < repeats; ++k)
+      d = intern(all[i].meth, pool);
+    double a = seconds(start);
+    start = clock();
+    for (int k = 0; k < repeats; ++k)
+      n = ids(all[i].meth);
+    double b = seconds(start);
+
+    // every method should have seen the same objects
+    if (i == 0) {
+      distinct = d;
+      found = n;
+    } else if (d != distinct || n != found) {
+      fprintf(stderr, "%s found %zu strings and %zu ids, %s %zu and %zu\n",
+              all[i].name, d, n, all[0].name, distinct, found);
+      return EXIT_FAILURE;
+    }
+    printf("%-8s %8.3f %8.3f\n", all[i].name, a, b);
+  }
+
+  free(pool);
+  free(strs);
+  free(nodes);
+  free(edges);
+  free(ends);
+  agclose(g);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+// the open addressing hash and B-tree methods should hold the same objects
+// as Dtset and Dtoset through any mix of operations
+
+#include <graphviz/cdt.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 4000
+
+typedef struct {
+  Dtlink_t link;
+  int id;
+} item_t;
+
+static int cmpid(Dt_t *d, void *a, void *b, Dtdisc_t *disc) {
+  (void)d;
+  (void)disc;
+  int x = *(int *)a, y = *(int *)b;
+  return x < y ? -1 : x > y;
+}
+
+static int freed;
+
+static void freeitem(Dt_t *d, void *obj, Dtdisc_t *disc) {
+  (void)d;
+  (void)disc;
+  (void)obj;
+  ++freed;
+}
+
+// integer keys, like the id maps in cgraph
+static Dtdisc_t Iddisc = {offsetof(item_t, id), sizeof(int),
+                          offsetof(item_t, link), NULL, NULL, cmpid,
+                          NULL, NULL, NULL};
+
+// the same, with the dictionary allocating its own links
+static Dtdisc_t Holddisc = {offsetof(item_t, id), sizeof(int), -1,
+                            NULL, freeitem, cmpid, NULL, NULL, NULL};
+
+static unsigned long long state = 88172645463325252ULL;
+
+static int rnd(int n) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (int)(state % (unsigned long long)n);
+}
+
+static item_t items[N];
+static int present[N];
+
+#define FAIL(...)                                                              \
+  do {                                                                         \
+    fprintf(stderr, __VA_ARGS__);                                              \
+    fprintf(stderr, " (%s:%d)\n", __FILE__, __LINE__);                         \
+    return -1;                                                                 \
+  } while (0)
+
+// compare the dictionary against the objects it should hold
+static int verify(Dt_t *dt, int ordered) {
+  int count = 0, want = 0;
+  item_t *prev = NULL;
+
+  for (int i = 0; i < N; ++i)
+    want += present[i];
+  if (dtsize(dt) != want)
+    FAIL("dtsize %d, expected %d", dtsize(dt), want);
+
+  for (item_t *it = dtfirst(dt); it != NULL; it = dtnext(dt, it)) {
+    if (!present[it - items])
+      FAIL("walk found absent %d", it->id);
+    if (ordered && prev != NULL && prev->id >= it->id)
+      FAIL("walk out of order at %d after %d", it->id, prev->id);
+    prev = it;
+    ++count;
+  }
+  if (count != want)
+    FAIL("walked %d objects, expected %d", count, want);
+
+  if (ordered) {
+    count = 0;
+    prev = NULL;
+    for (item_t *it = dtlast(dt); it != NULL; it = dtprev(dt, it)) {
+      if (prev != NULL && prev->id <= it->id)
+        FAIL("backward walk out of order at %d", it->id);
+      prev = it;
+      ++count;
+    }
+    if (count != want)
+      FAIL("walked back over %d objects, expected %d", count, want);
+  }
+
+  for (int i = 0; i < N; ++i) {
+    item_t key = {.id = items[i].id};
+    item_t *found = dtsearch(dt, &key);
+    if (found != (present[i] ? &items[i] : NULL))
+      FAIL("search for %d found %p", items[i].id, (void *)found);
+    if (dtmatch(dt, &items[i].id) != found)
+      FAIL("match for %d differs from search", items[i].id);
+  }
+  return 0;
+}
+
+// the least object not before item i, by a linear scan
+static item_t *least(int i) {
+  item_t *best = NULL;
+  for (int j = 0; j < N; ++j)
+    if (present[j] && items[j].id >= items[i].id &&
+        (best == NULL || items[j].id < best->id))
+      best = &items[j];
+  return best;
+}
+
+// random operations on a dictionary, checked as they go
+static int exercise(Dtdisc_t *disc, Dtmethod_t *meth) {
+  int ordered = meth == Dtbtree;
+  Dt_t *dt = dtopen(disc, meth);
+  if (dt == NULL)
+    FAIL("dtopen failed");
+
+  // ids spaced apart, so there are keys between them
+  memset(present, 0, sizeof(present));
+  for (int i = 0; i < N; ++i)
+    items[i].id = 2 * i;
+
+  for (int round = 0; round < 20; ++round) {
+    for (int op = 0; op < N; ++op) {
+      int i = rnd(N);
+      switch (rnd(4)) {
+      case 0:
+      case 1:
+        if (dtinsert(dt, &items[i]) != &items[i])
+          FAIL("insert of %d failed", items[i].id);
+        present[i] = 1;
+        break;
+      case 2:
+        if (dtdelete(dt, &items[i]) != (present[i] ? &items[i] : NULL))
+          FAIL("delete of %d", items[i].id);
+        present[i] = 0;
+        break;
+      default: {
+        // look for an object's key, or for the unused key just before it
+        item_t key = {.id = items[i].id - rnd(2)};
+        item_t *got, *want;
+        if (ordered) {
+          got = dtleast(dt, &key);
+          want = least(i);
+        } else {
+          got = dtsearch(dt, &key);
+          want = key.id == items[i].id && present[i] ? &items[i] : NULL;
+        }
+        if (got != want)
+          FAIL("dtleast(%d) gave %d, expected %d", key.id,
+               got ? got->id : -1, want ? want->id : -1);
+        break;
+      }
+      }
+    }
+
+    // delete from the finger while walking
+    for (item_t *it = dtfirst(dt), *next; it != NULL; it = next) {
+      next = dtnext(dt, it);
+      if (rnd(3) == 0) {
+        dtdelete(dt, it);
+        present[it - items] = 0;
+      }
+    }
+    if (verify(dt, ordered))
+      return -1;
+
+    // move an object to an unused key
+    for (int i = 0; i < N; ++i) {
+      if (!present[i] || rnd(50) != 0)
+        continue;
+      if (dtsearch(dt, &items[i]) != &items[i])
+        FAIL("search before renew failed");
+      items[i].id = 2 * N + 2 * i + round * 4 * N;
+      if (dtrenew(dt, &items[i]) != &items[i])
+        FAIL("renew failed");
+    }
+    if (verify(dt, ordered))
+      return -1;
+
+    // take the objects out and put them back
+    Dtlink_t *list = dtextract(dt);
+    if (dtsize(dt) != 0)
+      FAIL("dictionary not empty after dtextract");
+    if (dtrestore(dt, list) != 0)
+      FAIL("dtrestore failed");
+    if (verify(dt, ordered))
+      return -1;
+
+    // round trip through the other methods
+    if (round % 4 == 1) {
+      Dtmethod_t *others[] = {Dtset, Dtoset, Dtlist, Dtohash, Dtbtree, meth};
+      for (size_t j = 0; j < sizeof(others) / sizeof(others[0]); ++j) {
+        dtmethod(dt, others[j]);
+        if (others[j] != Dtlist &&
+            verify(dt, others[j] == Dtoset || others[j] == Dtbtree))
+          return -1;
+      }
+    }
+  }
+
+  freed = 0;
+  int size = dtsize(dt);
+  dtclear(dt);
+  if (dtsize(dt) != 0 || dtfirst(dt) != NULL)
+    FAIL("dictionary not empty after dtclear");
+  if (disc->freef != NULL && freed != size)
+    FAIL("dtclear freed %d of %d objects", freed, size);
+  for (int i = 0; i < N; ++i) {
+    items[i].id = 2 * i;
+    dtinsert(dt, &items[i]);
+    present[i] = 1;
+  }
+  if (verify(dt, ordered))
+    return -1;
+  return dtclose(dt);
+}
+
+int main(void) {
+
+  Dtmethod_t *meths[] = {Dtohash, Dtbtree};
+  Dtdisc_t *discs[] = {&Iddisc, &Holddisc};
+  for (size_t i = 0; i < sizeof(meths) / sizeof(meths[0]); ++i)
+    for (size_t j = 0; j < sizeof(discs) / sizeof(discs[0]); ++j)
+      if (exercise(discs[j], meths[i]) != 0) {
+        fprintf(stderr, "failed with method %zu, discipline %zu\n", i, j);
+        return EXIT_FAILURE;
+      }
+
+  return EXIT_SUCCESS;
+}
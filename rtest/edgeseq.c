@@ -0,0 +1,135 @@
+// edges of a node should be traversed in the order of the other endpoint's
+// creation, then their own, however they were added and removed, both with
+// agfstout/agnxtout and with the flat edge references
+
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 200
+
+static int check(Agraph_t *g, Agnode_t *n) {
+  int count = 0;
+  Agedge_t *prev = NULL;
+  for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+    if (prev != NULL) {
+      unsigned long long ps = AGSEQ(aghead(prev)), s = AGSEQ(aghead(e));
+      if (ps > s || (ps == s && AGSEQ(prev) >= AGSEQ(e))) {
+        fprintf(stderr, "%s: out-edges out of order\n", agnameof(n));
+        return -1;
+      }
+    }
+    prev = e;
+    ++count;
+  }
+  if (count != agdegree(g, n, 0, 1)) {
+    fprintf(stderr, "%s: %d out-edges, degree %d\n", agnameof(n), count,
+            agdegree(g, n, 0, 1));
+    return -1;
+  }
+  return count;
+}
+
+// the flat edge references should walk the same edges in the same order
+static int check_refs(Agraph_t *g, Agnode_t *n) {
+  Agsubnode_t *sn = agsubrep(g, n);
+  Agedge_t *e = agfstout(g, n);
+  Agedgeref_t *r;
+  for (r = FIRSTOUTREF(g, sn); r != NULL; r = NEXTEREF(g, r)) {
+    if (EDGEOF(sn, r) != e) {
+      fprintf(stderr, "%s: out-edge references differ\n", agnameof(n));
+      return -1;
+    }
+    e = agnxtout(g, e);
+  }
+  if (e != NULL) {
+    fprintf(stderr, "%s: out-edge references end early\n", agnameof(n));
+    return -1;
+  }
+  int count = 0;
+  for (r = LASTOUTREF(g, sn); r != NULL; r = PREVEREF(g, r))
+    ++count;
+  if (count != agdegree(g, n, 0, 1)) {
+    fprintf(stderr, "%s: %d out-edge references backwards, degree %d\n",
+            agnameof(n), count, agdegree(g, n, 0, 1));
+    return -1;
+  }
+  e = agfstin(g, n);
+  for (r = FIRSTINREF(g, sn); r != NULL; r = NEXTEREF(g, r)) {
+    if (EDGEOF(sn, r) != e) {
+      fprintf(stderr, "%s: in-edge references differ\n", agnameof(n));
+      return -1;
+    }
+    e = agnxtin(g, e);
+  }
+  if (e != NULL) {
+    fprintf(stderr, "%s: in-edge references end early\n", agnameof(n));
+    return -1;
+  }
+  return 0;
+}
+
+int main(void) {
+
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agraph_t *sg = agsubg(g, "sg", 1);
+  Agnode_t *nodes[N];
+  char name[32];
+  for (int i = 0; i < N; ++i) {
+    snprintf(name, sizeof(name), "n%d", i);
+    nodes[i] = agnode(g, name, 1);
+  }
+
+  // edges from a hub in a scrambled order, traversing as we go
+  Agnode_t *hub = nodes[0];
+  int expected = 0;
+  for (int i = 0; i < 3 * N; ++i) {
+    Agnode_t *head = nodes[(i * 7919) % N];
+    Agedge_t *e = agedge(g, hub, head, NULL, 1);
+    ++expected;
+    if (i % 3 == 0)
+      agsubedge(sg, e, 1);
+    if (i % 17 == 0 && check(g, hub) != expected)
+      return EXIT_FAILURE;
+  }
+
+  // remove every third edge while traversing
+  int i = 0;
+  for (Agedge_t *e = agfstout(g, hub), *f; e != NULL; e = f) {
+    f = agnxtout(g, e);
+    if (i++ % 3 == 0) {
+      agdeledge(g, e);
+      --expected;
+    }
+  }
+  if (check(g, hub) != expected)
+    return EXIT_FAILURE;
+  if (check(sg, agsubnode(sg, hub, 0)) < 0)
+    return EXIT_FAILURE;
+  if (check_refs(g, hub) != 0 || check_refs(sg, agsubnode(sg, hub, 0)) != 0)
+    return EXIT_FAILURE;
+  for (int j = 0; j < N; ++j)
+    if (check_refs(g, nodes[j]) != 0)
+      return EXIT_FAILURE;
+
+  // every edge should be reachable from its head as well
+  for (int j = 0; j < N; ++j) {
+    int in = 0;
+    for (Agedge_t *e = agfstin(g, nodes[j]); e != NULL; e = agnxtin(g, e))
+      ++in;
+    if (in != agdegree(g, nodes[j], 1, 0)) {
+      fprintf(stderr, "%s: %d in-edges, degree %d\n", agnameof(nodes[j]), in,
+              agdegree(g, nodes[j], 1, 0));
+      return EXIT_FAILURE;
+    }
+  }
+
+  agdelnode(g, hub);
+  if (agnedges(g) != 0 || agnedges(sg) != 0) {
+    fprintf(stderr, "edges left after deleting the hub\n");
+    return EXIT_FAILURE;
+  }
+
+  agclose(g);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+"""test ../lib/cgraph/dtos.h"""
+
+import os
+from pathlib import Path
+import platform
+import sys
+
+sys.path.append(os.path.dirname(__file__))
+from gvtest import run_c # pylint: disable=wrong-import-position
+
+def test_dtos():
+  """run the dtos unit tests"""
+
+  # locate the dtos unit tests
+  src = Path(__file__).parent.resolve() / "../lib/cgraph/test_dtos.c"
+  assert src.exists()
+
+  # locate lib directory that needs to be in the include path
+  lib = Path(__file__).parent.resolve() / "../lib"
+
+  # extra C flags this compilation needs
+  cflags = ['-I', lib]
+
+  # the math library is separate from libc on Unix
+  link = [] if platform.system() == "Windows" else ["m"]
+
+  ret, _, _ = run_c(src, cflags=cflags, link=link)
+
+  assert ret == 0
@@ -0,0 +1,34 @@
+"""test ../lib/common/fontmetrics.c"""
+
+import os
+from pathlib import Path
+import platform
+import sys
+import tempfile
+
+sys.path.append(os.path.dirname(__file__))
+from gvtest import run_c #pylint: disable=C0413
+
+def test_fontmetrics():
+  """run the fontmetrics unit tests"""
+
+  # locate the fontmetrics unit tests
+  src = Path(__file__).parent.resolve() / "../lib/common/test_fontmetrics.c"
+  assert src.exists()
+
+  # locate lib directory that needs to be in the include path
+  lib = Path(__file__).parent.resolve() / "../lib"
+
+  # extra C flags this compilation needs
+  cflags = ["-I", lib]
+  link = []
+  if platform.system() != "Windows":
+    cflags += ["-std=gnu99", "-Wall", "-Wextra", "-Werror"]
+    link += ["m"]
+
+  # somewhere for the tests to write font files
+  with tempfile.TemporaryDirectory() as tmp:
+    (Path(tmp) / "empty").mkdir()
+    ret, _, _ = run_c(src, [tmp, "empty"], cflags=cflags, link=link)
+
+  assert ret == 0
@@ -4,6 +4,7 @@ Graphviz miscellaneous test cases
 
 import json
 import subprocess
+import xml.etree.ElementTree as ET
 
 def test_json_node_order():
   """
@@ -71,3 +72,152 @@ def test_json_edge_order():
   edges = [(data["objects"][e["tail"]]["name"],
             data["objects"][e["head"]]["name"]) for e in data["edges"]]
   assert edges == expected
+
+def test_ndjson():
+  """
+  test that -Tndjson streams one JSON object per line, with the draw
+  operations of each node and edge between its begin and end lines
+  """
+
+  input = 'digraph G {\n'                                 \
+          '  subgraph cluster_0 { a; b; }\n'              \
+          '  a -> b [label="x", color=red];\n'            \
+          '  b -> c;\n'                                   \
+          '}'
+
+  output = subprocess.check_output(["dot", "-Tndjson"], input=input,
+    universal_newlines=True)
+
+  lines = [json.loads(l) for l in output.splitlines()]
+
+  assert lines[0]["begin"] == "graph"
+  assert lines[0]["name"] == "G"
+  assert lines[0]["directed"]
+  assert lines[-1] == {"end": "graph"}
+
+  # every object that is begun should also be ended, without nesting
+  objects = []
+  current = None
+  for line in lines[1:-1]:
+    if "begin" in line:
+      assert current is None
+      current = line
+      objects.append((line, []))
+    elif "end" in line:
+      assert current is not None and line["end"] == current["begin"]
+      current = None
+    else:
+      assert "op" in line and "attr" in line
+      if current is not None:
+        objects[-1][1].append(line)
+
+  names = [(o["begin"], o["name"]) for o, _ in objects]
+  assert ("cluster", "cluster_0") in names
+  assert [n for k, n in names if k == "node"] == ["a", "b", "c"]
+
+  edges = [(o, ops) for o, ops in objects if o["begin"] == "edge"]
+  assert [(o["tail"], o["head"]) for o, _ in edges] == [("a", "b"), ("b", "c")]
+
+  # the labelled edge should have its colour once per attribute, a spline,
+  # an arrowhead and its label
+  ops = edges[0][1]
+  assert {"attr": "_draw_", "op": "c", "grad": "none", "color": "#ff0000"} in ops
+  assert any(o["op"] == "b" and o["attr"] == "_draw_" for o in ops)
+  assert any(o["op"] == "P" and o["attr"] == "_hdraw_" for o in ops)
+  assert any(o["op"] == "T" and o["text"] == "x" for o in ops)
+  draw_colors = [o for o in ops if o["attr"] == "_draw_" and o["op"] == "c"]
+  assert len(draw_colors) == 1
+
+def test_paged_output_has_every_node():
+  """
+  when a drawing is split over many pages, every node should be drawn on
+  at least one of them
+  """
+
+  # a grid of nodes, big enough to need several pages
+  nodes = [f"n{i}" for i in range(100)]
+  input = "graph G {\n  page=\"2,2\";\n" \
+        + "".join(f"  {a} -- {b};\n" for a, b in zip(nodes, nodes[10:])) \
+        + "}"
+
+  output = subprocess.check_output(["dot", "-Tps"], input=input,
+    universal_newlines=True)
+
+  assert output.count("%%Page:") > 1
+  comments = set(l[2:] for l in output.splitlines() if l.startswith("% n"))
+  assert comments == set(nodes)
+
+def test_lod():
+  """
+  labels and edge detail below the lod size should be left out
+  """
+
+  input = 'digraph G { a -> b [label="edge"]; }'
+
+  full = subprocess.check_output(["dot", "-Tsvg"], input=input,
+    universal_newlines=True)
+  assert full.count("<text") == 3
+  assert "<polygon fill=\"black\"" in full
+
+  # labels are 14pt and the edge about 50pt long
+  reduced = subprocess.check_output(["dot", "-Tsvg", "-Glod=100"],
+    input=input, universal_newlines=True)
+  assert "<text" not in reduced
+  assert "<polygon fill=\"black\"" not in reduced
+  assert "<polyline" in reduced
+
+def test_repeated_styles():
+  """
+  nodes sharing a style or color should all be drawn with it, and the same
+  color name should resolve differently under different color schemes
+  """
+
+  nodes = "".join(f"  n{i};\n" for i in range(20))
+  input = "digraph G {\n" \
+        + "  node [shape=box, style=\"rounded,filled\", fillcolor=red];\n" \
+        + nodes \
+        + "  a [colorscheme=blues3, fillcolor=1];\n" \
+        + "  b [colorscheme=greens3, fillcolor=1];\n" \
+        + "}"
+
+  output = subprocess.check_output(["dot", "-Tsvg"], input=input,
+    universal_newlines=True)
+
+  assert output.count("<path fill=\"red\"") == 20
+  assert "<path fill=\"#deebf7\"" in output
+  assert "<path fill=\"#e5f5e0\"" in output
+
+def test_svg_compact():
+  """
+  -Tsvg_compact should define repeated shapes and styles once and still
+  draw every node
+  """
+
+  nodes = [f"n{i}" for i in range(50)]
+  input = "digraph G {\n  node [shape=box, style=filled, fillcolor=yellow];\n" \
+        + "".join(f"  {a} -> {b};\n" for a, b in zip(nodes, nodes[1:])) \
+        + "}"
+
+  svg = subprocess.check_output(["dot", "-Tsvg"], input=input,
+    universal_newlines=True)
+  compact = subprocess.check_output(["dot", "-Tsvg_compact"], input=input,
+    universal_newlines=True)
+
+  assert len(compact) < len(svg)
+
+  # the output must be well formed, with every node drawn by reference
+  root = ET.fromstring(compact)
+  ns = {"svg": "http://www.w3.org/2000/svg"}
+  xlink = "{http://www.w3.org/1999/xlink}href"
+  node_groups = [g for g in root.iter("{http://www.w3.org/2000/svg}g")
+                 if g.get("class") == "node"]
+  assert len(node_groups) == len(nodes)
+  for g in node_groups:
+    uses = g.findall("svg:use", ns)
+    assert len(uses) == 1
+    assert uses[0].get(xlink).startswith("#d_")
+
+  # the boxes, and the arrowheads, are all alike
+  refs = {u.get(xlink) for u in root.iter("{http://www.w3.org/2000/svg}use")}
+  assert len(refs) < len(nodes) / 2
+  assert compact.count("<style>") < 10
@@ -16,7 +16,7 @@ import stat
 import subprocess
 import sys
 import tempfile
-from typing import List
+from typing import Iterator, List, Tuple
 import xml.etree.ElementTree as ET
 import pytest
 
@@ -34,6 +34,32 @@ def is_ndebug_defined() -> bool:
 
   return False
 
+def json_layout(engine: str, input: str) -> Tuple[dict, str]:
+  """
+  lay out a graph with the given engine, returning its decoded -Tjson output
+  and what was written to stderr
+  """
+  p = subprocess.Popen([engine, "-Tjson"], stdin=subprocess.PIPE,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                       universal_newlines=True)
+  output, errors = p.communicate(input)
+  assert p.returncode == 0, f"{engine} failed to process graph"
+  return json.loads(output), errors
+
+def node_boxes(data: dict) -> Iterator[Tuple[dict, Tuple[float, float, float,
+                                                          float]]]:
+  """
+  the positioned nodes of a -Tjson layout, each with its bounding box
+  (left, bottom, right, top) in points
+  """
+  for node in data["objects"]:
+    if "pos" not in node:
+      continue
+    x, y = (float(v) for v in node["pos"].split(","))
+    half_w = float(node["width"]) * 72 / 2
+    half_h = float(node["height"]) * 72 / 2
+    yield node, (x - half_w, y - half_h, x + half_w, y + half_h)
+
 # The terminology used in rtest.py is a little inconsistent. At the
 # end it reports the total number of tests, the number of "failures"
 # (crashes) and the number of "changes" (which is the number of tests
@@ -1238,6 +1264,165 @@ def test_user_shapes():
   assert '<image xlink:href="usershape.svg" width="62px" height="44px" ' in \
     output
 
+def test_usershape_reload():
+  """
+  an image file changed between two layouts in the same process should be
+  read again rather than drawn from the cache
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "usershape_reload.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  with tempfile.TemporaryDirectory() as tmp:
+    image = Path(tmp) / "image.svg"
+
+    try:
+      ret, _, err = run_c(c_src, [str(image)], link=["cgraph", "gvc"])
+    except subprocess.CalledProcessError:
+      # FIXME: Remove this try-catch when
+      # https://gitlab.com/graphviz/graphviz/-/issues/1777 is fixed
+      if os.getenv("build_system") == "msbuild":
+        pytest.skip("Windows MSBuild release does not contain any header "
+                    "files (#1777)")
+      raise
+
+  assert ret == 0, err
+
+@pytest.mark.parametrize("input,expected", (
+  # xdot commands covering every kind of operation
+  ("c 9 -#fffffe00 C 7 -#ffffff P 4 0 0 0 36 54 36 54 0 "                  \
+   "e 27 18 27 18 F 14 11 -Times-Roman T 27 13.8 0 19.43 1 -a "             \
+   "S 6 -dashed C 32 -[0 0 10 10 2 0 3 -red 1 4 -blue] "                    \
+   "c 39 -(0 0 1.5 10 10 2 2 0 3 -red 1 5 -green) "                         \
+   "b 4 1 2 3 4 5 6 7 8 L 2 1.25 2.5 3 4 I 1 2 3 4 5 -a.png t 3 "           \
+   "E 1e2 -2.5E-1 0x10 .5 B 4 0 0 1 1 2 2 3 3",
+   "c 9 -#fffffe00 C 7 -#ffffff P 4 0 0 0 36 54 36 54 0"),
+  # a string shorter than its length is an error in both parsers
+  ("F 14 11 -Times-Roman T 27 13.8 0 19.43 9 -ab", "F 14 11 -Times-Roman"),
+))
+def test_xdot_compact_binary(input: str, expected: str):
+  """
+  the compact and binary xdot parsers should agree with `parseXDot`
+  """
+
+  # find our collocated C helper
+  c_src = Path(__file__).parent / "xdot_compact.c"
+
+  # ask our C helper to process this
+  try:
+    ret, output, err = run_c(c_src, input=input, link=["xdot"])
+  except subprocess.CalledProcessError:
+    # FIXME: Remove this try-catch when
+    # https://gitlab.com/graphviz/graphviz/-/issues/1777 is fixed
+    if os.getenv("build_system") == "msbuild":
+      pytest.skip("Windows MSBuild release does not contain any header "
+                  "files (#1777)")
+    raise
+  assert ret == 0, err
+  assert err == ""
+  assert output.startswith(expected)
+
+def test_tiles():
+  """
+  gvRenderTiles should write a pyramid of tiles covering the drawing
+  """
+
+  # find our collocated C helper
+  c_src = Path(__file__).parent / "tiles.c"
+
+  # a graph much wider than it is tall
+  nodes = [f"n{i}" for i in range(24)]
+  input = "digraph { " + " ".join(f"root -> {n};" for n in nodes) + " }"
+
+  with tempfile.TemporaryDirectory() as tmp:
+    prefix = Path(tmp) / "tile"
+
+    try:
+      ret, output, err = run_c(c_src, [str(prefix)], input=input,
+                               link=["cgraph", "gvc"])
+    except subprocess.CalledProcessError:
+      # FIXME: Remove this try-catch when
+      # https://gitlab.com/graphviz/graphviz/-/issues/1777 is fixed
+      if os.getenv("build_system") == "msbuild":
+        pytest.skip("Windows MSBuild release does not contain any header "
+                    "files (#1777)")
+      raise
+    assert ret == 0, err
+
+    # only the top row of each level overlaps the drawing
+    tiles = sorted(p.name for p in Path(tmp).iterdir())
+    assert tiles == ["tile_0_0_0.svg", "tile_1_0_0.svg", "tile_1_1_0.svg",
+                     "tile_2_0_0.svg", "tile_2_1_0.svg", "tile_2_2_0.svg",
+                     "tile_2_3_0.svg"]
+    assert output.strip() == str(len(tiles))
+
+    # every node should be in a tile of the deepest level, but no such tile
+    # should have all of them
+    seen = set()
+    for i in range(4):
+      svg = (Path(tmp) / f"tile_2_{i}_0.svg").read_text()
+      assert 'width="256pt" height="256pt"' in svg
+      titles = set(re.findall(r"<title>(n\d+|root)</title>", svg))
+      assert len(titles) < len(nodes) + 1
+      seen |= titles
+    assert seen == set(nodes) | {"root"}
+
+@pytest.mark.parametrize("format", ("svg", "ps", "ps:lasi", "png:cairo",
+                                    "pdf:cairo", "svg:cairo"))
+def test_repeated_labels(format: str):
+  """
+  labels whose size is taken from the text measurement cache should still
+  be drawn by every renderer
+  """
+
+  # many nodes with the same label, in a font with and without a PostScript
+  # equivalent
+  input = "digraph {\n" + \
+          "".join(f'  a{i} [label="repeated", fontname="Times-Roman"];\n'
+                  f'  b{i} [label="repeated", fontname="NoSuchFont"];\n'
+                  for i in range(20)) + \
+          "}"
+
+  p = subprocess.run(["dot", f"-T{format}", "-o", os.devnull], input=input,
+                     stderr=subprocess.PIPE, universal_newlines=True)
+  if "not recognized" in p.stderr:
+    pytest.skip(f"{format} output not available")
+  assert p.returncode == 0, f"dot -T{format} failed: {p.stderr}"
+
+  # every copy of the label should be in the output
+  if format == "svg":
+    svg = subprocess.check_output(["dot", "-Tsvg"], input=input,
+                                  universal_newlines=True)
+    assert svg.count(">repeated</text>") == 40
+
+def test_emit_index_shared():
+  """
+  outputs of one layout that are split into pages should share one spatial
+  index of the nodes and edges when they emit them in the same order
+  """
+
+  # a row of nodes several pages wide
+  input = "digraph { page=\"2,2\"; " + \
+          " ".join(f"root -> n{i};" for i in range(40)) + " }"
+
+  with tempfile.TemporaryDirectory() as tmp:
+    ps = Path(tmp) / "out.ps"
+    ps2 = Path(tmp) / "out.ps2"
+    p = subprocess.run(["dot", "-v", "-Tps", "-o", ps, "-Tps2", "-o", ps2],
+                       input=input, stdout=subprocess.PIPE,
+                       stderr=subprocess.PIPE, universal_newlines=True)
+    assert p.returncode == 0, p.stderr
+
+    # the first output builds the index and the second one reuses it
+    assert p.stderr.count("built the emit index") == 1, p.stderr
+    assert p.stderr.count("reusing the emit index") == 1, p.stderr
+
+    # both outputs have every page
+    pages = ps.read_text().count("%%Page:")
+    assert pages > 1
+    assert ps2.read_text().count("%%Page:") == pages
+
 def test_xdot_json():
   """
   check the output of xdot’s JSON API
@@ -1371,3 +1556,155 @@ def test_gvmap_fclose():
   p.communicate(input.encode("utf-8"))
 
   assert p.returncode == 0
+
+def test_agxset_self():
+  """
+  setting a Cgraph attribute to its own value should not free it
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "agxset_self.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  # run it
+  ret, _, _ = run_c(c_src, link=["cgraph"])
+  assert ret == 0
+
+def test_agxgetnum():
+  """
+  typed attribute lookups should parse values as strtod and strtol do
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "agxgetnum.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  # run it
+  ret, _, _ = run_c(c_src, link=["cgraph"])
+  assert ret == 0
+
+def test_edgeseq():
+  """
+  edge traversal order should not depend on how the edges were added
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "edgeseq.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  # run it
+  ret, _, _ = run_c(c_src, link=["cgraph"])
+  assert ret == 0
+
+def test_cdt_methods():
+  """
+  the open addressing hash and B-tree Cdt methods should behave as the sets
+  they stand in for
+  """
+
+  # find co-located test source
+  c_src = (Path(__file__).parent / "cdt_methods.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  # run it
+  ret, _, _ = run_c(c_src, link=["cdt"])
+  assert ret == 0
+
+@pytest.mark.skipif(os.getenv("GV_BENCHMARK") is None,
+                    reason="benchmarks only run when GV_BENCHMARK is set")
+def test_cdt_bench():
+  """
+  time the Cdt set methods on the dictionary work Cgraph does for a large
+  graph
+  """
+
+  # find co-located benchmark source and graph
+  c_src = (Path(__file__).parent / "cdt_bench.c").resolve()
+  assert c_src.exists(), "missing benchmark"
+  graph = Path(__file__).parent / "graphs/b100.gv"
+  assert graph.exists(), "missing graph"
+
+  # run it, showing the timings
+  ret, stdout, _ = run_c(c_src, [str(graph)], link=["cgraph", "cdt"],
+                         cflags=["-O2"])
+  sys.stdout.write(stdout)
+  assert ret == 0
+
+@pytest.mark.skipif(shutil.which("fdp") is None, reason="fdp not available")
+def test_shared_shape_geometry():
+  """
+  resizing the nodes fdp uses for edges to clusters should not change the
+  geometry of other nodes of the same shape
+  """
+
+  # boxes of the default size, one of them the end of an edge to a cluster
+  input = "graph {\n" \
+          "  node [shape=box, label=\"\"];\n" \
+          "  subgraph cluster_0 { a; b; c; }\n" \
+          "  d -- cluster_0;\n" \
+          "  e;\n" \
+          "}"
+
+  # process this with fdp
+  data, _ = json_layout("fdp", input)
+
+  # every box should be drawn within its own bounds
+  for node, (left, bottom, right, top) in node_boxes(data):
+    polygons = [op for op in node["_draw_"] if op["op"] in ("p", "P")]
+    assert len(polygons) == 1, f"unexpected drawing of node {node['name']}"
+    for px, py in polygons[0]["points"]:
+      assert left - 0.01 <= px <= right + 0.01, \
+        f"node {node['name']} drawn wider than its width"
+      assert bottom - 0.01 <= py <= top + 0.01, \
+        f"node {node['name']} drawn taller than its height"
+
+@pytest.mark.parametrize("packmode", ("node", "graph", "clust"))
+def test_pack_no_overlap(packmode: str):
+  """
+  packing many components should keep their nodes apart
+  """
+
+  # components of a few nodes each, of varied sizes
+  input = "digraph {\n" \
+          f"  pack=4; packmode={packmode};\n"
+  for i in range(60):
+    input += f"  a{i} -> b{i}; b{i} -> c{i};\n"
+    if i % 3 == 0:
+      input += f"  a{i} -> d{i}; d{i} [width={1 + i % 5}];\n"
+  input += "}"
+
+  # lay it out
+  data, _ = json_layout("dot", input)
+
+  # no two nodes should overlap
+  boxes = [(node["name"], *box) for node, box in node_boxes(data)]
+  for i, a in enumerate(boxes):
+    for b in boxes[i + 1:]:
+      assert a[3] <= b[1] or b[3] <= a[1] or a[4] <= b[2] or b[4] <= a[2], \
+        f"nodes {a[0]} and {b[0]} overlap"
+
+def test_xlabels_placed():
+  """
+  exterior labels should all be placed when there is room for them
+  """
+
+  # chains of nodes with a label on each node and edge
+  input = "digraph {\n" \
+          "  forcelabels=false;\n"
+  for i in range(100):
+    input += f"  n{i} [xlabel=x{i}];\n"
+    if i % 10 != 0:
+      input += f"  n{i - 1} -> n{i} [xlabel=e{i}];\n"
+  input += "}"
+
+  # lay it out
+  data, errors = json_layout("dot", input)
+  assert "exterior labels positioned" not in errors, \
+    "some exterior labels were not placed"
+
+  # without forcelabels, a label only gets a position if it overlaps nothing
+  for node in data["objects"]:
+    assert "xlp" in node, f"label of node {node['name']} not placed"
+  assert len(data["edges"]) == 90, "unexpected number of edges"
+  for edge in data["edges"]:
+    assert "xlp" in edge, f"label of edge {edge['_gvid']} not placed"
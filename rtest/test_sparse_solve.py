@@ -0,0 +1,38 @@
+"""test ../lib/sfdpgen/sparse_solve.c"""
+
+import os
+from pathlib import Path
+import platform
+import sys
+import tempfile
+
+sys.path.append(os.path.dirname(__file__))
+from gvtest import run_c #pylint: disable=C0413
+
+def test_sparse_solve():
+  """run the sparse_solve unit tests"""
+
+  # locate the sparse_solve unit tests
+  src = Path(__file__).parent.resolve() / "../lib/sfdpgen/test_sparse_solve.c"
+  assert src.exists()
+
+  # locate lib directory that needs to be in the include path
+  lib = Path(__file__).parent.resolve() / "../lib"
+
+  with tempfile.TemporaryDirectory() as tmp:
+
+    # the sources include config.h, but need nothing from it
+    (Path(tmp) / "config.h").write_text("")
+
+    # extra C flags this compilation needs
+    cflags = ["-I", tmp, "-I", lib]
+    for d in ("common", "cgraph", "cdt", "gvc", "pathplan"):
+      cflags += ["-I", lib / d]
+    link = []
+    if platform.system() != "Windows":
+      cflags += ["-std=gnu99"]
+      link += ["m"]
+
+    ret, _, _ = run_c(src, cflags=cflags, link=link)
+
+  assert ret == 0
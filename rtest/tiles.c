@@ -0,0 +1,40 @@
+// render a graph read from stdin as a pyramid of SVG tiles
+
+#include <graphviz/gvc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s prefix\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  GVC_t *gvc = gvContext();
+  graph_t *g = agread(stdin, NULL);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read graph\n");
+    return EXIT_FAILURE;
+  }
+
+  if (gvLayout(gvc, g, "dot") != 0) {
+    fprintf(stderr, "layout failed\n");
+    return EXIT_FAILURE;
+  }
+
+  int count = gvRenderTiles(gvc, g, "svg", argv[1], 2, 256);
+  printf("%d\n", count);
+
+  // the tiles' viewports should not be left on, or declared in, the graph
+  if (agattr(g, AGRAPH, "viewport", NULL) != NULL) {
+    fprintf(stderr, "gvRenderTiles declared a viewport attribute\n");
+    return EXIT_FAILURE;
+  }
+
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  gvFreeContext(gvc);
+
+  return count < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
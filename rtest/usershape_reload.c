@@ -0,0 +1,69 @@
+// an image file that changes between layouts should be read again
+
+#include <graphviz/gvc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// write an empty SVG image of the given size in points
+static void write_image(const char *path, int width, int height) {
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    fprintf(stderr, "failed to open %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  fprintf(f, "<?xml version=\"1.0\"?>\n"
+             "<svg width=\"%dpt\" height=\"%dpt\" "
+             "xmlns=\"http://www.w3.org/2000/svg\"></svg>\n", width, height);
+  fclose(f);
+}
+
+// lay out a node showing the image and return whether the SVG output draws
+// it with the expected width and height
+static int check(GVC_t *gvc, const char *path, const char *expected) {
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agnode_t *n = agnode(g, "n", 1);
+  agsafeset(n, "shape", "box", "");
+  agsafeset(n, "label", "", "");
+  agsafeset(n, "image", (char *)path, "");
+
+  if (gvLayout(gvc, g, "dot") != 0) {
+    fprintf(stderr, "layout failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  char *output;
+  unsigned int length;
+  gvRenderData(gvc, g, "svg", &output, &length);
+  int found = strstr(output, expected) != NULL;
+  if (!found)
+    fprintf(stderr, "expected %s in:\n%s\n", expected, output);
+
+  gvFreeRenderData(output);
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  return found;
+}
+
+int main(int argc, char **argv) {
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s image.svg\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  GVC_t *gvc = gvContext();
+
+  write_image(argv[1], 8, 6);
+  if (!check(gvc, argv[1], "width=\"8px\" height=\"6px\""))
+    return EXIT_FAILURE;
+
+  // a different size also changes the file's length, so the change is seen
+  // even where modification times are only kept to the second
+  write_image(argv[1], 40, 30);
+  if (!check(gvc, argv[1], "width=\"40px\" height=\"30px\""))
+    return EXIT_FAILURE;
+
+  gvFreeContext(gvc);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+// check that the compact and binary xdot parsers agree with parseXDot
+
+#include <graphviz/xdot.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(void) {
+
+  // read all of stdin into a string
+  char *in = NULL;
+  size_t off = 0;
+  size_t sz = 0;
+  do {
+    if (sz - off < BUFSIZ) {
+      sz = sz == 0 ? 2 * BUFSIZ : 2 * sz;
+      char *i = realloc(in, sz);
+      if (i == NULL) {
+        fprintf(stderr, "out of memory\n");
+        free(in);
+        return EXIT_FAILURE;
+      }
+      in = i;
+    }
+    off += fread(in + off, 1, sz - off - 1, stdin);
+  } while (!feof(stdin) && !ferror(stdin));
+  in[off] = '\0';
+
+  xdot *x = parseXDot(in);
+  xdot *compact = parseXDotCompact(in, NULL, 0);
+  free(in);
+  if (x == NULL || compact == NULL) {
+    fprintf(stderr, "failed to parse input into xdot\n");
+    return EXIT_FAILURE;
+  }
+
+  size_t len;
+  unsigned char *bin = sprintXDotBinary(x, &len);
+  xdot *binary = parseXDotBinary(bin, len, NULL, 0);
+  if (binary == NULL) {
+    fprintf(stderr, "failed to parse binary xdot\n");
+    return EXIT_FAILURE;
+  }
+
+  // a truncated binary form should give the ops before the cut and an error
+  xdot *truncated = parseXDotBinary(bin, len - 1, NULL, 0);
+  if (x->cnt > 1 && (truncated == NULL || truncated->cnt != x->cnt - 1 ||
+                     !(truncated->flags & XDOT_PARSE_ERROR))) {
+    fprintf(stderr, "truncated binary xdot not detected\n");
+    return EXIT_FAILURE;
+  }
+  free(bin);
+
+  char *expected = sprintXDot(x);
+  char *from_compact = sprintXDot(compact);
+  char *from_binary = sprintXDot(binary);
+
+  int rc = EXIT_SUCCESS;
+  if (strcmp(expected, from_compact) != 0) {
+    fprintf(stderr, "compact parse differs:\n%s\n%s\n", expected, from_compact);
+    rc = EXIT_FAILURE;
+  }
+  if (strcmp(expected, from_binary) != 0) {
+    fprintf(stderr, "binary round trip differs:\n%s\n%s\n", expected,
+            from_binary);
+    rc = EXIT_FAILURE;
+  }
+  if (x->flags != (compact->flags & ~XDOT_COMPACT)) {
+    fprintf(stderr, "flags differ: %d vs %d\n", x->flags, compact->flags);
+    rc = EXIT_FAILURE;
+  }
+  printf("%s\n", expected);
+
+  free(expected);
+  free(from_compact);
+  free(from_binary);
+  freeXDot(x);
+  freeXDot(compact);
+  freeXDot(binary);
+  if (truncated != NULL)
+    freeXDot(truncated);
+
+  return rc;
+}